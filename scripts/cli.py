@@ -1,6 +1,7 @@
 #!/usr/bin/env python3
 import asyncio
 import glob
+import json
 import sys
 import time
 from pathlib import Path
@@ -12,6 +13,15 @@ from serial.tools import list_ports
 sys.path.insert(0, str(Path(__file__).parent))
 
 from squid import SquidClient, MotorParams, SquidError
+from squid.motor import MotionProfile, ProfileRef, LinearAxis
+from squid.symbols import load_symbols
+from squid.trace import to_chrome_trace
+from squid.logfmt import load_formats, format_records
+from squid.sequence import assemble
+from squid.segments import Segment, plan_segments
+from squid.step_ramp import step_timing, ideal_seconds
+from squid.velocity import frame_rate_limit
+from squid.protocol import ErrorCode, SeqResult, VelocityResult
 
 
 def find_ftdi_port() -> Optional[str]:
@@ -85,6 +95,233 @@ def status(ctx):
         sys.exit(1)
 
 
+@cli.command()
+@click.pass_context
+def stats(ctx):
+    async def _stats():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            s = await client.get_stats()
+            click.echo(f"Stack:       {s.stack_high_water}/{s.stack_size} B ({s.stack_headroom} B free)")
+            click.echo(f"Static RAM:  {s.static_ram} B")
+            click.echo(f"Heap:        {s.heap_used} B")
+            click.echo(f"CCM RAM:     {s.ccm_used} B")
+            click.echo(f"Parser:      {s.parser_size} B")
+            click.echo(f"UART DMA:    {s.uart_dma_size} B")
+            click.echo(f"TX frame:    {s.tx_frame_size} B")
+            click.echo(f"Motors:      {s.motor_driver_size} B")
+            click.echo(f"XOR/CRC-256: {s.xor_cycles}/{s.crc_cycles} cycles")
+            if s.shift_refresh_max_cycles:
+                click.echo(f"74HC595:     {s.shift_refresh_cycles} cycles last, {s.shift_refresh_max_cycles} max")
+
+    try:
+        run_async(_stats())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("boot-info")
+@click.pass_context
+def boot_info(ctx):
+    async def _boot_info():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            info = await client.get_boot_info()
+            causes = ", ".join(info.reset_causes) or "unknown"
+            click.echo(f"Reset cause: {causes}")
+            click.echo(f"RX armed:    {info.rx_armed_us / 1000:.3f} ms")
+            click.echo(f"Ready:       {info.ready_us / 1000:.3f} ms")
+            click.echo(f"First RX:    {info.first_rx_us / 1000:.3f} ms")
+
+    try:
+        run_async(_boot_info())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command()
+@click.option("--period", "-t", default=100, help="Telemetry period in ms (0 - on change only)")
+@click.pass_context
+def watch(ctx, period: int):
+    async def _watch():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            accepted, _ = await client.subscribe(period, on_change=True)
+            click.echo(f"Subscribed: period {accepted} ms, on change")
+            try:
+                async for t in client.telemetry():
+                    elapsed = " ".join(f"{ms:5d}" for ms in t.elapsed_ms)
+                    click.echo(f"[{t.ticks_ms / 1000:10.3f}] #{t.sequence:5d} active=0x{t.active:03X} "
+                               f"completed=0x{t.completed:03X} pins=0x{t.status_pins:03X} "
+                               f"dropped={t.dropped} ms: {elapsed}")
+            finally:
+                await client.unsubscribe()
+
+    try:
+        run_async(_watch())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+    except KeyboardInterrupt:
+        pass
+
+
+@cli.command("wait-event")
+@click.option("--mask", "-m", default="0x3FF", help="Motor mask (bit 0 - motor 1)")
+@click.option("--timeout", "-t", default=30000, type=click.IntRange(0, 65535), help="Timeout in ms")
+@click.pass_context
+def wait_event(ctx, mask: str, timeout: int):
+    async def _wait_event():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            t0 = time.perf_counter()
+            event = await client.wait_event(int(mask, 0), timeout)
+            elapsed = time.perf_counter() - t0
+
+        if event.timed_out:
+            click.echo(f"Timeout after {elapsed:.3f} s (completed=0x{event.completed:03X})")
+        else:
+            click.echo(f"Event after {elapsed:.3f} s: fired=0x{event.fired:03X} faulted=0x{event.faulted:03X}")
+
+    try:
+        run_async(_wait_event())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("link-stats")
+@click.option("--clear", is_flag=True, help="Reset counters after reading")
+@click.pass_context
+def link_stats(ctx, clear: bool):
+    async def _link_stats():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            s = await client.get_link_stats()
+            if clear:
+                await client.clear_link_stats()
+
+        click.echo(f"Baudrate:      {s.baudrate}")
+        click.echo(f"UART ORE/FE/NE: {s.uart_overrun}/{s.uart_framing}/{s.uart_noise}")
+        click.echo(f"DMA RX TE/DME/FE: {s.dma_rx_transfer}/{s.dma_rx_direct}/{s.dma_rx_fifo}")
+        click.echo(f"DMA TX TE:     {s.dma_tx_transfer}")
+        click.echo(f"RX overflow:   {s.rx_ring_overflow} (restarts {s.rx_restarts})")
+        click.echo(f"Frames OK:     {s.accepted_frames}")
+        click.echo(f"Rejected:      length {s.length_errors}, xor {s.xor_errors}, "
+                   f"crc {s.crc_errors}, timeout {s.aborted_frames} (resync {s.resynced_frames})")
+        click.echo("Link clean" if s.is_clean else "Link has errors")
+
+    try:
+        run_async(_link_stats())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command()
+@click.option("--clock", default=16_000_000, type=int, help="Core clock, Hz")
+@click.pass_context
+def profile(ctx, clock: int):
+    async def _profile():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            entries = await client.get_profile()
+            click.echo(f"{'section':<24}{'count':>10}{'min':>10}{'avg':>10}{'max':>10}{'total ms':>12}")
+            for e in entries:
+                if e.count == 0:
+                    continue
+                total_ms = e.total_cycles * 1000 / clock
+                click.echo(
+                    f"{e.name:<24}{e.count:>10}{e.min_cycles:>10}{e.avg_cycles:>10.0f}"
+                    f"{e.max_cycles:>10}{total_ms:>12.3f}"
+                )
+
+    try:
+        run_async(_profile())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command()
+@click.option("--duration", "-d", default=5.0, type=float, help="Sampling time in seconds")
+@click.option("--hz", default=1000, type=int, help="Sampling rate (16-10000 Hz)")
+@click.option("--symbols", "symbols_path", default=None, help="main.map or main.elf for symbol names")
+@click.option("--top", default=20, type=int, help="Rows to show")
+@click.pass_context
+def samples(ctx, duration: float, hz: int, symbols_path: Optional[str], top: int):
+    async def _samples():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            await client.clear_samples()
+            await client.start_sampling(hz)
+            await asyncio.sleep(duration)
+            await client.stop_sampling()
+            histogram = await client.read_samples()
+
+        click.echo(f"Samples: {histogram.total_samples} (bucket {1 << histogram.shift} B)")
+        if histogram.total_samples == 0:
+            return
+        if symbols_path:
+            rows = load_symbols(symbols_path).attribute(histogram)
+        else:
+            rows = [(f"0x{histogram.bucket_address(i):08x}", n) for i, n in histogram.buckets.items()]
+            rows.sort(key=lambda row: row[1], reverse=True)
+        for name, hits in rows[:top]:
+            click.echo(f"{hits * 100 / histogram.total_samples:6.2f}%  {hits:>8}  {name}")
+
+    try:
+        run_async(_samples())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command()
+@click.option("--out", "-o", default="trace.json", help="Chrome trace JSON file")
+@click.pass_context
+def trace(ctx, out: str):
+    async def _trace():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            page = await client.read_trace()
+
+        Path(out).write_text(json.dumps(to_chrome_trace(page.records, page.clock_hz or 16_000_000)))
+        transactions = len({r.txn for r in page.records})
+        click.echo(f"{len(page.records)} records, {transactions} transactions -> {out}")
+        if page.dropped:
+            click.echo(f"Warning: {page.dropped} records overwritten before readout", err=True)
+
+    try:
+        run_async(_trace())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command()
+@click.option("--elf", "-e", default="main.elf", help="Firmware ELF with the .log_fmt section")
+@click.option("--follow", "-f", is_flag=True, help="Keep polling the log")
+@click.option("--interval", default=0.5, help="Polling interval in seconds for --follow")
+@click.pass_context
+def log(ctx, elf: str, follow: bool, interval: float):
+    formats = load_formats(elf)
+
+    async def _log():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            while True:
+                page = await client.read_log()
+                if page.dropped:
+                    click.echo(f"Warning: {page.dropped} records overwritten before readout", err=True)
+                for ticks, text in format_records(page.records, formats):
+                    click.echo(f"[{ticks / 1000:10.3f}] {text}")
+                if not follow:
+                    return
+                await asyncio.sleep(interval)
+
+    try:
+        run_async(_log())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+    except KeyboardInterrupt:
+        pass
+
+
 @cli.command()
 @click.pass_context
 def stop(ctx):
@@ -137,9 +374,10 @@ def move(ctx, motor: int, steps: int, speed: int, accel: int, async_mode: bool,
 @cli.command()
 @click.argument("motors", nargs=-1, type=str)
 @click.option("--async", "async_mode", is_flag=True, help="Use async mode")
+@click.option("--compact", is_flag=True, help="Send as COMPACT_MOVE (varint fields)")
 @click.option("--timeout", "-t", default=300, type=float, help="Timeout in seconds")
 @click.pass_context
-def multi_move(ctx, motors: tuple, async_mode: bool, timeout: float):
+def multi_move(ctx, motors: tuple, async_mode: bool, compact: bool, timeout: float):
     async def _multi_move():
         params_list = []
         for m in motors:
@@ -153,7 +391,9 @@ def multi_move(ctx, motors: tuple, async_mode: bool, timeout: float):
 
         async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
             t0 = time.perf_counter()
-            if async_mode:
+            if compact:
+                result = await client.compact_move(params_list, sync=not async_mode, timeout=timeout)
+            elif async_mode:
                 result = await client.async_move(params_list, timeout=timeout)
             else:
                 result = await client.sync_move(params_list, timeout=timeout)
@@ -171,5 +411,307 @@ def multi_move(ctx, motors: tuple, async_mode: bool, timeout: float):
         sys.exit(1)
 
 
+@cli.command()
+@click.pass_context
+def profiles(ctx):
+    async def _profiles():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            table = await client.read_profiles()
+            info = await client.profile_store_info()
+
+        for p in table:
+            click.echo(f"{p.id:3d}: accel={p.acceleration} speed={p.max_speed} steps={p.steps}")
+        click.echo(f"{info.count} profiles, flash gen {info.generation}: "
+                   f"{info.used_slots} records used, {info.free_slots} free")
+
+    try:
+        run_async(_profiles())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("profile-set")
+@click.argument("profile_id", type=int)
+@click.option("--steps", "-s", required=True, type=int, help="Number of steps")
+@click.option("--speed", default=1000, type=int, help="Max speed")
+@click.option("--accel", default=500, type=int, help="Acceleration")
+@click.pass_context
+def profile_set(ctx, profile_id: int, steps: int, speed: int, accel: int):
+    async def _profile_set():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            await client.set_profile(MotionProfile(profile_id, accel, speed, steps))
+        click.echo(f"Profile {profile_id} stored")
+
+    try:
+        run_async(_profile_set())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("profile-delete")
+@click.argument("profile_id", type=int)
+@click.pass_context
+def profile_delete(ctx, profile_id: int):
+    async def _profile_delete():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            await client.delete_profile(profile_id)
+        click.echo(f"Profile {profile_id} deleted")
+
+    try:
+        run_async(_profile_delete())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("profile-move")
+@click.argument("refs", nargs=-1, type=str)
+@click.option("--sync", "sync_mode", is_flag=True, help="Wait for completion")
+@click.option("--timeout", "-t", default=300, type=float, help="Timeout in seconds")
+@click.pass_context
+def profile_move(ctx, refs: tuple, sync_mode: bool, timeout: float):
+    async def _profile_move():
+        ref_list = []
+        for r in refs:
+            parts = r.split(":")
+            if len(parts) not in (2, 3) or (len(parts) == 3 and parts[2] != "r"):
+                click.echo(f"Invalid format: {r}. Use motor:profile[:r]", err=True)
+                return
+            ref_list.append(ProfileRef(int(parts[0]), int(parts[1]), reverse=len(parts) == 3))
+
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            t0 = time.perf_counter()
+            result = await client.profile_move(ref_list, sync=sync_mode, timeout=timeout)
+            elapsed = time.perf_counter() - t0
+
+            if result:
+                verb = "completed" if sync_mode else "started"
+                click.echo(f"Profile move {verb}: {len(ref_list)} motors ({elapsed:.3f} s)")
+            else:
+                click.echo(f"Profile move failed ({elapsed:.3f} s)", err=True)
+
+    try:
+        run_async(_profile_move())
+    except (SquidError, ValueError) as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("linear-move")
+@click.argument("axes", nargs=-1, type=str)
+@click.option("--accel", "-a", required=True, type=int, help="Path acceleration, steps/s^2")
+@click.option("--speed", "-s", required=True, type=int, help="Path speed, steps/s")
+@click.option("--async", "async_mode", is_flag=True, help="Do not wait for completion")
+@click.option("--timeout", "-t", default=300, type=float, help="Timeout in seconds")
+@click.pass_context
+def linear_move(ctx, axes: tuple, accel: int, speed: int, async_mode: bool, timeout: float):
+    async def _linear_move():
+        axis_list = []
+        for a in axes:
+            parts = a.split(":")
+            if len(parts) != 2:
+                click.echo(f"Invalid format: {a}. Use motor:steps", err=True)
+                return
+            axis_list.append(LinearAxis(int(parts[0]), int(parts[1])))
+
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            t0 = time.perf_counter()
+            result = await client.linear_move(axis_list, accel, speed, sync=not async_mode, timeout=timeout)
+            elapsed = time.perf_counter() - t0
+
+            if result:
+                verb = "started" if async_mode else "completed"
+                click.echo(f"Linear move {verb}: {len(axis_list)} axes ({elapsed:.3f} s)")
+            else:
+                click.echo(f"Linear move failed ({elapsed:.3f} s)", err=True)
+
+    try:
+        run_async(_linear_move())
+    except (SquidError, ValueError) as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("segment-move")
+@click.argument("motor", type=int)
+@click.argument("segments", nargs=-1, type=str)
+@click.option("--plan-only", is_flag=True, help="Show the MCU merge plan without moving")
+@click.option("--timeout", "-t", default=300, type=float, help="Timeout in seconds")
+@click.pass_context
+def segment_move(ctx, motor: int, segments: tuple, plan_only: bool, timeout: float):
+    async def _segment_move():
+        seg_list = []
+        for s in segments:
+            parts = s.split(":")
+            if len(parts) != 3:
+                click.echo(f"Invalid format: {s}. Use accel:speed:steps", err=True)
+                return
+            seg_list.append(Segment(int(parts[0]), int(parts[1]), int(parts[2])))
+
+        if plan_only:
+            plan = plan_segments(motor, seg_list)
+            for c in plan.commands:
+                steps = c.steps - (1 << 32) if c.steps >= (1 << 31) else c.steps
+                click.echo(f"  {c.acceleration}:{c.max_speed}:{steps}")
+            click.echo(f"{len(seg_list)} segments -> {len(plan.commands)} commands, "
+                       f"{plan.standalone_ms} -> {plan.planned_ms} ms")
+            return
+
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            r = await client.segment_move(motor, seg_list, timeout=timeout)
+
+        click.echo(f"Segments: {r.segments} -> {r.commands} commands ({r.result.name})")
+        click.echo(f"Estimate: {r.standalone_ms} ms standalone, {r.planned_ms} ms merged "
+                   f"(saved {r.saved_ms} ms)")
+        click.echo(f"Elapsed:  {r.elapsed_ms} ms")
+
+    try:
+        run_async(_segment_move())
+    except (SquidError, ValueError) as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("step-ramp")
+@click.argument("steps", type=int)
+@click.option("--accel", "-a", required=True, type=int, help="Acceleration, steps/s^2")
+@click.option("--speed", "-s", required=True, type=int, help="Max speed, steps/s")
+def step_ramp(steps: int, accel: int, speed: int):
+    """Model the STEP/DIR timer pulses of one move (no board needed)."""
+    try:
+        t = step_timing(steps, accel, speed)
+    except ValueError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+    click.echo(f"Steps:     {t.steps} at up to {t.speed} steps/s, timer divider {t.divider}")
+    click.echo(f"Time:      {t.seconds * 1000:.1f} ms (trapezoid {ideal_seconds(t.steps, accel, t.speed) * 1000:.1f} ms)")
+    if t.periods:
+        click.echo(f"Max rate:  {t.max_rate_hz:.0f} Hz, first period {t.periods[0]} ticks")
+    if t.cruise_rate_hz:
+        click.echo(f"Cruise:    {t.cruise_rate_hz:.1f} Hz, jitter {t.cruise_jitter_ns:.1f} ns")
+    click.echo(f"DMA IRQs:  {t.dma_interrupts}")
+
+
+@cli.command("velocity-stream")
+@click.argument("setpoints", nargs=-1, required=True, type=str)
+@click.option("--rate", "-r", default=500, type=int, help="Frames per second")
+@click.option("--duration", "-d", default=2.0, type=float, help="Streaming time in seconds")
+@click.option("--accel", "-a", default=20000, type=int, help="Slew and ramp-down acceleration, steps/s^2")
+@click.option("--timeout", "-t", default=50, type=int, help="Watchdog timeout in ms")
+@click.pass_context
+def velocity_stream(ctx, setpoints: tuple, rate: int, duration: float, accel: int, timeout: int):
+    """Stream constant velocity setpoints (motor:steps_per_s) and report frame timing."""
+    async def _velocity_stream():
+        velocities = {}
+        for sp in setpoints:
+            parts = sp.split(":")
+            if len(parts) != 2:
+                click.echo(f"Invalid format: {sp}. Use motor:velocity", err=True)
+                return
+            velocities[int(parts[0])] = int(parts[1])
+
+        limit = frame_rate_limit(len(velocities), ctx.obj["baudrate"])
+        if rate > limit:
+            click.echo(f"Warning: {len(velocities)} axes fit {limit:.0f} frames/s on the link", err=True)
+
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            result = await client.velocity_start(1000000 // rate, timeout, accel)
+            if result != VelocityResult.OK:
+                click.echo(f"Start failed: {result.name}", err=True)
+                return
+
+            loop = asyncio.get_running_loop()
+            start = loop.time()
+            frames = int(duration * rate)
+            for seq in range(frames):
+                await client.velocity_set(seq, velocities)
+                await asyncio.sleep(max(0.0, start + (seq + 1) / rate - loop.time()))
+
+            s = await client.velocity_stats()
+            await client.velocity_stop()
+
+        click.echo(f"Frames:  {s.frames}/{frames} accepted, {s.late} late, {s.lost} lost")
+        click.echo(f"Jitter:  mean {s.mean_jitter_us} us, max {s.max_jitter_us} us "
+                   f"(last interval {s.last_interval_us} us)")
+        click.echo(f"Watchdog trips: {s.watchdog_trips}")
+        if s.rejected:
+            click.echo(f"Rejected: {s.rejected}, last {ErrorCode(s.last_error).name}"
+                       f" (fault {s.last_fault}, value {s.last_index})")
+        for motor, v in s.velocities.items():
+            click.echo(f"  motor {motor}: {v} steps/s")
+
+    try:
+        run_async(_velocity_stream())
+    except (SquidError, ValueError) as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("seq-run")
+@click.argument("program", type=click.Path(exists=True, dir_okay=False))
+@click.pass_context
+def seq_run(ctx, program: str):
+    async def _seq_run():
+        code = assemble(Path(program).read_text())
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            await client.load_sequence(code)
+            result, pc = await client.run_sequence()
+
+        if result == SeqResult.OK:
+            click.echo(f"Sequence started: {len(code)} bytes")
+        elif result == SeqResult.INVALID:
+            click.echo(f"Sequence rejected at offset {pc}", err=True)
+            sys.exit(1)
+        else:
+            click.echo(f"Sequence not started: {result.name}", err=True)
+            sys.exit(1)
+
+    try:
+        run_async(_seq_run())
+    except (SquidError, ValueError) as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("seq-status")
+@click.pass_context
+def seq_status(ctx):
+    async def _seq_status():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            st = await client.sequence_status()
+
+        click.echo(f"State:   {st.state.name} ({st.reason.name})")
+        click.echo(f"PC:      {st.pc} / {st.length} bytes, {st.steps} steps in {st.run_ms} ms")
+        click.echo(f"Step:    pc {st.step_pc} for {st.step_ms} ms")
+        click.echo(f"Last:    pc {st.last_pc}, {st.last_ms} ms")
+        click.echo(f"Longest: pc {st.max_pc}, {st.max_ms} ms")
+        if st.loop_remaining:
+            click.echo(f"Loop:    {st.loop_remaining} passes left")
+
+    try:
+        run_async(_seq_status())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
+@cli.command("seq-stop")
+@click.pass_context
+def seq_stop(ctx):
+    async def _seq_stop():
+        async with SquidClient(ctx.obj["port"], ctx.obj["baudrate"]) as client:
+            stopped = await client.stop_sequence()
+        click.echo("Sequence stopped" if stopped else "Sequence was not running")
+
+    try:
+        run_async(_seq_stop())
+    except SquidError as e:
+        click.echo(f"Error: {e}", err=True)
+        sys.exit(1)
+
+
 if __name__ == "__main__":
     cli()
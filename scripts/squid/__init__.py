@@ -1,5 +1,6 @@
 from .client import SquidClient
-from .motor import MotorParams
+from .motor import MotorParams, Telemetry
+from .diagnostics import MemoryStats, BootInfo
 from .errors import SquidError, TimeoutError, ChecksumError, ProtocolError
 
-__all__ = ["SquidClient", "MotorParams", "SquidError", "TimeoutError", "ChecksumError", "ProtocolError"]
+__all__ = ["SquidClient", "MotorParams", "Telemetry", "SquidError", "TimeoutError", "ChecksumError", "ProtocolError"]
@@ -1,20 +1,89 @@
-from typing import Optional
+import asyncio
+import struct
+from collections import deque
+from typing import AsyncIterator, Optional
 
 from .transport import AsyncSerialTransport
 from .packet import Packet
-from .protocol import Command, Response, ErrorCode
-from .motor import MotorParams
-from .errors import ProtocolError
+from .protocol import (
+    Command, Response, ErrorCode, SessionFlag, TelemetryFlag, SampleOp, TraceOp, LogOp, LinkStatsOp,
+    SeqOp, SeqResult, ProfileOp, ProfileResult, MoveMode, VelocityOp, VelocityResult, RETRYABLE_ERRORS,
+)
+from .motor import (
+    MotorParams, Telemetry, WaitEvent, CompactEncoder, ProfileRef, MotionProfile, ProfileStoreInfo, LinearAxis,
+    pack_mask, unpack_masks, parse_profile_page, MOTION_PROFILE_COUNT,
+)
+from .sequence import SequenceStatus, SEQUENCE_CHUNK_SIZE
+from .segments import Segment, SegmentReport, SEGMENT_MAX
+from .velocity import VelocityStats, pack_velocity_frame
+from .trace import TracePage, parse_trace_page
+from .logfmt import LogPage, parse_log_page
+from .diagnostics import (
+    MemoryStats, BootInfo, LinkStats, ProfileEntry, PcHistogram, parse_profile, parse_sample_header,
+)
+from .errors import SquidError, ProtocolError, TimeoutError, ChecksumError
+
+# Кадр 256 байт на 115200 идет ~22 мс, плюс задержка FTDI (16 мс)
+ATTEMPT_TIMEOUT = 0.25
+MAX_RETRIES = 3
+# Кадры TELEMETRY, пришедшие между ответами на команды
+TELEMETRY_QUEUE_SIZE = 256
+# Хвост кадра, начатого до запроса: 256 байт - 22 мс на 115200
+DRAIN_TIMEOUT = 0.05
+# PROFILE_STORE SET/DELETE: перенос журнала стирает сектор flash (1-2 с)
+PROFILE_WRITE_TIMEOUT = 5.0
+# Пауза между кадрами сброса сессии: дольше межбайтового таймаута MCU (20 мс),
+# чтобы кадр в чужом формате не склеился со следующим
+SESSION_RESET_GAP = 0.05
+# Форматы, в которых могла остаться сессия прошлого процесса. COBS - дважды:
+# первый кадр может съесть мусор, накопленный парсером до разделителя
+SESSION_RESET_FRAMINGS = (
+    SessionFlag.COBS_FRAMING | SessionFlag.CRC32,
+    SessionFlag.COBS_FRAMING | SessionFlag.CRC32,
+    SessionFlag.COBS_FRAMING,
+    SessionFlag.COBS_FRAMING,
+    SessionFlag.CRC32,
+)
 
 
 class SquidClient:
-    def __init__(self, port: str, baudrate: int = 115200):
+    def __init__(
+        self,
+        port: str,
+        baudrate: int = 115200,
+        retries: int = MAX_RETRIES,
+        attempt_timeout: float = ATTEMPT_TIMEOUT,
+    ):
         self._transport = AsyncSerialTransport(port, baudrate)
+        self._retries = retries
+        self._attempt_timeout = attempt_timeout
+        self._telemetry: deque[Telemetry] = deque(maxlen=TELEMETRY_QUEUE_SIZE)
+        # Отложенный ответ WAIT_EVENT, пришедший вместо ответа на другую команду
+        self._wait_result: Optional[Packet] = None
+        self._compact = CompactEncoder()
 
     async def connect(self) -> None:
         await self._transport.connect()
+        await self._reset_session()
+
+    async def _reset_session(self) -> None:
+        """Сессия COBS/CRC на MCU переживает отключение хоста: SESSION 0
+        уходит во всех форматах без ожидания ответа, затем в классическом -
+        уже с ответом. Ответы и NAK в чужих форматах отбрасываются."""
+        for flags in SESSION_RESET_FRAMINGS:
+            self._transport.set_session(flags)
+            await self._transport.send_packet(Packet(Command.SESSION, bytes([SessionFlag.NONE])))
+            await asyncio.sleep(SESSION_RESET_GAP)
+        self._transport.set_session(SessionFlag.NONE)
+        await self._transport.discard_input()
+        await self.set_session(SessionFlag.NONE)
 
     async def disconnect(self) -> None:
+        if self._transport.session != SessionFlag.NONE:
+            try:
+                await self.set_session(SessionFlag.NONE)
+            except SquidError:
+                pass
         await self._transport.disconnect()
 
     async def __aenter__(self) -> "SquidClient":
@@ -25,17 +94,87 @@ class SquidClient:
         await self.disconnect()
 
     async def _send_and_receive(
-        self, command: int, data: bytes = b"", timeout: float = 5.0
+        self,
+        command: int,
+        data: bytes = b"",
+        timeout: float = 5.0,
+        idempotent: bool = True,
     ) -> Packet:
+        """Отправка команды с повтором.
+
+        Повторяются только идемпотентные команды: по таймауту, битому ответу и
+        NAK на битый кадр (RETRYABLE_ERRORS). Неидемпотентная команда (движение,
+        запись во flash) уходит один раз: любой сбой - исключение вызывающему,
+        который знает, можно ли ее повторить.
+        """
         packet = Packet(command, data)
-        await self._transport.send_packet(packet)
-        response = await self._transport.receive_packet(timeout)
+        expected = command | 0x80
+        attempt_timeout = min(timeout, self._attempt_timeout) if idempotent else timeout
+
+        for attempt in range(self._retries + 1):
+            last_attempt = attempt == self._retries
+            await self._drain_input()
+
+            await self._transport.send_packet(packet)
+            try:
+                response = await self._receive_response(timeout if last_attempt else attempt_timeout, expected)
+            except (TimeoutError, ChecksumError):
+                if last_attempt or not idempotent:
+                    raise
+                continue
+
+            if response.command == Response.ERROR:
+                error_code = response.data[0] if response.data else 0
+                if error_code in RETRYABLE_ERRORS and idempotent and not last_attempt:
+                    continue
+                if error_code == ErrorCode.MOTOR_PARAM_ERROR and len(response.data) >= 3:
+                    # Причина ParamFault и номер неверной записи кадра
+                    raise ProtocolError(error_code, self._error_message(error_code), response.data[1], response.data[2])
+                raise ProtocolError(error_code, self._error_message(error_code))
+
+            return response
+
+        raise TimeoutError("No response after retries")
 
-        if response.command == Response.ERROR:
-            error_code = response.data[0] if response.data else 0
-            raise ProtocolError(error_code, self._error_message(error_code))
+    async def _receive_response(self, timeout: float, expected: int = 0) -> Packet:
+        """Следующий кадр, кроме TELEMETRY (уходит в очередь telemetry()) и
+        отложенного WAIT_EVENT, если ждали ответ на другую команду."""
+        loop = asyncio.get_running_loop()
+        deadline = loop.time() + timeout
+        remaining = timeout
+        while True:
+            response = await self._transport.receive_packet(remaining)
+            if not self._route_unsolicited(response, expected):
+                return response
+            remaining = max(0.0, deadline - loop.time())
 
-        return response
+    async def _drain_input(self) -> None:
+        """Разобрать принятое до запроса: TELEMETRY - в очередь, отложенный
+        WAIT_EVENT - в _wait_result. Остальное - устаревшие ответы и NAK
+        (например, на шум в линии) - отбрасывается, иначе его приняли бы
+        за ответ на новую команду."""
+        while await self._transport.has_input():
+            try:
+                packet = await self._transport.receive_packet(DRAIN_TIMEOUT)
+            except (TimeoutError, ChecksumError):
+                continue  # Шум или битый кадр: байты уже прочитаны
+            self._route_unsolicited(packet)
+
+    def _route_unsolicited(self, packet: Packet, expected: int = 0) -> bool:
+        """TELEMETRY и чужой WAIT_EVENT - не ответ на команду; True - кадр сохранен."""
+        if packet.command == Response.TELEMETRY:
+            self._queue_telemetry(packet)
+            return True
+        if packet.command == Response.WAIT_EVENT and expected != Response.WAIT_EVENT:
+            self._wait_result = packet
+            return True
+        return False
+
+    def _queue_telemetry(self, packet: Packet) -> None:
+        try:
+            self._telemetry.append(Telemetry.from_bytes(packet.data))
+        except ValueError:
+            pass
 
     @staticmethod
     def _error_message(code: int) -> str:
@@ -45,8 +184,11 @@ class SquidClient:
             ErrorCode.XOR_CHECKSUM_ERROR: "XOR checksum error",
             ErrorCode.INVALID_MOTOR_COUNT: "Invalid motor count",
             ErrorCode.MOTOR_PARAM_ERROR: "Motor parameter validation error",
+            ErrorCode.FRAME_TIMEOUT: "Incomplete frame (inter-byte timeout)",
+            ErrorCode.CRC_CHECKSUM_ERROR: "CRC-32 checksum error",
             ErrorCode.EMERGENCY_STOP: "Emergency stop triggered",
             ErrorCode.TIMEOUT: "Timeout",
+            ErrorCode.STREAM_INACTIVE: "Velocity stream not started",
         }
         return messages.get(code, "Unknown error")
 
@@ -62,9 +204,8 @@ class SquidClient:
     async def get_status(self) -> tuple[int, int, int]:
         response = await self._send_and_receive(Command.STATUS)
         if len(response.data) >= 6:
-            active = response.data[0] | (response.data[1] << 8)
-            completed = response.data[2] | (response.data[3] << 8)
-            status_pins = response.data[4] | (response.data[5] << 8)
+            # Три маски шириной 2/4/8 байт - по BOARD_MAX_MOTORS прошивки
+            active, completed, status_pins = unpack_masks(response.data, 3)
         else:
             active = response.data[0] if len(response.data) > 0 else 0
             completed = response.data[1] if len(response.data) > 1 else 0
@@ -75,16 +216,301 @@ class SquidClient:
         response = await self._send_and_receive(Command.STOP)
         return response.data[0] == 0x00 if response.data else False
 
+    async def set_session(self, flags: SessionFlag) -> SessionFlag:
+        """Согласование формата кадров. Ответ приходит еще в старом формате."""
+        response = await self._send_and_receive(Command.SESSION, bytes([flags]))
+        accepted = SessionFlag(response.data[0]) if response.data else SessionFlag.NONE
+        self._transport.set_session(accepted)
+        return accepted
+
+    async def subscribe(self, period_ms: int, on_change: bool = True) -> tuple[int, TelemetryFlag]:
+        """Включить кадры TELEMETRY. period_ms=0 и on_change=False - выключить.
+
+        Возвращает принятые MCU период (не короче 10 мс) и флаги.
+        """
+        flags = TelemetryFlag.ON_CHANGE if on_change else TelemetryFlag.NONE
+        response = await self._send_and_receive(Command.SUBSCRIBE, struct.pack("<HB", period_ms, flags))
+        if len(response.data) < 3:
+            raise ProtocolError(0, "SUBSCRIBE response too short")
+        period, accepted = struct.unpack_from("<HB", response.data)
+        if period == 0 and not accepted:
+            self._telemetry.clear()
+        return period, TelemetryFlag(accepted)
+
+    async def unsubscribe(self) -> None:
+        await self.subscribe(0, on_change=False)
+
+    async def telemetry(self, timeout: float = 5.0) -> AsyncIterator[Telemetry]:
+        """Кадры TELEMETRY по мере прихода. Команды между итерациями допустимы:
+        пришедшие во время них кадры не теряются.
+
+        TimeoutError, если кадров нет дольше timeout.
+        """
+        while True:
+            while self._telemetry:
+                yield self._telemetry.popleft()
+            packet = await self._transport.receive_packet(timeout)
+            self._route_unsolicited(packet)
+
+    async def wait_event(self, mask: int, timeout_ms: int = 30000) -> WaitEvent:
+        """Ждать завершения (или аварии) любого мотора из mask, не опрашивая STATUS.
+
+        MCU отвечает по событию или через timeout_ms (не больше 65535).
+        Завершения, случившиеся до запроса, не теряются.
+        """
+        if self._wait_result is not None:
+            response, self._wait_result = self._wait_result, None
+            return WaitEvent.from_bytes(response.data)
+        data = pack_mask(mask) + struct.pack("<H", timeout_ms)
+        response = await self._send_and_receive(
+            Command.WAIT_EVENT, data, timeout_ms / 1000 + 1.0, idempotent=False
+        )
+        return WaitEvent.from_bytes(response.data)
+
+    async def get_stats(self) -> MemoryStats:
+        response = await self._send_and_receive(Command.STATS)
+        return MemoryStats.from_bytes(response.data)
+
+    async def get_boot_info(self) -> BootInfo:
+        response = await self._send_and_receive(Command.BOOT_INFO)
+        return BootInfo.from_bytes(response.data)
+
+    async def get_link_stats(self) -> LinkStats:
+        response = await self._send_and_receive(Command.LINK_STATS, bytes([LinkStatsOp.READ]))
+        return LinkStats.from_bytes(response.data)
+
+    async def clear_link_stats(self) -> None:
+        await self._send_and_receive(Command.LINK_STATS, bytes([LinkStatsOp.CLEAR]))
+
+    async def get_profile(self) -> list[ProfileEntry]:
+        """Таблица участков профилировщика. MCU сбрасывает ее после чтения."""
+        response = await self._send_and_receive(Command.PROFILE, idempotent=False)
+        return parse_profile(response.data)
+
+    async def start_sampling(self, hz: int = 0) -> None:
+        """Запуск PC-сэмплера на TIM7 (0 - частота по умолчанию, 1 кГц)."""
+        await self._send_and_receive(Command.SAMPLES, bytes([SampleOp.START]) + hz.to_bytes(2, "little"))
+
+    async def stop_sampling(self) -> None:
+        await self._send_and_receive(Command.SAMPLES, bytes([SampleOp.STOP]))
+
+    async def clear_samples(self) -> None:
+        await self._send_and_receive(Command.SAMPLES, bytes([SampleOp.CLEAR]))
+
+    async def read_samples(self) -> PcHistogram:
+        """Гистограмма постранично. Сэмплер лучше остановить заранее, иначе страницы разойдутся."""
+        pages = []
+        start = 0
+        while True:
+            request = bytes([SampleOp.READ]) + start.to_bytes(2, "little")
+            response = await self._send_and_receive(Command.SAMPLES, request)
+            pages.append(response.data)
+            _, _, bucket_count, _, _, next_index = parse_sample_header(response.data)
+            if next_index >= bucket_count or next_index <= start:
+                return PcHistogram.from_pages(pages)
+            start = next_index
+
+    async def read_trace(self) -> TracePage:
+        """Выгрузить кольцо трассировки целиком. Прочитанные записи MCU удаляет."""
+        page = TracePage(clock_hz=0, dropped=0, records=[])
+        while True:
+            response = await self._send_and_receive(Command.TRACE, bytes([TraceOp.READ]), idempotent=False)
+            chunk = parse_trace_page(response.data)
+            page.clock_hz = chunk.clock_hz
+            page.dropped += chunk.dropped
+            page.records.extend(chunk.records)
+            if not chunk.records:
+                return page
+
+    async def clear_trace(self) -> None:
+        await self._send_and_receive(Command.TRACE, bytes([TraceOp.CLEAR]))
+
+    async def read_log(self) -> LogPage:
+        """Выгрузить журнал целиком. Прочитанные записи MCU удаляет."""
+        page = LogPage(dropped=0, records=[])
+        while True:
+            response = await self._send_and_receive(Command.LOG, bytes([LogOp.READ]), idempotent=False)
+            chunk = parse_log_page(response.data)
+            page.dropped += chunk.dropped
+            page.records.extend(chunk.records)
+            if not chunk.records:
+                return page
+
+    async def clear_log(self) -> None:
+        await self._send_and_receive(Command.LOG, bytes([LogOp.CLEAR]))
+
     async def sync_move(
         self, motors: list[MotorParams], timeout: float = 300.0
     ) -> bool:
         data = b"".join(m.to_bytes() for m in motors)
-        response = await self._send_and_receive(Command.SYNC_MOVE, data, timeout)
+        response = await self._send_and_receive(Command.SYNC_MOVE, data, timeout, idempotent=False)
         return response.data[0] == 0x00 if response.data else False
 
     async def async_move(
         self, motors: list[MotorParams], timeout: float = 300.0
     ) -> bool:
         data = b"".join(m.to_bytes() for m in motors)
-        response = await self._send_and_receive(Command.ASYNC_MOVE, data, timeout)
+        response = await self._send_and_receive(Command.ASYNC_MOVE, data, timeout, idempotent=False)
+        return response.data[0] == 0x00 if response.data else False
+
+    async def profile_move(
+        self, refs: list[ProfileRef], sync: bool = False, timeout: float = 300.0
+    ) -> bool:
+        """Движение по профилям библиотеки MCU: 2 байта на мотор вместо 16."""
+        mode = MoveMode.SYNC if sync else MoveMode.ASYNC
+        data = bytes([mode]) + b"".join(r.to_bytes() for r in refs)
+        response = await self._send_and_receive(Command.PROFILE_MOVE, data, timeout, idempotent=False)
         return response.data[0] == 0x00 if response.data else False
+
+    async def compact_move(
+        self, motors: list[MotorParams], sync: bool = False, timeout: float = 300.0
+    ) -> bool:
+        """Движение в кодировке COMPACT_MOVE: varint-поля, неизменные с прошлого
+        COMPACT_MOVE параметры мотора не передаются.
+
+        Если MCU потерял кэш (сброс), он отвечает MOTOR_PARAM_ERROR, ничего не
+        запустив, - тогда кадр уходит повторно со всеми полями. Копия кэша для
+        моторов кадра сбрасывается до отправки: при потерянном ответе MCU мог
+        уже принять кадр, и следующий кадр передает их поля целиком.
+        """
+        mode = MoveMode.SYNC if sync else MoveMode.ASYNC
+        data = bytes([mode]) + self._compact.encode(motors)
+        partial = any(m.number in self._compact for m in motors)
+        self._compact.forget(motors)
+        try:
+            response = await self._send_and_receive(Command.COMPACT_MOVE, data, timeout, idempotent=False)
+        except ProtocolError as e:
+            if e.error_code != ErrorCode.MOTOR_PARAM_ERROR or not partial:
+                raise
+            self._compact.reset()
+            data = bytes([mode]) + self._compact.encode(motors)
+            response = await self._send_and_receive(Command.COMPACT_MOVE, data, timeout, idempotent=False)
+
+        ok = response.data[0] == 0x00 if response.data else False
+        if ok:
+            self._compact.commit(motors)
+        return ok
+
+    async def linear_move(
+        self, axes: list[LinearAxis], acceleration: int, speed: int,
+        sync: bool = True, timeout: float = 300.0,
+    ) -> bool:
+        """Согласованное движение: шаги по осям, ускорение и скорость - вдоль пути.
+
+        Ускорение и скорость каждой оси считает MCU (см. plan_linear), оси
+        приходят одновременно. 5 байт на ось вместо 16.
+        """
+        mode = MoveMode.SYNC if sync else MoveMode.ASYNC
+        data = struct.pack("<BII", mode, acceleration, speed) + b"".join(a.to_bytes() for a in axes)
+        response = await self._send_and_receive(Command.LINEAR_MOVE, data, timeout, idempotent=False)
+        return response.data[0] == 0x00 if response.data else False
+
+    async def segment_move(
+        self, motor: int, segments: list[Segment], timeout: float = 300.0
+    ) -> SegmentReport:
+        """Цепочка движений мотора одной командой. MCU сливает сегменты одного
+        направления в меньшее число трапеций и ждет завершения, как SYNC_MOVE.
+        """
+        if not 1 <= len(segments) <= SEGMENT_MAX:
+            raise ValueError(f"segment count {len(segments)} out of 1..{SEGMENT_MAX}")
+        data = bytes([motor]) + b"".join(s.to_bytes() for s in segments)
+        response = await self._send_and_receive(Command.SEGMENT_MOVE, data, timeout, idempotent=False)
+        return SegmentReport.from_bytes(response.data)
+
+    async def _velocity(self, op: VelocityOp, data: bytes = b"") -> bytes:
+        response = await self._send_and_receive(Command.VELOCITY, bytes([op]) + data)
+        if len(response.data) < 2 or response.data[0] != op:
+            raise ProtocolError(0, f"Bad VELOCITY response: {response.data.hex()}")
+        return response.data[1:]
+
+    async def velocity_start(self, period_us: int, timeout_ms: int, acceleration: int) -> VelocityResult:
+        """Включить потоковый режим скоростей (только STEP/DIR-моторы).
+
+        period_us - ожидаемый период кадров (от него счетчики опозданий),
+        timeout_ms - сторож: без кадров дольше оси тормозят до нуля с
+        acceleration. Повторный START меняет параметры идущего потока.
+        """
+        data = struct.pack("<HHI", period_us, timeout_ms, acceleration)
+        return VelocityResult((await self._velocity(VelocityOp.START, data))[0])
+
+    async def velocity_set(self, seq: int, velocities: dict[int, int]) -> None:
+        """Кадр уставок {мотор: шаг/с}. Ответа нет и на ошибку: отклоненный
+        кадр виден по rejected и last_error в velocity_stats()."""
+        await self._transport.send_packet(Packet(Command.VELOCITY_SET, pack_velocity_frame(seq, velocities)))
+
+    async def velocity_stop(self) -> None:
+        """Торможение до нуля с ускорением START, затем режим выключается."""
+        await self._velocity(VelocityOp.STOP)
+
+    async def velocity_stats(self) -> VelocityStats:
+        return VelocityStats.from_bytes((await self._velocity(VelocityOp.STATS))[1:])
+
+    async def _profile_store(self, op: ProfileOp, data: bytes = b"") -> bytes:
+        # Запись не повторяется по таймауту: стирание могло уже начаться
+        if op in (ProfileOp.SET, ProfileOp.DELETE):
+            response = await self._send_and_receive(
+                Command.PROFILE_STORE, bytes([op]) + data, PROFILE_WRITE_TIMEOUT, idempotent=False
+            )
+        else:
+            response = await self._send_and_receive(Command.PROFILE_STORE, bytes([op]) + data)
+        if len(response.data) < 2 or response.data[0] != op:
+            raise ProtocolError(0, "bad PROFILE_STORE response")
+        return response.data[1:]
+
+    async def set_profile(self, profile: MotionProfile) -> None:
+        """Записать профиль во flash MCU. Только без движения (иначе BUSY)."""
+        result = ProfileResult((await self._profile_store(ProfileOp.SET, profile.to_bytes()))[0])
+        if result != ProfileResult.OK:
+            raise ProtocolError(0, f"PROFILE_STORE SET {profile.id}: {result.name}")
+
+    async def delete_profile(self, profile_id: int) -> None:
+        result = ProfileResult((await self._profile_store(ProfileOp.DELETE, bytes([profile_id])))[0])
+        if result != ProfileResult.OK:
+            raise ProtocolError(0, f"PROFILE_STORE DELETE {profile_id}: {result.name}")
+
+    async def read_profiles(self) -> list[MotionProfile]:
+        profiles = []
+        start = 0
+        while start < MOTION_PROFILE_COUNT:
+            next_id, page = parse_profile_page(await self._profile_store(ProfileOp.READ, bytes([start])))
+            profiles.extend(page)
+            if next_id <= start:
+                break
+            start = next_id
+        return profiles
+
+    async def profile_store_info(self) -> ProfileStoreInfo:
+        return ProfileStoreInfo.from_bytes(await self._profile_store(ProfileOp.INFO))
+
+    async def _sequence(self, op: SeqOp, data: bytes = b"", idempotent: bool = True) -> bytes:
+        response = await self._send_and_receive(Command.SEQUENCE, bytes([op]) + data, idempotent=idempotent)
+        if len(response.data) < 2 or response.data[0] != op:
+            raise ProtocolError(0, "bad SEQUENCE response")
+        return response.data[1:]
+
+    async def load_sequence(self, program: bytes) -> None:
+        """Загрузить программу (CLEAR и LOAD кусками). Повтор куска безопасен:
+        он пишется по тому же смещению."""
+        result = SeqResult((await self._sequence(SeqOp.CLEAR))[0])
+        if result != SeqResult.OK:
+            raise ProtocolError(0, f"SEQUENCE CLEAR: {result.name}")
+        for offset in range(0, len(program), SEQUENCE_CHUNK_SIZE):
+            chunk = program[offset:offset + SEQUENCE_CHUNK_SIZE]
+            reply = await self._sequence(SeqOp.LOAD, struct.pack("<H", offset) + chunk)
+            result = SeqResult(reply[0])
+            if result != SeqResult.OK:
+                raise ProtocolError(0, f"SEQUENCE LOAD at {offset}: {result.name}")
+
+    async def run_sequence(self) -> tuple[SeqResult, int]:
+        """Проверить и запустить программу. Для INVALID - смещение неверной инструкции."""
+        reply = await self._sequence(SeqOp.RUN, idempotent=False)
+        if len(reply) < 3:
+            raise ProtocolError(0, "SEQUENCE RUN response too short")
+        return SeqResult(reply[0]), struct.unpack_from("<H", reply, 1)[0]
+
+    async def stop_sequence(self) -> bool:
+        """Остановить программу и моторы. True - программа шла."""
+        return (await self._sequence(SeqOp.STOP))[0] == 1
+
+    async def sequence_status(self) -> SequenceStatus:
+        return SequenceStatus.from_bytes(await self._sequence(SeqOp.STATUS))
@@ -0,0 +1,195 @@
+from dataclasses import dataclass
+import struct
+
+STATS_FORMAT = "<IIIIIHHHHIIII"
+STATS_SIZE = struct.calcsize(STATS_FORMAT)
+
+BOOT_INFO_FORMAT = "<IIIB"
+BOOT_INFO_SIZE = struct.calcsize(BOOT_INFO_FORMAT)
+
+LINK_STATS_FORMAT = "<16I"
+LINK_STATS_SIZE = struct.calcsize(LINK_STATS_FORMAT)
+
+# Порядок совпадает с enum ProfileSection в src/profiler.hpp
+PROFILE_SECTIONS = (
+    "parser_byte",
+    "rx_process",
+    "command",
+    "driver_idle",
+    "driver_checking_rx",
+    "driver_sending",
+    "driver_waiting_status",
+    "driver_complete",
+    "isr_dma_rx",
+    "isr_dma_tx",
+    "isr_uart",
+    "isr_systick",
+)
+PROFILE_ENTRY_FORMAT = "<IIIQ"
+PROFILE_ENTRY_SIZE = struct.calcsize(PROFILE_ENTRY_FORMAT)
+
+SAMPLE_PAGE_FORMAT = "<IBHIIH"
+SAMPLE_PAGE_HEADER_SIZE = struct.calcsize(SAMPLE_PAGE_FORMAT)
+
+# Биты RCC_CSR[31:24] - причина последнего сброса
+RESET_CAUSES = (
+    (0x80, "low-power"),
+    (0x40, "window watchdog"),
+    (0x20, "independent watchdog"),
+    (0x10, "software"),
+    (0x08, "power-on"),
+    (0x04, "pin"),
+    (0x02, "brown-out"),
+)
+
+
+@dataclass
+class MemoryStats:
+    """Ответ STATS: запас по RAM и размеры статических буферов (байты)."""
+    stack_size: int
+    stack_high_water: int
+    static_ram: int
+    heap_used: int
+    ccm_used: int
+    parser_size: int
+    uart_dma_size: int
+    tx_frame_size: int
+    motor_driver_size: int
+    xor_cycles: int
+    crc_cycles: int
+    shift_refresh_cycles: int      # Последнее обновление 74HC595, flush -> RCLK (0 без BOARD_SHIFT_OUT)
+    shift_refresh_max_cycles: int  # Худшее с запуска
+
+    @property
+    def stack_headroom(self) -> int:
+        return self.stack_size - self.stack_high_water
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "MemoryStats":
+        if len(data) < STATS_SIZE:
+            raise ValueError(f"STATS response too short: {len(data)} < {STATS_SIZE}")
+        return cls(*struct.unpack(STATS_FORMAT, data[:STATS_SIZE]))
+
+
+@dataclass
+class BootInfo:
+    """Ответ BOOT_INFO: время от сброса в микросекундах (0 - событие еще не было)."""
+    rx_armed_us: int
+    ready_us: int
+    first_rx_us: int
+    reset_flags: int
+
+    @property
+    def reset_causes(self) -> list[str]:
+        return [name for mask, name in RESET_CAUSES if self.reset_flags & mask]
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "BootInfo":
+        if len(data) < BOOT_INFO_SIZE:
+            raise ValueError(f"BOOT_INFO response too short: {len(data)} < {BOOT_INFO_SIZE}")
+        return cls(*struct.unpack(BOOT_INFO_FORMAT, data[:BOOT_INFO_SIZE]))
+
+
+@dataclass
+class LinkStats:
+    """Ответ LINK_STATS: ошибки UART4/DMA и отказы парсера с последнего сброса."""
+    baudrate: int
+    uart_overrun: int
+    uart_framing: int
+    uart_noise: int
+    dma_rx_transfer: int
+    dma_rx_direct: int
+    dma_rx_fifo: int
+    dma_tx_transfer: int
+    rx_ring_overflow: int
+    rx_restarts: int
+    accepted_frames: int
+    length_errors: int
+    xor_errors: int
+    crc_errors: int
+    aborted_frames: int
+    resynced_frames: int
+
+    @property
+    def hardware_errors(self) -> int:
+        return (self.uart_overrun + self.uart_framing + self.uart_noise + self.dma_rx_transfer
+                + self.dma_rx_direct + self.dma_rx_fifo + self.dma_tx_transfer + self.rx_ring_overflow)
+
+    @property
+    def rejected_frames(self) -> int:
+        return self.length_errors + self.xor_errors + self.crc_errors + self.aborted_frames
+
+    @property
+    def is_clean(self) -> bool:
+        return self.hardware_errors == 0 and self.rejected_frames == 0
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "LinkStats":
+        if len(data) < LINK_STATS_SIZE:
+            raise ValueError(f"LINK_STATS response too short: {len(data)} < {LINK_STATS_SIZE}")
+        return cls(*struct.unpack(LINK_STATS_FORMAT, data[:LINK_STATS_SIZE]))
+
+
+@dataclass
+class ProfileEntry:
+    """Участок PROFILE: такты DWT CYCCNT с прошлого чтения таблицы."""
+    name: str
+    count: int
+    min_cycles: int
+    max_cycles: int
+    total_cycles: int
+
+    @property
+    def avg_cycles(self) -> float:
+        return self.total_cycles / self.count if self.count else 0.0
+
+
+def parse_profile(data: bytes) -> list[ProfileEntry]:
+    if not data:
+        raise ValueError("PROFILE response is empty")
+    count = data[0]
+    if len(data) < 1 + count * PROFILE_ENTRY_SIZE:
+        raise ValueError(f"PROFILE response too short for {count} sections")
+
+    entries = []
+    for i in range(count):
+        offset = 1 + i * PROFILE_ENTRY_SIZE
+        fields = struct.unpack_from(PROFILE_ENTRY_FORMAT, data, offset)
+        name = PROFILE_SECTIONS[i] if i < len(PROFILE_SECTIONS) else f"section_{i}"
+        entries.append(ProfileEntry(name, *fields))
+    return entries
+
+
+@dataclass
+class PcHistogram:
+    """Гистограмма SAMPLES: корзина index покрывает [base + index << shift, +1 << shift)."""
+    base: int
+    shift: int
+    bucket_count: int
+    total_samples: int
+    out_of_range: int
+    buckets: dict[int, int]
+
+    def bucket_address(self, index: int) -> int:
+        return self.base + (index << self.shift)
+
+    @classmethod
+    def from_pages(cls, pages: list[bytes]) -> "PcHistogram":
+        histogram = None
+        for page in pages:
+            base, shift, count, total, outside, _ = parse_sample_header(page)
+            if histogram is None:
+                histogram = cls(base, shift, count, total, outside, {})
+            for offset in range(SAMPLE_PAGE_HEADER_SIZE, len(page) - 3, 4):
+                index, hits = struct.unpack_from("<HH", page, offset)
+                histogram.buckets[index] = hits
+        if histogram is None:
+            raise ValueError("No SAMPLES pages")
+        return histogram
+
+
+def parse_sample_header(page: bytes) -> tuple[int, int, int, int, int, int]:
+    """(base, shift, bucket_count, total, out_of_range, next_index)"""
+    if len(page) < SAMPLE_PAGE_HEADER_SIZE:
+        raise ValueError(f"SAMPLES page too short: {len(page)} < {SAMPLE_PAGE_HEADER_SIZE}")
+    return struct.unpack_from(SAMPLE_PAGE_FORMAT, page)
@@ -1,3 +1,6 @@
+from typing import Optional
+
+
 class SquidError(Exception):
     pass
 
@@ -11,6 +14,11 @@ class ChecksumError(SquidError):
 
 
 class ProtocolError(SquidError):
-    def __init__(self, error_code: int, message: str = ""):
+    def __init__(self, error_code: int, message: str = "", fault: int = 0, record_index: Optional[int] = None):
         self.error_code = error_code
+        # MOTOR_PARAM_ERROR: причина (ParamFault) и номер записи в кадре
+        self.fault = fault
+        self.record_index = record_index
+        if record_index is not None:
+            message = f"{message} (record {record_index}, reason 0x{fault:02X})"
         super().__init__(f"Protocol error 0x{error_code:02X}: {message}")
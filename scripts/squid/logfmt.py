@@ -0,0 +1,145 @@
+"""Разбор ответов LOG и форматирование записей по таблице форматов из main.elf.
+
+MCU хранит в кольце только ID формата и аргументы (src/log.hpp), сами строки
+лежат в неподгружаемой секции .log_fmt; ID - смещение строки в секции.
+"""
+
+from dataclasses import dataclass
+from pathlib import Path
+import re
+import struct
+
+LOG_HEADER_FORMAT = "<HB"
+LOG_HEADER_SIZE = struct.calcsize(LOG_HEADER_FORMAT)
+LOG_RECORD_FORMAT = "<IHB"
+LOG_RECORD_SIZE = struct.calcsize(LOG_RECORD_FORMAT)
+LOG_TEXT_ID = 0xFFFF
+LOG_FMT_SECTION = ".log_fmt"
+
+_SPEC = re.compile(r"%([-+ 0#]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diuxXoc%])")
+
+
+@dataclass
+class LogRecord:
+    ticks: int
+    format_id: int
+    args: list[int]
+    text: bytes = b""
+
+    @property
+    def is_text(self) -> bool:
+        return self.format_id == LOG_TEXT_ID
+
+
+@dataclass
+class LogPage:
+    dropped: int
+    records: list[LogRecord]
+
+
+def parse_log_page(data: bytes) -> LogPage:
+    if len(data) < LOG_HEADER_SIZE:
+        raise ValueError(f"LOG response too short: {len(data)} < {LOG_HEADER_SIZE}")
+    dropped, count = struct.unpack_from(LOG_HEADER_FORMAT, data)
+
+    records = []
+    offset = LOG_HEADER_SIZE
+    for _ in range(count):
+        if len(data) < offset + LOG_RECORD_SIZE:
+            raise ValueError(f"LOG response too short for {count} records")
+        ticks, format_id, n = struct.unpack_from(LOG_RECORD_FORMAT, data, offset)
+        offset += LOG_RECORD_SIZE
+        size = n if format_id == LOG_TEXT_ID else n * 4
+        if len(data) < offset + size:
+            raise ValueError(f"LOG response too short for {count} records")
+        payload = data[offset:offset + size]
+        offset += size
+        if format_id == LOG_TEXT_ID:
+            records.append(LogRecord(ticks, format_id, [], payload))
+        else:
+            records.append(LogRecord(ticks, format_id, list(struct.unpack(f"<{n}I", payload))))
+    return LogPage(dropped, records)
+
+
+def read_elf_section(data: bytes, name: str) -> bytes:
+    """Содержимое секции ELF32 little-endian по имени (без зависимостей от binutils)."""
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError("not an ELF32 little-endian file")
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    def header(index):
+        return struct.unpack_from("<IIIIIIIIII", data, shoff + index * shentsize)
+
+    strtab = header(shstrndx)
+    names = data[strtab[4]:strtab[4] + strtab[5]]
+    for i in range(shnum):
+        sh_name, _, _, _, sh_offset, sh_size = header(i)[:6]
+        if names[sh_name:names.index(b"\0", sh_name)].decode() == name:
+            return data[sh_offset:sh_offset + sh_size]
+    raise ValueError(f"section {name} not found")
+
+
+def parse_format_table(section: bytes) -> dict[int, str]:
+    """Смещение -> строка формата для содержимого секции .log_fmt."""
+    table = {}
+    offset = 0
+    while offset < len(section):
+        end = section.find(b"\0", offset)
+        if end < 0:
+            end = len(section)
+        if end > offset:
+            table[offset] = section[offset:end].decode("utf-8", errors="replace")
+        offset = end + 1
+    return table
+
+
+def load_formats(path: str) -> dict[int, str]:
+    return parse_format_table(read_elf_section(Path(path).read_bytes(), LOG_FMT_SECTION))
+
+
+def format_message(fmt: str, args: list[int]) -> str:
+    """printf-подмножество: аргументы на MCU - u32, %d/%i трактуются как знаковые."""
+    values = iter(args)
+
+    def convert(match):
+        flags, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        value = next(values, 0)
+        if conversion in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            conversion = "d"
+        elif conversion == "c":
+            value = chr(value & 0xFF)
+        return f"%{flags}{conversion}" % value
+
+    return _SPEC.sub(convert, fmt)
+
+
+def format_records(records: list[LogRecord], formats: dict[int, str]) -> list[tuple[int, str]]:
+    """(мс, строка). Соседние TEXT-записи (trace_printf) склеиваются до перевода строки."""
+    lines = []
+    pending = b""
+    pending_ticks = 0
+    for record in records:
+        if record.is_text:
+            if not pending:
+                pending_ticks = record.ticks
+            pending += record.text
+            while b"\n" in pending:
+                line, pending = pending.split(b"\n", 1)
+                lines.append((pending_ticks, line.decode("utf-8", errors="replace").rstrip("\r")))
+                pending_ticks = record.ticks
+            continue
+
+        fmt = formats.get(record.format_id)
+        if fmt is None:
+            text = f"<fmt 0x{record.format_id:04x}> " + " ".join(f"0x{a:08x}" for a in record.args)
+        else:
+            text = format_message(fmt, record.args)
+        lines.append((record.ticks, text))
+
+    if pending:
+        lines.append((pending_ticks, pending.decode("utf-8", errors="replace")))
+    return lines
@@ -1,6 +1,54 @@
 from dataclasses import dataclass
+import math
 import struct
 
+from .packet import encode_varint
+from .protocol import WaitStatus
+
+MAX_MOTORS = 10
+
+# Ширина маски моторов в ответах зависит от BOARD_MAX_MOTORS прошивки:
+# до 16 моторов - 2 байта, до 32 - 4, до 64 - 8
+MASK_SIZES = (2, 4, 8)
+MASK_FORMATS = {2: "H", 4: "I", 8: "Q"}
+
+
+def mask_size(motor_count: int) -> int:
+    """Ширина маски для motor_count моторов, как MotorMask в прошивке."""
+    for size in MASK_SIZES:
+        if motor_count <= size * 8:
+            return size
+    raise ValueError(f"motor count {motor_count} exceeds 64")
+
+
+def pack_mask(mask: int) -> bytes:
+    """Маска запроса минимальной ширины: для моторов 1-16 - прежние 2 байта."""
+    if mask < 0 or mask >> 64:
+        raise ValueError(f"motor mask 0x{mask:X} out of range")
+    size = mask_size(mask.bit_length())
+    return struct.pack("<" + MASK_FORMATS[size], mask)
+
+
+def unpack_masks(data: bytes, count: int) -> tuple[int, ...]:
+    """count масок подряд, ширина - по длине data (len(data) == count * ширина)."""
+    size, rest = divmod(len(data), count)
+    if rest or size not in MASK_FORMATS:
+        raise ValueError(f"bad mask block length {len(data)} for {count} masks")
+    return struct.unpack("<" + MASK_FORMATS[size] * count, data)
+
+
+def telemetry_layout(length: int) -> tuple[int, int]:
+    """(ширина маски, число моторов) кадра TELEMETRY длиной length.
+
+    Кадр: 8 байт seq/ticks/dropped + 3 маски + 2 байта на мотор. Диапазоны
+    длин для разных ширин не пересекаются, так что разбор однозначен.
+    """
+    for size in MASK_SIZES:
+        motors, rest = divmod(length - 8 - 3 * size, 2)
+        if rest == 0 and 1 <= motors <= 64 and mask_size(motors) == size:
+            return size, motors
+    raise ValueError(f"bad TELEMETRY frame length {length}")
+
 
 @dataclass
 class MotorParams:
@@ -16,3 +64,216 @@ class MotorParams:
     def from_bytes(cls, data: bytes) -> "MotorParams":
         number, acceleration, max_speed, steps = struct.unpack("<IIII", data[:16])
         return cls(number=number, acceleration=acceleration, max_speed=max_speed, steps=steps)
+
+
+# Квадраты осей считаются по старшим 28 битам, как в LinearPlanner
+LINEAR_SQUARE_BITS = 28
+
+
+@dataclass
+class LinearAxis:
+    """Ось LINEAR_MOVE: только шаги, ускорение и скорость задаются для пути."""
+    motor: int
+    steps: int
+
+    def to_bytes(self) -> bytes:
+        if not 1 <= self.motor <= 64:
+            raise ValueError(f"motor number {self.motor} out of range")
+        return struct.pack("<Bi", self.motor, self.steps)
+
+
+def linear_path_length(axes: list[LinearAxis]) -> int:
+    """Длина пути в шагах, как ее считает MCU: isqrt суммы квадратов."""
+    magnitudes = [abs(a.steps) for a in axes]
+    longest = max(magnitudes, default=0)
+    shift = max(longest.bit_length() - LINEAR_SQUARE_BITS, 0)
+    length = math.isqrt(sum((m >> shift) ** 2 for m in magnitudes)) << shift
+    return min(max(length, longest), 0xFFFFFFFF)
+
+
+def plan_linear(axes: list[LinearAxis], acceleration: int, speed: int) -> list[MotorParams]:
+    """Записи, которые LINEAR_MOVE отдаст драйверам: копия LinearPlanner::plan().
+
+    Каждая ось получает долю |steps| / L ускорения и скорости пути - у всех
+    осей одна трапеция по времени.
+    """
+    if acceleration <= 0 or speed <= 0:
+        raise ValueError("path acceleration and speed must be positive")
+    length = linear_path_length(axes)
+
+    def share(value: int, magnitude: int) -> int:
+        if magnitude == 0 or length == 0:
+            return value
+        return max((value * magnitude + length // 2) // length, 1)
+
+    return [
+        MotorParams(
+            number=a.motor,
+            acceleration=share(acceleration, abs(a.steps)),
+            max_speed=share(speed, abs(a.steps)),
+            steps=a.steps & 0xFFFFFFFF,
+        )
+        for a in axes
+    ]
+
+
+# Биты поля header записи COMPACT_MOVE; номер мотора - 1 в старших битах
+COMPACT_ACCEL = 0x01
+COMPACT_SPEED = 0x02
+COMPACT_STEPS = 0x04
+COMPACT_FIELD_BITS = 3
+
+
+def zigzag(value: int) -> int:
+    """Знаковое int32 в беззнаковое: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ..."""
+    if not -(1 << 31) <= value < (1 << 31):
+        raise ValueError(f"steps {value} out of int32 range")
+    return ((value << 1) ^ (value >> 31)) & 0xFFFFFFFF
+
+
+def _compact_fields(m: MotorParams) -> tuple[int, int, int]:
+    # Шаги в MotorParams могут прийти и как uint32 (обратный знак в дополнительном коде)
+    steps = m.steps - (1 << 32) if m.steps >= (1 << 31) else m.steps
+    return m.acceleration, m.max_speed, zigzag(steps)
+
+
+class CompactEncoder:
+    """Кодер COMPACT_MOVE с копией кэша MCU.
+
+    Поле, равное последнему принятому MCU значению для этого мотора,
+    опускается: MCU подставит его сам. forget() - до отправки кадра: без
+    ответа неизвестно, обновил ли MCU кэш этих моторов. commit() - после
+    успешного ответа, reset() - если MCU мог потерять кэш (сброс).
+    """
+
+    def __init__(self):
+        self._cache: dict[int, tuple[int, int, int]] = {}
+
+    def encode(self, motors: list[MotorParams]) -> bytes:
+        out = bytearray()
+        for m in motors:
+            if not 1 <= m.number <= 64:
+                raise ValueError(f"motor number {m.number} out of range")
+            last = self._cache.get(m.number)
+            present = 0
+            body = bytearray()
+            bits = (COMPACT_ACCEL, COMPACT_SPEED, COMPACT_STEPS)
+            for i, value in enumerate(_compact_fields(m)):
+                if last is None or last[i] != value:
+                    present |= bits[i]
+                    body += encode_varint(value)
+            out += encode_varint(((m.number - 1) << COMPACT_FIELD_BITS) | present) + body
+        return bytes(out)
+
+    def commit(self, motors: list[MotorParams]) -> None:
+        for m in motors:
+            self._cache[m.number] = _compact_fields(m)
+
+    def forget(self, motors: list[MotorParams]) -> None:
+        for m in motors:
+            self._cache.pop(m.number, None)
+
+    def reset(self) -> None:
+        self._cache.clear()
+
+    def __contains__(self, number: int) -> bool:
+        return number in self._cache
+
+    def __len__(self) -> int:
+        return len(self._cache)
+
+
+@dataclass
+class Telemetry:
+    """Кадр TELEMETRY (после SUBSCRIBE): маски как в STATUS и время движения моторов."""
+    sequence: int
+    ticks_ms: int
+    active: int
+    completed: int
+    status_pins: int
+    dropped: int
+    elapsed_ms: list[int]
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "Telemetry":
+        size, motors = telemetry_layout(len(data))
+        mask = MASK_FORMATS[size]
+        fields = struct.unpack(f"<HI{mask * 3}H{motors}H", data)
+        return cls(*fields[:6], elapsed_ms=list(fields[6:]))
+
+
+@dataclass
+class WaitEvent:
+    """Ответ WAIT_EVENT: какие моторы из маски завершились (fired) и какие из них аварийно."""
+    status: WaitStatus
+    fired: int
+    faulted: int
+    active: int
+    completed: int
+
+    @property
+    def timed_out(self) -> bool:
+        return self.status == WaitStatus.TIMEOUT
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "WaitEvent":
+        if len(data) < 9:
+            raise ValueError(f"WAIT_EVENT response too short: {len(data)} < 9")
+        fired, faulted, active, completed = unpack_masks(data[1:], 4)
+        return cls(WaitStatus(data[0]), fired, faulted, active, completed)
+
+
+# Бит 7 номера мотора в PROFILE_MOVE: шаги профиля с обратным знаком
+PROFILE_REF_REVERSE = 0x80
+MOTION_PROFILE_COUNT = 64
+
+
+@dataclass
+class ProfileRef:
+    """Ссылка PROFILE_MOVE: мотор движется по профилю из библиотеки MCU."""
+    motor: int
+    profile: int
+    reverse: bool = False
+
+    def to_bytes(self) -> bytes:
+        if not 1 <= self.motor <= 64 or not 0 <= self.profile < MOTION_PROFILE_COUNT:
+            raise ValueError(f"bad profile reference {self.motor}:{self.profile}")
+        return bytes([self.motor | (PROFILE_REF_REVERSE if self.reverse else 0), self.profile])
+
+
+@dataclass
+class MotionProfile:
+    """Профиль движения в библиотеке MCU (PROFILE_STORE)."""
+    id: int
+    acceleration: int
+    max_speed: int
+    steps: int
+
+    def to_bytes(self) -> bytes:
+        return struct.pack("<BIIi", self.id, self.acceleration, self.max_speed, self.steps)
+
+
+def parse_profile_page(data: bytes) -> tuple[int, list[MotionProfile]]:
+    """Страница READ: (next, профили). next == 64 - таблица прочитана."""
+    if len(data) < 2:
+        raise ValueError(f"profile page too short: {len(data)} bytes")
+    next_id, count = data[0], data[1]
+    if len(data) < 2 + count * 13:
+        raise ValueError(f"profile page truncated: {count} entries in {len(data)} bytes")
+    profiles = [MotionProfile(*struct.unpack_from("<BIIi", data, 2 + i * 13)) for i in range(count)]
+    return next_id, profiles
+
+
+@dataclass
+class ProfileStoreInfo:
+    """INFO: поколение сектора, занятые/свободные записи журнала, число профилей."""
+    generation: int
+    used_slots: int
+    free_slots: int
+    count: int
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "ProfileStoreInfo":
+        if len(data) < 9:
+            raise ValueError(f"profile store info too short: {len(data)} bytes")
+        return cls(*struct.unpack_from("<IHHB", data))
@@ -1,4 +1,40 @@
-from .protocol import PROTOCOL_STX, PROTOCOL_MIN_PACKET_SIZE, PROTOCOL_MAX_PACKET_SIZE
+from .protocol import (
+    PROTOCOL_STX,
+    PROTOCOL_HEADER_SIZE,
+    PROTOCOL_MAX_PACKET_SIZE,
+    PROTOCOL_COBS_DELIMITER,
+    PROTOCOL_CRC_SIZE,
+)
+
+CRC32_POLY = 0x04C11DB7
+
+
+def encode_varint(value: int) -> bytes:
+    """LEB128 без знака: 7 бит на байт, старший бит - продолжение."""
+    if value < 0 or value >> 64:
+        raise ValueError(f"varint {value} out of range")
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def decode_varint(data: bytes, offset: int = 0) -> tuple[int, int]:
+    """(значение, смещение за полем). ValueError, если поле обрезано или длиннее 10 байт."""
+    value = 0
+    for i in range(10):
+        if offset + i >= len(data):
+            break
+        byte = data[offset + i]
+        value |= (byte & 0x7F) << (7 * i)
+        if not byte & 0x80:
+            return value, offset + i + 1
+    raise ValueError(f"bad varint at offset {offset}")
 
 
 def calculate_xor(data: bytes) -> int:
@@ -8,24 +44,98 @@ def calculate_xor(data: bytes) -> int:
     return result
 
 
+def _make_crc32_table() -> list[int]:
+    table = []
+    for i in range(256):
+        crc = i << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ CRC32_POLY) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+        table.append(crc)
+    return table
+
+
+_CRC32_TABLE = _make_crc32_table()
+
+
+def calculate_crc32(data: bytes) -> int:
+    """CRC-32 как у аппаратного блока STM32F4 (см. src/crc32.hpp).
+
+    Байты упаковываются в 32-битные слова little-endian с дополнением нулями,
+    каждое слово подается старшим байтом вперед.
+    """
+    crc = 0xFFFFFFFF
+    padded = bytes(data) + bytes(-len(data) % 4)
+    for i in range(0, len(padded), 4):
+        for b in reversed(padded[i:i + 4]):
+            crc = ((crc << 8) & 0xFFFFFFFF) ^ _CRC32_TABLE[((crc >> 24) ^ b) & 0xFF]
+    return crc
+
+
+def cobs_encode(data: bytes) -> bytes:
+    """COBS без разделителя; блоки режутся так же, как в прошивке (sendCobs)."""
+    out = bytearray()
+    block_start = 0
+    for i in range(len(data) + 1):
+        if i == len(data) or data[i] == 0:
+            out.append(i - block_start + 1)
+            out += data[block_start:i]
+            block_start = i + 1
+        elif i + 1 - block_start == 254:
+            out.append(0xFF)
+            out += data[block_start:i + 1]
+            block_start = i + 1
+    return bytes(out)
+
+
+def cobs_decode(data: bytes) -> bytes:
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        pos += 1
+        if code == 0 or pos + code - 1 > len(data):
+            raise ValueError("COBS decode error")
+        out += data[pos:pos + code - 1]
+        pos += code - 1
+        if code != 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
 class Packet:
     def __init__(self, command: int, data: bytes = b""):
         self.command = command
         self.data = data
 
-    def to_bytes(self) -> bytes:
-        total_length = PROTOCOL_MIN_PACKET_SIZE + len(self.data)
+    def to_bytes(self, crc: bool = False) -> bytes:
+        trailer_size = PROTOCOL_CRC_SIZE if crc else 1
+        total_length = PROTOCOL_HEADER_SIZE + len(self.data) + trailer_size
         length_h = (total_length >> 8) & 0xFF
         length_l = total_length & 0xFF
 
         payload = bytes([length_h, length_l, self.command]) + self.data
-        xor_value = calculate_xor(payload)
+        if crc:
+            trailer = calculate_crc32(payload).to_bytes(PROTOCOL_CRC_SIZE, "little")
+        else:
+            trailer = bytes([calculate_xor(payload)])
+
+        return bytes([PROTOCOL_STX]) + payload + trailer
 
-        return bytes([PROTOCOL_STX]) + payload + bytes([xor_value])
+    def to_cobs(self, crc: bool = False) -> bytes:
+        return cobs_encode(self.to_bytes(crc)[1:]) + bytes([PROTOCOL_COBS_DELIMITER])
+
+    @classmethod
+    def from_cobs(cls, data: bytes, crc: bool = False) -> "Packet":
+        if data.endswith(bytes([PROTOCOL_COBS_DELIMITER])):
+            data = data[:-1]
+        return cls.from_bytes(bytes([PROTOCOL_STX]) + cobs_decode(data), crc)
 
     @classmethod
-    def from_bytes(cls, data: bytes) -> "Packet":
-        if len(data) < PROTOCOL_MIN_PACKET_SIZE:
+    def from_bytes(cls, data: bytes, crc: bool = False) -> "Packet":
+        trailer_size = PROTOCOL_CRC_SIZE if crc else 1
+        min_size = PROTOCOL_HEADER_SIZE + trailer_size
+        if len(data) < min_size:
             raise ValueError(f"Packet too short: {len(data)} bytes")
 
         if data[0] != PROTOCOL_STX:
@@ -39,11 +149,17 @@ class Packet:
             raise ValueError(f"Packet too long: {length} bytes")
 
         command = data[3]
-        payload_data = data[4:-1] if length > PROTOCOL_MIN_PACKET_SIZE else b""
-        received_xor = data[-1]
+        payload_data = data[PROTOCOL_HEADER_SIZE:-trailer_size] if length > min_size else b""
 
-        calculated_xor = calculate_xor(data[1:-1])
-        if calculated_xor != received_xor:
-            raise ValueError(f"XOR mismatch: expected 0x{calculated_xor:02X}, got 0x{received_xor:02X}")
+        if crc:
+            received_crc = int.from_bytes(data[-PROTOCOL_CRC_SIZE:], "little")
+            calculated_crc = calculate_crc32(data[1:-PROTOCOL_CRC_SIZE])
+            if calculated_crc != received_crc:
+                raise ValueError(f"CRC mismatch: expected 0x{calculated_crc:08X}, got 0x{received_crc:08X}")
+        else:
+            received_xor = data[-1]
+            calculated_xor = calculate_xor(data[1:-1])
+            if calculated_xor != received_xor:
+                raise ValueError(f"XOR mismatch: expected 0x{calculated_xor:02X}, got 0x{received_xor:02X}")
 
         return cls(command=command, data=payload_data)
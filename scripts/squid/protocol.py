@@ -1,31 +1,209 @@
-from enum import IntEnum
+from enum import IntEnum, IntFlag
 
 PROTOCOL_STX = 0x02
 PROTOCOL_MIN_PACKET_SIZE = 5
 PROTOCOL_MAX_PACKET_SIZE = 256
+PROTOCOL_HEADER_SIZE = 4
+PROTOCOL_COBS_DELIMITER = 0x00
+PROTOCOL_CRC_SIZE = 4
 
 
 class Command(IntEnum):
     VERSION = 0x01
     STATUS = 0x02
     STOP = 0x03
+    SESSION = 0x04
+    STATS = 0x05
+    BOOT_INFO = 0x06
+    PROFILE = 0x07
+    SAMPLES = 0x08
+    TRACE = 0x09
+    LOG = 0x0A
+    LINK_STATS = 0x0B
+    SUBSCRIBE = 0x0C
+    WAIT_EVENT = 0x0D
     SYNC_MOVE = 0x10
     ASYNC_MOVE = 0x11
+    PROFILE_MOVE = 0x12
+    COMPACT_MOVE = 0x13
+    LINEAR_MOVE = 0x14
+    SEGMENT_MOVE = 0x15
+    VELOCITY = 0x16
+    VELOCITY_SET = 0x17
+    PROFILE_STORE = 0x18
+    SEQUENCE = 0x20
 
 
 class Response(IntEnum):
     VERSION = 0x81
     STATUS = 0x82
     STOP = 0x83
+    SESSION = 0x84
+    STATS = 0x85
+    BOOT_INFO = 0x86
+    PROFILE = 0x87
+    SAMPLES = 0x88
+    TRACE = 0x89
+    LOG = 0x8A
+    LINK_STATS = 0x8B
+    SUBSCRIBE = 0x8C
+    WAIT_EVENT = 0x8D
     MOVE = 0x90
+    SEGMENT_MOVE = 0x95
+    VELOCITY = 0x96
+    PROFILE_STORE = 0x98
+    SEQUENCE = 0xA0
+    TELEMETRY = 0xC0
     ERROR = 0xFF
 
 
+class SessionFlag(IntFlag):
+    NONE = 0x00
+    COBS_FRAMING = 0x01
+    CRC32 = 0x02
+
+
+class TelemetryFlag(IntFlag):
+    NONE = 0x00
+    ON_CHANGE = 0x01
+
+
+class WaitStatus(IntEnum):
+    EVENT = 0x00
+    TIMEOUT = 0x01
+
+
+class SampleOp(IntEnum):
+    READ = 0x00
+    START = 0x01
+    STOP = 0x02
+    CLEAR = 0x03
+
+
+class TraceOp(IntEnum):
+    READ = 0x00
+    CLEAR = 0x01
+
+
+class LogOp(IntEnum):
+    READ = 0x00
+    CLEAR = 0x01
+
+
+class LinkStatsOp(IntEnum):
+    READ = 0x00
+    CLEAR = 0x01
+
+
+class ProfileOp(IntEnum):
+    READ = 0x00
+    SET = 0x01
+    DELETE = 0x02
+    INFO = 0x03
+
+
+class ProfileResult(IntEnum):
+    OK = 0x00
+    BUSY = 0x01
+    INVALID = 0x02
+    FLASH_ERROR = 0x03
+
+
+class VelocityOp(IntEnum):
+    START = 0x00
+    STOP = 0x01
+    STATS = 0x02
+
+
+class VelocityResult(IntEnum):
+    OK = 0x00
+    BUSY = 0x01
+    INVALID = 0x02
+    UNSUPPORTED = 0x03
+
+
+class StreamState(IntEnum):
+    IDLE = 0x00
+    STREAMING = 0x01
+    STOPPING = 0x02
+
+
+class MoveResult(IntEnum):
+    SUCCESS = 0x00
+    BUSY = 0x01
+    FAULT = 0x02
+
+
+class MoveMode(IntEnum):
+    ASYNC = 0x00
+    SYNC = 0x01
+
+
+class SeqOp(IntEnum):
+    CLEAR = 0x00
+    LOAD = 0x01
+    RUN = 0x02
+    STOP = 0x03
+    STATUS = 0x04
+
+
+class SeqOpcode(IntEnum):
+    END = 0x00
+    MOVE = 0x01
+    WAIT = 0x02
+    DELAY = 0x03
+    LOOP = 0x04
+    END_LOOP = 0x05
+    WAIT_INPUT = 0x06
+
+
+class SeqResult(IntEnum):
+    OK = 0x00
+    BUSY = 0x01
+    INVALID = 0x02
+    OVERFLOW = 0x03
+    MOTOR_FAULT = 0x04
+    STOPPED = 0x05
+
+
+class SeqState(IntEnum):
+    IDLE = 0x00
+    RUNNING = 0x01
+    DONE = 0x02
+    FAULT = 0x03
+
+
 class ErrorCode(IntEnum):
     INVALID_COMMAND = 0x01
     INVALID_PACKET_LENGTH = 0x02
     XOR_CHECKSUM_ERROR = 0x03
     INVALID_MOTOR_COUNT = 0x04
     MOTOR_PARAM_ERROR = 0x05
+    FRAME_TIMEOUT = 0x06
+    CRC_CHECKSUM_ERROR = 0x07
     EMERGENCY_STOP = 0x0B
     TIMEOUT = 0x0D
+    STREAM_INACTIVE = 0x0E
+
+
+class ParamFault(IntEnum):
+    """Причина MOTOR_PARAM_ERROR: ERROR = code | reason | index записи."""
+    NONE = 0x00
+    NUMBER = 0x01
+    ACCEL = 0x02
+    SPEED = 0x03
+    DUPLICATE = 0x04
+    RESERVED = 0x05
+    ENCODING = 0x06
+    PROFILE = 0x07
+    PATH = 0x08
+    STREAM = 0x09
+
+
+# Ошибки, после которых MCU гарантированно не выполнял команду - можно повторить
+RETRYABLE_ERRORS = (
+    ErrorCode.INVALID_PACKET_LENGTH,
+    ErrorCode.XOR_CHECKSUM_ERROR,
+    ErrorCode.FRAME_TIMEOUT,
+    ErrorCode.CRC_CHECKSUM_ERROR,
+)
@@ -0,0 +1,107 @@
+from dataclasses import dataclass
+import math
+import struct
+
+from .motor import MotorParams
+from .protocol import MoveResult
+
+# Ограничения SegmentPlanner (segment_planner.hpp)
+SEGMENT_MAX = 20
+SEGMENT_LOOKAHEAD = 8
+MAX_RUN_STEPS = 0x7FFFFFFF
+
+REPORT_FORMAT = "<BBBIII"
+REPORT_SIZE = struct.calcsize(REPORT_FORMAT)
+
+
+@dataclass
+class Segment:
+    """Сегмент SEGMENT_MOVE: одна трапеция цепочки движений мотора."""
+    acceleration: int
+    max_speed: int
+    steps: int
+
+    def to_bytes(self) -> bytes:
+        return struct.pack("<IIi", self.acceleration, self.max_speed, self.steps)
+
+
+def trapezoid_ms(steps: int, acceleration: int, speed: int) -> int:
+    """Время трапеции от 0 до 0 в целых мс, как SegmentPlanner::trapezoidMs()."""
+    if steps * acceleration >= speed * speed:
+        ms = (steps * 1000 + speed // 2) // speed + (speed * 1000 + acceleration // 2) // acceleration
+    else:
+        ms = 2 * math.isqrt(steps * 1000000 // acceleration)
+    return min(ms, 0xFFFFFFFF)
+
+
+@dataclass
+class SegmentPlan:
+    """Команды драйверу после слияния и оценка времени, мс."""
+    commands: list[MotorParams]
+    standalone_ms: int
+    planned_ms: int
+
+
+def plan_segments(motor: int, segments: list[Segment]) -> SegmentPlan:
+    """Копия SegmentPlanner::plan(): слить сегменты одного направления, если
+    одна трапеция (min accel, min speed, сумма шагов) не дольше раздельных.
+
+    Так же считает и MCU - позволяет оценить выигрыш на записанной цепочке
+    без платы (segment-move --plan-only).
+    """
+    commands: list[MotorParams] = []
+    standalone = planned = 0
+    run = None  # [accel, speed, |steps|, reverse, ms, segments]
+
+    def emit(r):
+        nonlocal planned
+        steps = -r[2] if r[3] else r[2]
+        commands.append(MotorParams(number=motor, acceleration=r[0], max_speed=r[1], steps=steps & 0xFFFFFFFF))
+        planned = min(planned + r[4], 0xFFFFFFFF)
+
+    for seg in segments:
+        if seg.acceleration <= 0 or seg.max_speed <= 0:
+            raise ValueError(f"bad segment {seg}")
+        if seg.steps == 0:
+            continue
+        size = abs(seg.steps)
+        ms = trapezoid_ms(size, seg.acceleration, seg.max_speed)
+        nxt = [seg.acceleration, seg.max_speed, size, seg.steps < 0, ms, 1]
+        standalone = min(standalone + ms, 0xFFFFFFFF)
+
+        if run and run[3] == nxt[3] and run[5] < SEGMENT_LOOKAHEAD and run[2] + size <= MAX_RUN_STEPS:
+            accel, speed, total = min(run[0], nxt[0]), min(run[1], nxt[1]), run[2] + size
+            merged_ms = trapezoid_ms(total, accel, speed)
+            if merged_ms <= min(run[4] + ms, 0xFFFFFFFF):
+                run = [accel, speed, total, run[3], merged_ms, run[5] + 1]
+                continue
+
+        if run:
+            emit(run)
+        run = nxt
+
+    if run:
+        emit(run)
+    return SegmentPlan(commands, standalone, planned)
+
+
+@dataclass
+class SegmentReport:
+    """Ответ SEGMENT_MOVE: результат, сегменты -> команды и время, мс."""
+    result: MoveResult
+    segments: int
+    commands: int
+    standalone_ms: int
+    planned_ms: int
+    elapsed_ms: int
+
+    @property
+    def saved_ms(self) -> int:
+        return self.standalone_ms - self.planned_ms
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "SegmentReport":
+        if len(data) < REPORT_SIZE:
+            raise ValueError(f"SEGMENT_MOVE report too short: {len(data)} bytes")
+        fields = struct.unpack_from(REPORT_FORMAT, data)
+        return cls(MoveResult(fields[0]), *fields[1:])
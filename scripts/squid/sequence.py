@@ -0,0 +1,142 @@
+from dataclasses import dataclass
+import struct
+
+from .motor import MotorParams
+from .packet import encode_varint
+from .protocol import SeqOpcode, SeqResult, SeqState
+
+# Буфер программы в CCMRAM (SEQUENCE_PROGRAM_SIZE в sequencer.hpp)
+SEQUENCE_PROGRAM_SIZE = 1024
+SEQUENCE_LOOP_DEPTH = 4
+# Кусок LOAD: кадр 256 байт минус заголовок, op и offset
+SEQUENCE_CHUNK_SIZE = 240
+ENDSTOP_INPUTS = 6
+
+STATUS_FORMAT = "<BBHHIIHIHIHII"
+STATUS_SIZE = struct.calcsize(STATUS_FORMAT)
+
+
+class Program:
+    """Построитель программы SEQUENCE. Методы возвращают self для цепочек."""
+
+    def __init__(self):
+        self._code = bytearray()
+        self._depth = 0
+
+    def move(self, motors: list[MotorParams]) -> "Program":
+        if not motors:
+            raise ValueError("MOVE needs at least one motor")
+        self._code += bytes([SeqOpcode.MOVE, len(motors)])
+        self._code += b"".join(m.to_bytes() for m in motors)
+        return self
+
+    def wait(self, mask: int = 0) -> "Program":
+        """Ждать моторы mask; 0 - все моторы текущего движения."""
+        self._code += bytes([SeqOpcode.WAIT]) + encode_varint(mask)
+        return self
+
+    def delay(self, ms: int) -> "Program":
+        self._code += bytes([SeqOpcode.DELAY]) + encode_varint(ms)
+        return self
+
+    def loop(self, count: int = 0) -> "Program":
+        """Тело до end_loop() count раз, 0 - бесконечно."""
+        if self._depth >= SEQUENCE_LOOP_DEPTH:
+            raise ValueError(f"loop nesting deeper than {SEQUENCE_LOOP_DEPTH}")
+        self._depth += 1
+        self._code += bytes([SeqOpcode.LOOP]) + encode_varint(count)
+        return self
+
+    def end_loop(self) -> "Program":
+        if self._depth == 0:
+            raise ValueError("END_LOOP without LOOP")
+        self._depth -= 1
+        self._code.append(SeqOpcode.END_LOOP)
+        return self
+
+    def wait_input(self, index: int, level: int) -> "Program":
+        """Ждать уровень level (0/1) на ENDSTOP index (0-5)."""
+        if not 0 <= index < ENDSTOP_INPUTS or level not in (0, 1):
+            raise ValueError(f"bad WAIT_INPUT {index} {level}")
+        self._code += bytes([SeqOpcode.WAIT_INPUT, index, level])
+        return self
+
+    def end(self) -> "Program":
+        self._code.append(SeqOpcode.END)
+        return self
+
+    def to_bytes(self) -> bytes:
+        if self._depth:
+            raise ValueError("unclosed LOOP")
+        if len(self._code) > SEQUENCE_PROGRAM_SIZE:
+            raise ValueError(f"program {len(self._code)} bytes exceeds {SEQUENCE_PROGRAM_SIZE}")
+        return bytes(self._code)
+
+
+def _parse_motor(token: str) -> MotorParams:
+    number, accel, speed, steps = (int(x, 0) for x in token.split(":"))
+    return MotorParams(number=number, acceleration=accel, max_speed=speed, steps=steps)
+
+
+def assemble(text: str) -> bytes:
+    """Текст программы в байткод. По инструкции на строку, '#' - комментарий:
+
+        move 1:500:2000:6400 2:500:1000:3200   # мотор:ускорение:скорость:шаги, как в multi-move
+        wait [mask]
+        delay ms
+        loop [count]
+        end_loop
+        wait_input input level
+        end
+    """
+    program = Program()
+    for lineno, line in enumerate(text.splitlines(), 1):
+        words = line.split("#", 1)[0].split()
+        if not words:
+            continue
+        op, args = words[0].lower(), words[1:]
+        try:
+            if op == "move":
+                program.move([_parse_motor(a) for a in args])
+            elif op == "wait" and len(args) <= 1:
+                program.wait(int(args[0], 0) if args else 0)
+            elif op == "delay" and len(args) == 1:
+                program.delay(int(args[0], 0))
+            elif op == "loop" and len(args) <= 1:
+                program.loop(int(args[0], 0) if args else 0)
+            elif op == "end_loop" and not args:
+                program.end_loop()
+            elif op == "wait_input" and len(args) == 2:
+                program.wait_input(int(args[0], 0), int(args[1], 0))
+            elif op == "end" and not args:
+                program.end()
+            else:
+                raise ValueError(f"unknown instruction '{line.strip()}'")
+        except ValueError as e:
+            raise ValueError(f"line {lineno}: {e}") from None
+    return program.to_bytes()
+
+
+@dataclass
+class SequenceStatus:
+    """Ответ SEQUENCE STATUS: где программа и сколько длились ее шаги (мс)."""
+    state: SeqState
+    reason: SeqResult
+    pc: int
+    length: int
+    steps: int
+    run_ms: int
+    step_pc: int
+    step_ms: int
+    last_pc: int
+    last_ms: int
+    max_pc: int
+    max_ms: int
+    loop_remaining: int
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "SequenceStatus":
+        if len(data) < STATUS_SIZE:
+            raise ValueError(f"SEQUENCE STATUS too short: {len(data)} bytes")
+        fields = struct.unpack_from(STATUS_FORMAT, data)
+        return cls(SeqState(fields[0]), SeqResult(fields[1]), *fields[2:])
@@ -0,0 +1,132 @@
+from dataclasses import dataclass
+import math
+
+# Константы StepRamp и StepDir (step_ramp.cpp, step_dir.hpp)
+TIMER_HZ = 16_000_000
+STEP_MAX_RATE_HZ = 200_000
+STEP_PULSE_TICKS = 32
+STEP_DMA_BLOCK = 64
+CRUISE_TICKS = 4096
+FRACTION_BITS = 15
+FIRST_STEP_FACTOR = 22151
+MAX_PERIOD = 0xFFFF
+MAX_C = MAX_PERIOD << FRACTION_BITS
+
+
+def first_period(acceleration: int, timer_hz: int) -> int:
+    """c_0 из StepRamp::firstPeriod(), такты << FRACTION_BITS."""
+    return math.isqrt(2 * timer_hz * timer_hz // acceleration) * FIRST_STEP_FACTOR
+
+
+def timer_divider(acceleration: int, speed: int, timer_hz: int = TIMER_HZ) -> int:
+    """Делитель таймера из StepDir: первый период разгона в 16 бит, но
+    крейсерский не короче CRUISE_TICKS; для быстрых осей - 1."""
+    span = MAX_PERIOD * speed
+    minimum = (timer_hz + span - 1) // span
+    first = ((first_period(acceleration, timer_hz) >> FRACTION_BITS) + MAX_PERIOD - 1) // MAX_PERIOD
+    cruise = timer_hz // (speed * CRUISE_TICKS)
+    return max(min(first, cruise), minimum, 1)
+
+
+def ramp_periods(steps: int, acceleration: int, max_speed: int, timer_hz: int) -> list[tuple[int, bool]]:
+    """Копия StepRamp: периоды шагов в тактах таймера и признак крейсерского
+    шага (период задан скоростью, а не рекуррентой). Целая арифметика та же,
+    что на MCU, поэтому результат совпадает до такта.
+    """
+    frac_mask = (1 << FRACTION_BITS) - 1
+    c_min = min((timer_hz << FRACTION_BITS) // max_speed, MAX_C)
+
+    c0 = first_period(acceleration, timer_hz)
+    if c0 <= MAX_C:
+        n0, c = 0, c0
+    else:
+        d = acceleration * MAX_PERIOD * MAX_PERIOD
+        q = (timer_hz * timer_hz + d - 1) // d
+        n0 = q // 2 if q >= 2 else 1
+        root = math.isqrt((acceleration * (2 * n0 + 1)) << 16)
+        c = min((timer_hz << (FRACTION_BITS + 8)) // root, MAX_C)
+
+    accelerating = c > c_min
+    decel_start = steps - steps // 2 if accelerating else steps
+    n, rest, fraction = n0, 0, 0
+
+    out = []
+    for step in range(1, steps + 1):
+        value = max(c, c_min) + fraction
+        ticks, fraction = value >> FRACTION_BITS, value & frac_mask
+        if ticks > MAX_PERIOD:
+            ticks, fraction = MAX_PERIOD, 0
+        out.append((max(ticks, 1), c <= c_min))
+
+        if step >= decel_start:
+            if step == decel_start:
+                rest = 0
+            if step < steps and n > n0 + (steps - 1 - step):
+                num, div = 2 * c + rest, 4 * n - 1
+                c, rest = min(c + num // div, MAX_C), num % div
+                n -= 1
+        elif accelerating:
+            n += 1
+            num, div = 2 * c + rest, 4 * n + 1
+            c, rest = c - num // div, num % div
+            if c <= c_min:
+                accelerating = False
+                decel_start = steps - (n - n0)
+    return out
+
+
+def ideal_seconds(steps: int, acceleration: int, speed: int) -> float:
+    """Время непрерывной трапеции от 0 до 0."""
+    if steps * acceleration >= speed * speed:
+        return steps / speed + speed / acceleration
+    return 2 * math.sqrt(steps / acceleration)
+
+
+@dataclass
+class StepTiming:
+    """Импульсы одного движения STEP/DIR в модели таймера (16 МГц)."""
+    steps: int
+    speed: int            # После ограничения STEP_MAX_RATE_HZ
+    divider: int          # Делитель таймера (PSC + 1)
+    periods: list[int]    # Такты таймера после делителя
+    cruise: list[bool]
+
+    @property
+    def tick_ns(self) -> float:
+        return 1e9 * self.divider / TIMER_HZ
+
+    @property
+    def seconds(self) -> float:
+        return sum(self.periods) * self.divider / TIMER_HZ
+
+    @property
+    def max_rate_hz(self) -> float:
+        return TIMER_HZ / self.divider / min(self.periods) if self.periods else 0.0
+
+    @property
+    def cruise_jitter_ns(self) -> float:
+        """Разброс периода на крейсерской скорости: 0 или один такт."""
+        cruise = [p for p, c in zip(self.periods, self.cruise) if c]
+        return (max(cruise) - min(cruise)) * self.tick_ns if cruise else 0.0
+
+    @property
+    def cruise_rate_hz(self) -> float:
+        """Средняя частота шагов на крейсерском участке."""
+        cruise = [p for p, c in zip(self.periods, self.cruise) if c]
+        return len(cruise) * TIMER_HZ / self.divider / sum(cruise) if cruise else 0.0
+
+    @property
+    def dma_interrupts(self) -> int:
+        """Прерываний DMA за движение: одно на половину кольца."""
+        return max(self.steps - 2, 0) // STEP_DMA_BLOCK + 1 if self.steps else 0
+
+
+def step_timing(steps: int, acceleration: int, speed: int, timer_hz: int = TIMER_HZ) -> StepTiming:
+    """Как StepDir::start(): знак шагов - DIR, скорость не выше STEP_MAX_RATE_HZ."""
+    if acceleration <= 0 or speed <= 0:
+        raise ValueError("acceleration and speed must be positive")
+    count = abs(steps)
+    speed = min(speed, STEP_MAX_RATE_HZ)
+    divider = timer_divider(acceleration, speed, timer_hz)
+    pairs = ramp_periods(count, acceleration, speed, timer_hz // divider)
+    return StepTiming(count, speed, divider, [p for p, _ in pairs], [c for _, c in pairs])
@@ -0,0 +1,137 @@
+"""Адреса -> функции по main.map или main.elf (для гистограммы SAMPLES)."""
+
+from bisect import bisect_right
+from dataclasses import dataclass
+from pathlib import Path
+import re
+import shutil
+import subprocess
+from typing import Optional
+
+from .diagnostics import PcHistogram
+
+# " .text.name  0x08000a1c  0x1a4 file.o" (имя секции может стоять на отдельной строке)
+_MAP_SECTION = re.compile(r"^ \.text(?:\.(\S+))?\s*$|^ \.text(?:\.(\S+))?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+\S")
+_MAP_CONTINUATION = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+\S")
+_MAP_SYMBOL = re.compile(r"^\s+0x([0-9a-f]+)\s+([A-Za-z_.\[].*?)\s*$")
+
+
+@dataclass(frozen=True)
+class Symbol:
+    address: int
+    size: int
+    name: str
+
+
+class SymbolTable:
+    def __init__(self, symbols: list[Symbol]):
+        self._symbols = sorted((s for s in symbols if s.address), key=lambda s: s.address)
+        self._addresses = [s.address for s in self._symbols]
+
+    def __len__(self) -> int:
+        return len(self._symbols)
+
+    def lookup(self, address: int) -> Optional[Symbol]:
+        i = bisect_right(self._addresses, address) - 1
+        if i < 0:
+            return None
+        symbol = self._symbols[i]
+        if symbol.size and address >= symbol.address + symbol.size:
+            return None
+        return symbol
+
+    def attribute(self, histogram: PcHistogram) -> list[tuple[str, int]]:
+        """Суммы отсчетов по функциям, по убыванию. Корзина относится к функции по своему началу."""
+        totals: dict[str, int] = {}
+        for index, hits in histogram.buckets.items():
+            symbol = self.lookup(histogram.bucket_address(index))
+            name = symbol.name if symbol else f"0x{histogram.bucket_address(index):08x}"
+            totals[name] = totals.get(name, 0) + hits
+        if histogram.out_of_range:
+            totals["<outside .text>"] = histogram.out_of_range
+        return sorted(totals.items(), key=lambda item: item[1], reverse=True)
+
+
+def parse_map(text: str) -> SymbolTable:
+    """Символы из карты GNU ld: секции .text.* (-ffunction-sections) и глобальные имена."""
+    symbols = []
+    pending = None
+    in_text = False
+
+    for line in text.splitlines():
+        if line.startswith(".text"):
+            in_text = True
+            continue
+        if line and not line[0].isspace():
+            in_text = False
+        if not in_text:
+            continue
+
+        if pending is not None:
+            match = _MAP_CONTINUATION.match(line)
+            if match:
+                symbols.append(Symbol(int(match.group(1), 16), int(match.group(2), 16), pending))
+            pending = None
+            continue
+
+        match = _MAP_SECTION.match(line)
+        if match:
+            if match.group(3) is None:
+                pending = match.group(1) or ".text"
+            else:
+                name = match.group(2) or ".text"
+                symbols.append(Symbol(int(match.group(3), 16), int(match.group(4), 16), name))
+            continue
+
+        match = _MAP_SYMBOL.match(line)
+        if match and "=" not in match.group(2) and not match.group(2).startswith(("PROVIDE", "[")):
+            symbols.append(Symbol(int(match.group(1), 16), 0, match.group(2)))
+
+    return SymbolTable(_demangle(_prefer_named(symbols)))
+
+
+def parse_nm(text: str) -> SymbolTable:
+    """Вывод `nm -n -S -C --defined-only`: "08000a1c 000001a4 T MotorDriver::tick()"."""
+    symbols = []
+    for line in text.splitlines():
+        parts = line.split(maxsplit=3)
+        if len(parts) == 4 and parts[2] in "tTwW":
+            symbols.append(Symbol(int(parts[0], 16) & ~1, int(parts[1], 16), parts[3]))
+    return SymbolTable(symbols)
+
+
+def load_symbols(path: str, nm: str = "arm-none-eabi-nm") -> SymbolTable:
+    if Path(path).suffix == ".map":
+        return parse_map(Path(path).read_text(errors="replace"))
+    tool = shutil.which(nm) or shutil.which("nm")
+    if tool is None:
+        raise FileNotFoundError(f"{nm} not found, pass main.map instead")
+    output = subprocess.run(
+        [tool, "-n", "-S", "-C", "--defined-only", path],
+        check=True, capture_output=True, text=True,
+    ).stdout
+    return parse_nm(output)
+
+
+def _prefer_named(symbols: list[Symbol]) -> list[Symbol]:
+    """Глобальное имя по тому же адресу точнее имени секции - оставляем его с размером секции."""
+    by_address: dict[int, Symbol] = {}
+    for symbol in symbols:
+        known = by_address.get(symbol.address)
+        if known is None:
+            by_address[symbol.address] = symbol
+        elif symbol.size == 0:
+            by_address[symbol.address] = Symbol(symbol.address, known.size, symbol.name)
+    return list(by_address.values())
+
+
+def _demangle(symbols: list[Symbol]) -> list[Symbol]:
+    tool = shutil.which("arm-none-eabi-c++filt") or shutil.which("c++filt")
+    mangled = [s for s in symbols if s.name.startswith("_Z")]
+    if tool is None or not mangled:
+        return symbols
+    output = subprocess.run(
+        [tool], input="\n".join(s.name for s in mangled), check=True, capture_output=True, text=True,
+    ).stdout.splitlines()
+    names = dict(zip((s.name for s in mangled), output))
+    return [Symbol(s.address, s.size, names.get(s.name, s.name)) for s in symbols]
@@ -0,0 +1,120 @@
+"""Разбор ответов TRACE и конвертация в Chrome trace JSON (chrome://tracing, Perfetto)."""
+
+from dataclasses import dataclass
+from enum import IntEnum
+import struct
+
+TRACE_HEADER_FORMAT = "<IHB"
+TRACE_HEADER_SIZE = struct.calcsize(TRACE_HEADER_FORMAT)
+TRACE_RECORD_FORMAT = "<IHBB"
+TRACE_RECORD_SIZE = struct.calcsize(TRACE_RECORD_FORMAT)
+
+
+class TraceEvent(IntEnum):
+    """Совпадает с enum TraceEvent в src/trace.hpp."""
+    FRAME_START = 1
+    FRAME_COMPLETE = 2
+    DISPATCH = 3
+    DRIVER_TX_START = 4
+    DRIVER_TX_END = 5
+    STATUS_RISE = 6
+    STATUS_FALL = 7
+    RESPONSE = 8
+    SHIFT_FLUSH = 9
+    SHIFT_LATCH = 10
+
+
+@dataclass
+class TraceRecord:
+    cycles: int
+    txn: int
+    event: TraceEvent
+    arg: int
+
+
+@dataclass
+class TracePage:
+    clock_hz: int
+    dropped: int
+    records: list[TraceRecord]
+
+
+def parse_trace_page(data: bytes) -> TracePage:
+    if len(data) < TRACE_HEADER_SIZE:
+        raise ValueError(f"TRACE response too short: {len(data)} < {TRACE_HEADER_SIZE}")
+    clock_hz, dropped, count = struct.unpack_from(TRACE_HEADER_FORMAT, data)
+    if len(data) < TRACE_HEADER_SIZE + count * TRACE_RECORD_SIZE:
+        raise ValueError(f"TRACE response too short for {count} records")
+
+    records = []
+    for i in range(count):
+        cycles, txn, event, arg = struct.unpack_from(
+            TRACE_RECORD_FORMAT, data, TRACE_HEADER_SIZE + i * TRACE_RECORD_SIZE
+        )
+        records.append(TraceRecord(cycles, txn, TraceEvent(event), arg))
+    return TracePage(clock_hz, dropped, records)
+
+
+def unwrap_cycles(records: list[TraceRecord]) -> list[int]:
+    """CYCCNT 32-битный: переполнение видно как шаг назад больше половины диапазона."""
+    result = []
+    offset = 0
+    previous = None
+    for record in records:
+        if previous is not None and record.cycles < previous and previous - record.cycles > 1 << 31:
+            offset += 1 << 32
+        previous = record.cycles
+        result.append(record.cycles + offset)
+    return result
+
+
+# (начало, конец, имя участка, дорожка: "command", "shift_out" или номер мотора)
+_SPANS = (
+    (TraceEvent.FRAME_START, TraceEvent.FRAME_COMPLETE, "rx", "command"),
+    (TraceEvent.FRAME_COMPLETE, TraceEvent.DISPATCH, "parse->dispatch", "command"),
+    (TraceEvent.DISPATCH, TraceEvent.RESPONSE, "command", "command"),
+    (TraceEvent.DRIVER_TX_START, TraceEvent.DRIVER_TX_END, "bus", "motor"),
+    (TraceEvent.STATUS_RISE, TraceEvent.STATUS_FALL, "motion", "motor"),
+    (TraceEvent.SHIFT_FLUSH, TraceEvent.SHIFT_LATCH, "shift_out", "shift_out"),
+)
+
+
+def to_chrome_trace(records: list[TraceRecord], clock_hz: int) -> dict:
+    """Участки ph="X": одна дорожка на команды и по одной на мотор, pid = номер транзакции."""
+    stamps = unwrap_cycles(records)
+    origin = min(stamps) if stamps else 0
+
+    def us(cycles: int) -> float:
+        return (cycles - origin) * 1_000_000 / clock_hz
+
+    events = []
+    open_spans: dict[tuple, tuple[int, TraceRecord]] = {}
+    for stamp, record in zip(stamps, records):
+        for start, end, name, lane in _SPANS:
+            key = (record.txn, name, record.arg if lane == "motor" else 0)
+            if record.event == end and key in open_spans:
+                begin, first = open_spans.pop(key)
+                events.append({
+                    "name": name,
+                    "ph": "X",
+                    "ts": us(begin),
+                    "dur": us(stamp) - us(begin),
+                    "pid": record.txn,
+                    "tid": f"motor {record.arg}" if lane == "motor" else lane,
+                    "args": {"command": f"0x{first.arg:02X}"} if lane == "command" and first.arg else {},
+                })
+            if record.event == start:
+                open_spans[key] = (stamp, record)
+
+    for stamp, record in zip(stamps, records):
+        if record.event == TraceEvent.RESPONSE:
+            events.append({
+                "name": f"response 0x{record.arg:02X}",
+                "ph": "i",
+                "s": "t",
+                "ts": us(stamp),
+                "pid": record.txn,
+                "tid": "command",
+            })
+
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
@@ -4,16 +4,42 @@ from typing import Optional
 import aioserial
 
 from .packet import Packet
-from .protocol import PROTOCOL_STX, PROTOCOL_MIN_PACKET_SIZE, PROTOCOL_MAX_PACKET_SIZE
+from .protocol import (
+    PROTOCOL_STX,
+    PROTOCOL_MIN_PACKET_SIZE,
+    PROTOCOL_MAX_PACKET_SIZE,
+    PROTOCOL_COBS_DELIMITER,
+    SessionFlag,
+)
 from .errors import TimeoutError, ChecksumError
 
 
+def _is_checksum_error(error: ValueError) -> bool:
+    return str(error).startswith(("XOR mismatch", "CRC mismatch"))
+
+
 class AsyncSerialTransport:
     def __init__(self, port: str, baudrate: int = 115200):
         self._port = port
         self._baudrate = baudrate
         self._serial: Optional[aioserial.AioSerial] = None
         self._lock = asyncio.Lock()
+        self._session = SessionFlag.NONE
+
+    @property
+    def session(self) -> SessionFlag:
+        return self._session
+
+    def set_session(self, flags: SessionFlag) -> None:
+        self._session = SessionFlag(flags)
+
+    @property
+    def _cobs(self) -> bool:
+        return bool(self._session & SessionFlag.COBS_FRAMING)
+
+    @property
+    def _crc(self) -> bool:
+        return bool(self._session & SessionFlag.CRC32)
 
     async def connect(self) -> None:
         self._serial = aioserial.AioSerial(
@@ -32,9 +58,22 @@ class AsyncSerialTransport:
             raise RuntimeError("Not connected")
 
         async with self._lock:
-            data = packet.to_bytes()
+            data = packet.to_cobs(self._crc) if self._cobs else packet.to_bytes(self._crc)
             await self._serial.write_async(data)
 
+    async def discard_input(self) -> None:
+        """Сбросить принятое. Только при подключении: в работе в линии могут
+        быть TELEMETRY и отложенный WAIT_EVENT (см. SquidClient._drain_input)."""
+        if not self._serial:
+            raise RuntimeError("Not connected")
+        self._serial.reset_input_buffer()
+
+    async def has_input(self) -> bool:
+        """Есть ли уже принятые, но не разобранные байты."""
+        if not self._serial:
+            raise RuntimeError("Not connected")
+        return self._serial.in_waiting > 0
+
     async def receive_packet(self, timeout: float = 5.0) -> Packet:
         if not self._serial:
             raise RuntimeError("Not connected")
@@ -60,6 +99,20 @@ class AsyncSerialTransport:
                 if not byte:
                     continue
 
+                if self._cobs:
+                    if byte[0] != PROTOCOL_COBS_DELIMITER:
+                        buffer.extend(byte)
+                        continue
+                    if not buffer:
+                        continue
+                    try:
+                        return Packet.from_cobs(bytes(buffer), self._crc)
+                    except ValueError as e:
+                        if _is_checksum_error(e):
+                            raise ChecksumError(str(e)) from e
+                        buffer.clear()
+                        continue
+
                 if len(buffer) == 0 and byte[0] != PROTOCOL_STX:
                     continue
 
@@ -73,9 +126,9 @@ class AsyncSerialTransport:
 
                 if expected_length > 0 and len(buffer) >= expected_length:
                     try:
-                        return Packet.from_bytes(bytes(buffer))
+                        return Packet.from_bytes(bytes(buffer), self._crc)
                     except ValueError as e:
-                        if "XOR" in str(e):
+                        if _is_checksum_error(e):
                             raise ChecksumError(str(e)) from e
                         buffer.clear()
                         continue
@@ -0,0 +1,68 @@
+from dataclasses import dataclass
+import struct
+
+from .motor import pack_mask
+from .protocol import StreamState, PROTOCOL_HEADER_SIZE
+
+# Предел скорости STEP/DIR-канала (STEP_MAX_RATE_HZ в step_dir.hpp)
+VELOCITY_MAX = 200000
+
+STATS_FORMAT = "<BIIIHIIIIBBBB"
+STATS_SIZE = struct.calcsize(STATS_FORMAT)
+CHANNEL_FORMAT = "<Bi"
+CHANNEL_SIZE = struct.calcsize(CHANNEL_FORMAT)
+
+
+def pack_velocity_frame(seq: int, velocities: dict[int, int]) -> bytes:
+    """Данные VELOCITY_SET: seq u8 + маска минимальной ширины + i32 по
+    возрастанию номера мотора. Пустой словарь - кадр-пульс для сторожа."""
+    mask = 0
+    for motor, velocity in velocities.items():
+        if not 1 <= motor <= 64:
+            raise ValueError(f"motor {motor} out of 1..64")
+        if abs(velocity) > VELOCITY_MAX:
+            raise ValueError(f"velocity {velocity} exceeds {VELOCITY_MAX}")
+        mask |= 1 << (motor - 1)
+    values = b"".join(struct.pack("<i", velocities[m]) for m in sorted(velocities))
+    return bytes([seq & 0xFF]) + pack_mask(mask) + values
+
+
+def frame_rate_limit(axes: int, baudrate: int = 115200, crc: bool = False) -> float:
+    """Сколько кадров VELOCITY_SET в секунду пропускает линия (8N1, 10 бит на байт).
+
+    Кадр: STX + длина + команда + данные + XOR (или CRC-32 в сессии CRC).
+    """
+    data = len(pack_velocity_frame(0, {m: 0 for m in range(1, axes + 1)}))
+    size = PROTOCOL_HEADER_SIZE + data + (4 if crc else 1)
+    return baudrate / (10 * size)
+
+
+@dataclass
+class VelocityStats:
+    """Ответ VELOCITY STATS: принятые кадры и их дрожание (мкс)."""
+    state: StreamState
+    frames: int
+    late: int
+    lost: int
+    watchdog_trips: int
+    last_interval_us: int
+    max_jitter_us: int
+    mean_jitter_us: int
+    rejected: int     # Отклоненные кадры VELOCITY_SET: ERROR на них не шлется
+    last_error: int   # ErrorCode последнего отклонения, 0 - не было
+    last_fault: int   # ParamFault для MOTOR_PARAM_ERROR
+    last_index: int   # Номер значения в кадре
+    velocities: dict[int, int]  # мотор -> текущая скорость канала, шаг/с
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "VelocityStats":
+        if len(data) < STATS_SIZE:
+            raise ValueError(f"VELOCITY STATS too short: {len(data)} bytes")
+        fields = struct.unpack_from(STATS_FORMAT, data)
+        count = fields[-1]
+        if len(data) < STATS_SIZE + count * CHANNEL_SIZE:
+            raise ValueError(f"VELOCITY STATS truncated: {count} channels in {len(data)} bytes")
+        velocities = dict(
+            struct.unpack_from(CHANNEL_FORMAT, data, STATS_SIZE + i * CHANNEL_SIZE) for i in range(count)
+        )
+        return cls(StreamState(fields[0]), *fields[1:-1], velocities)
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "pin.hpp"
+#include "constants.hpp"
+
+/**
+ * Распиновка платы. Номер мотора m (1..MAX_MOTORS) - бит m-1 каждой группы.
+ *
+ * STM32F407 Discovery: 10 каналов моторов (PE10-PE15 заняты ENDSTOP).
+ * Другой распиновки в дереве нет, поэтому BOARD_MAX_MOTORS - от 1 до 10:
+ * группы занимают выводы 0..N-1 своих портов.
+ * BOARD_SHIFT_OUT снимает с GPIO только KEY/EN/SELECT: входы STATUS
+ * остаются на PE0-PE9, и больше 10 моторов без своей платы не собрать.
+ */
+namespace Board {
+    constexpr uint8_t MOTOR_CHANNELS = 10;
+    static_assert(MAX_MOTORS <= MOTOR_CHANNELS, "BOARD_MAX_MOTORS exceeds motor channels of this board's pin map");
+
+    using Key     = PinGroup<Port::B, 0, MAX_MOTORS>;   // KEY1-10: драйвер слушает USART2
+    using Enable  = PinGroup<Port::C, 0, MAX_MOTORS>;   // EN1-10: питание драйверов
+    using Select  = PinGroup<Port::D, 0, MAX_MOTORS>;   // SELECT1-10
+    using Status  = PinGroup<Port::E, 0, MAX_MOTORS>;   // STATUS1-10: HIGH - мотор движется
+    using Endstop = PinGroup<Port::E, 10, 6>;           // ENDSTOP1-6
+
+    using Uart4Pins  = PinGroup<Port::A, 0, 2>;  // PA0 TX, PA1 RX (ПК, AF8)
+    using Usart2Pins = PinGroup<Port::A, 2, 2>;  // PA2 TX, PA3 RX (драйверы, AF7)
+
+    // Цепочка 74HC595 (BOARD_SHIFT_OUT): SPI3 SCK/MOSI (AF6), RCLK и /OE - GPIO
+    using ShiftSck   = Pin<Port::C, 10>;
+    using ShiftLatch = Pin<Port::C, 11>;
+    using ShiftMosi  = Pin<Port::C, 12>;
+    using ShiftOe    = Pin<Port::C, 13>;
+
+    // STEP/DIR-драйверы (BOARD_STEP_DIR): STEP - CH1 таймеров (AF1), DIR - GPIO
+    using StepPulse0    = Pin<Port::A, 8>;            // TIM1_CH1
+    using StepPulse1    = Pin<Port::A, 15>;           // TIM2_CH1
+    using StepDirection = PinGroup<Port::B, 12, 2>;   // DIR каналов 0 и 1
+
+    // Стартовое мигание (LedTask) на KEY1-3
+    using StartupBlink = PinGroup<Port::B, 0, 3>;
+
+    // Светодиоды отладочной платы, общий порт с SELECT
+    using Leds      = PinGroup<Port::D, 12, 4>;
+    using LedGreen  = Pin<Port::D, 12>;  // Принят кадр команды
+    using LedOrange = Pin<Port::D, 13>;  // IDLE UART4 / проверка RX драйверов
+    using LedRed    = Pin<Port::D, 14>;  // HT DMA приема / отправка драйверам
+    using LedBlue   = Pin<Port::D, 15>;  // TC DMA приема / движение завершено
+}
+
+// Маски настройки считаются при компиляции
+static_assert(Board::Key::MASK == (1UL << MAX_MOTORS) - 1, "KEY1..N occupy PB0..PB(N-1)");
+static_assert(Board::Key::FIELD2 == (1UL << (2 * MAX_MOTORS)) - 1, "KEY1..N fields start at MODER0");
+static_assert(Board::Endstop::MODER_OUTPUT == 0x55500000, "ENDSTOP occupies PE10-PE15");
+static_assert(Board::Uart4Pins::AFRL_FIELD == 0x000000FF, "UART4 pins are PA0-PA1");
@@ -0,0 +1,70 @@
+#include "boot_info.hpp"
+#include "constants.hpp"
+#include "protocol.hpp"
+#include "profiler.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+extern "C" unsigned int __vectors_start;
+
+uint32_t BootInfo::_rxArmedUs = 0;
+uint32_t BootInfo::_readyUs = 0;
+uint32_t BootInfo::_firstRxUs = 0;
+uint8_t BootInfo::_resetFlags = 0;
+
+// Замена weak-версии из system/src/cortexm/initialize-hardware.c:
+// то же самое плюс запуск CYCCNT как можно ближе к сбросу. Условия FPU и
+// OS_DEBUG_SEMIHOSTING_FAULTS - как в weak-версии, иначе сборка с
+// -mfloat-abi=hard упадет на первой инструкции FPU (UsageFault NOCP).
+extern "C" void __initialize_hardware_early(void) {
+    Profiler::enableCycleCounter();
+    DWT->CYCCNT = 0;
+
+    SystemInit();
+    SCB->VTOR = reinterpret_cast<uint32_t>(&__vectors_start);
+
+#if defined(OS_INCLUDE_STARTUP_INIT_FP) || (defined(__VFP_FP__) && !defined(__SOFTFP__))
+    // CP10 и CP11 - доступ к FPU
+    SCB->CPACR |= (0xF << 20);
+#endif
+
+#if defined(OS_DEBUG_SEMIHOSTING_FAULTS)
+    SCB->SHCSR |= SCB_SHCSR_USGFAULTENA_Msk;
+#endif
+}
+
+// CYCCNT на 16 МГц переполняется через ~268 с, дальше считаем по SysTick.
+// SysTick запускается сразу после markReady(), поэтому к нему прибавляется _readyUs.
+uint32_t BootInfo::elapsedUs() {
+    constexpr uint32_t CYCCNT_SAFE_MS = 200000;
+    if (systemTicks < CYCCNT_SAFE_MS) {
+        return Profiler::cycles() / (SystemCoreClock / 1000000);
+    }
+    return systemTicks * 1000 + _readyUs;
+}
+
+void BootInfo::markRxArmed() {
+    _rxArmedUs = elapsedUs();
+
+    // Причина сброса: биты LPWR/WWDG/IWDG/SFT/POR/PIN/BOR, флаги затем очищаются
+    _resetFlags = static_cast<uint8_t>(RCC->CSR >> 24);
+    RCC->CSR |= RCC_CSR_RMVF;
+}
+
+void BootInfo::markReady() {
+    _readyUs = elapsedUs();
+}
+
+void BootInfo::markFirstRx() {
+    if (_firstRxUs == 0) {
+        _firstRxUs = elapsedUs();
+    }
+}
+
+uint8_t BootInfo::serialize(uint8_t* out) {
+    uint8_t* p = out;
+    p = putLe32(p, _rxArmedUs);
+    p = putLe32(p, _readyUs);
+    p = putLe32(p, _firstRxUs);
+    *p++ = _resetFlags;
+    return static_cast<uint8_t>(p - out);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// Размер ответа BOOT_INFO, раскладка - docs/COMMAND.md
+constexpr uint8_t BOOT_INFO_RESPONSE_SIZE = 13;
+
+/**
+ * Время старта от сброса до готовности принимать команды.
+ *
+ * Отсчет ведет DWT CYCCNT: счетчик обнуляется и запускается в
+ * __initialize_hardware_early(), до копирования .data и обнуления .bss.
+ * CYCCNT не сбрасывается системным сбросом, поэтому обнуление обязательно.
+ */
+class BootInfo {
+public:
+    static void markRxArmed();    // DMA приема UART4 запущен, байты не теряются
+    static void markReady();      // Вход в главный цикл, команды обрабатываются
+    static void markFirstRx();    // Первые байты от хоста (повторные вызовы игнорируются)
+    static bool hasFirstRx() { return _firstRxUs != 0; }
+    static uint8_t resetFlags() { return _resetFlags; }  // RCC_CSR[31:24], сняты в markRxArmed()
+
+    /**
+     * @brief Сериализация ответа BOOT_INFO (little-endian)
+     * @param out Буфер не меньше BOOT_INFO_RESPONSE_SIZE
+     * @return Количество записанных байт
+     */
+    static uint8_t serialize(uint8_t* out);
+
+private:
+    static uint32_t elapsedUs();
+
+    static uint32_t _rxArmedUs;
+    static uint32_t _readyUs;
+    static uint32_t _firstRxUs;
+    static uint8_t _resetFlags;
+};
@@ -21,13 +21,70 @@ constexpr uint16_t PROTOCOL_MIN_PACKET_SIZE = 5;
 constexpr uint16_t PROTOCOL_MAX_PACKET_SIZE = 256;
 constexpr uint8_t PROTOCOL_HEADER_SIZE = 4;
 
+// ============================================================================
+// Режим COBS (согласуется командой SESSION)
+// ============================================================================
+// Формат: COBS([Length_H] [Length_L] [Cmd] [Data...] [XOR]) [0x00]
+// - содержимое то же, что у обычного пакета, но без STX
+// - 0x00 встречается только как разделитель, ресинхронизация - до следующего нуля
+// - накладные расходы COBS: не более 1 байта на 254 (~0.4%)
+// ============================================================================
+
+constexpr uint8_t PROTOCOL_COBS_DELIMITER = 0x00;
+constexpr uint16_t PROTOCOL_COBS_MAX_FRAME_SIZE =
+    (PROTOCOL_MAX_PACKET_SIZE - 1) + (PROTOCOL_MAX_PACKET_SIZE - 1) / 254 + 1;
+// Буфер парсера: байт под STX + самый длинный COBS-кадр
+constexpr uint16_t PROTOCOL_BUFFER_SIZE = 1 + PROTOCOL_COBS_MAX_FRAME_SIZE;
+
+// ============================================================================
+// Режим CRC-32 (согласуется командой SESSION)
+// ============================================================================
+// Вместо XOR в конце кадра 4 байта CRC-32 (little-endian), Length их учитывает.
+// CRC считается аппаратным блоком по тем же байтам, что и XOR (Length_H..Data),
+// см. crc32.hpp
+// ============================================================================
+
+constexpr uint8_t PROTOCOL_CRC_SIZE = 4;
+
+// Данных в одном ответе при любом режиме сессии
+constexpr uint16_t PROTOCOL_MAX_DATA_SIZE = PROTOCOL_MAX_PACKET_SIZE - PROTOCOL_HEADER_SIZE - PROTOCOL_CRC_SIZE;
+
+// Флаги сессии
+namespace Session {
+    constexpr uint8_t COBS_FRAMING = 0x01;
+    constexpr uint8_t CRC32        = 0x02;
+    constexpr uint8_t SUPPORTED    = COBS_FRAMING | CRC32;
+}
+
+// Межбайтовый таймаут: незавершенный кадр сбрасывается, если линия молчит дольше.
+// Больше latency timer FTDI (16 мс), иначе кадр рвется на границе USB-пакетов.
+constexpr uint32_t PROTOCOL_INTERBYTE_TIMEOUT_MS = 20;
+
 // Коды команд (TX от PC к MCU)
 namespace Cmd {
     constexpr uint8_t VERSION    = 0x01;
     constexpr uint8_t STATUS     = 0x02;
     constexpr uint8_t STOP       = 0x03;
+    constexpr uint8_t SESSION    = 0x04;
+    constexpr uint8_t STATS      = 0x05;
+    constexpr uint8_t BOOT_INFO  = 0x06;
+    constexpr uint8_t PROFILE    = 0x07;
+    constexpr uint8_t SAMPLES    = 0x08;
+    constexpr uint8_t TRACE_READ = 0x09;  // Не TRACE: макрос -DTRACE из subdir.mk
+    constexpr uint8_t LOG        = 0x0A;
+    constexpr uint8_t LINK_STATS = 0x0B;
+    constexpr uint8_t SUBSCRIBE  = 0x0C;
+    constexpr uint8_t WAIT_EVENT = 0x0D;
     constexpr uint8_t SYNC_MOVE  = 0x10;
     constexpr uint8_t ASYNC_MOVE = 0x11;
+    constexpr uint8_t PROFILE_MOVE  = 0x12;
+    constexpr uint8_t COMPACT_MOVE  = 0x13;
+    constexpr uint8_t LINEAR_MOVE   = 0x14;
+    constexpr uint8_t SEGMENT_MOVE  = 0x15;
+    constexpr uint8_t VELOCITY      = 0x16;
+    constexpr uint8_t VELOCITY_SET  = 0x17;  // Без ответа, кроме ошибки
+    constexpr uint8_t PROFILE_STORE = 0x18;
+    constexpr uint8_t SEQUENCE   = 0x20;
 }
 
 // Коды ответов (RX от MCU к PC)
@@ -35,7 +92,22 @@ namespace Response {
     constexpr uint8_t VERSION    = 0x81;
     constexpr uint8_t STATUS     = 0x82;
     constexpr uint8_t STOP       = 0x83;
+    constexpr uint8_t SESSION    = 0x84;
+    constexpr uint8_t STATS      = 0x85;
+    constexpr uint8_t BOOT_INFO  = 0x86;
+    constexpr uint8_t PROFILE    = 0x87;
+    constexpr uint8_t SAMPLES    = 0x88;
+    constexpr uint8_t TRACE_READ = 0x89;
+    constexpr uint8_t LOG        = 0x8A;
+    constexpr uint8_t LINK_STATS = 0x8B;
+    constexpr uint8_t SUBSCRIBE  = 0x8C;
+    constexpr uint8_t WAIT_EVENT = 0x8D;  // Отложенный: после события или таймаута
     constexpr uint8_t MOVE       = 0x90;
+    constexpr uint8_t SEGMENT_MOVE  = 0x95;
+    constexpr uint8_t VELOCITY      = 0x96;
+    constexpr uint8_t PROFILE_STORE = 0x98;
+    constexpr uint8_t SEQUENCE   = 0xA0;
+    constexpr uint8_t TELEMETRY  = 0xC0;  // Без запроса, после SUBSCRIBE
     constexpr uint8_t ERROR      = 0xFF;
 }
 
@@ -46,18 +118,83 @@ namespace Error {
     constexpr uint8_t XOR_CHECKSUM_ERROR    = 0x03;
     constexpr uint8_t INVALID_MOTOR_COUNT   = 0x04;
     constexpr uint8_t MOTOR_PARAM_ERROR     = 0x05;
+    constexpr uint8_t FRAME_TIMEOUT         = 0x06;
+    constexpr uint8_t CRC_CHECKSUM_ERROR    = 0x07;
     constexpr uint8_t EMERGENCY_STOP        = 0x0B;
     constexpr uint8_t TIMEOUT               = 0x0D;
+    constexpr uint8_t STREAM_INACTIVE       = 0x0E;  // VELOCITY_SET без VELOCITY START
+}
+
+// Причина MOTOR_PARAM_ERROR: ERROR = code u8 | reason u8 | index u8 (номер записи в кадре)
+namespace ParamFault {
+    constexpr uint8_t NONE      = 0x00;
+    constexpr uint8_t NUMBER    = 0x01;  // Номер мотора вне 1..MAX_MOTORS
+    constexpr uint8_t ACCEL     = 0x02;  // Нулевое ускорение
+    constexpr uint8_t SPEED     = 0x03;  // Нулевая скорость; в VELOCITY_SET - выше STEP_MAX_RATE_HZ
+    constexpr uint8_t DUPLICATE = 0x04;  // Мотор уже был в этом кадре
+    constexpr uint8_t RESERVED  = 0x05;  // Мотор в BOARD_RESERVED_MOTORS
+    constexpr uint8_t ENCODING  = 0x06;  // COMPACT_MOVE: запись обрезана, поле шире 32 бит или нет в кэше
+    constexpr uint8_t PROFILE   = 0x07;  // PROFILE_MOVE: профиля нет в библиотеке
+    constexpr uint8_t PATH      = 0x08;  // LINEAR_MOVE: нулевые ускорение или скорость пути
+    constexpr uint8_t STREAM    = 0x09;  // VELOCITY_SET: мотор не на STEP/DIR-канале
 }
 
 // Коды результата
 namespace Result {
     constexpr uint8_t SUCCESS = 0x00;
     constexpr uint8_t BUSY    = 0x01;
+    constexpr uint8_t FAULT   = 0x02;  // SEGMENT_MOVE: мотор завершился аварийно, остаток не запущен
+}
+
+// Режим PROFILE_MOVE, COMPACT_MOVE и LINEAR_MOVE (первый байт данных)
+namespace MoveMode {
+    constexpr uint8_t ASYNC = 0x00;
+    constexpr uint8_t SYNC  = 0x01;
 }
 
-// Максимальное количество моторов
-constexpr uint8_t MAX_MOTORS = 10;
+// Количество моторов - параметр платы, задается при сборке: -DBOARD_MAX_MOTORS=N.
+// Предел 64 - ширина масок протокола; распиновка в board.hpp дает 10 каналов.
+#ifndef BOARD_MAX_MOTORS
+#define BOARD_MAX_MOTORS 10
+#endif
+
+constexpr uint8_t MAX_MOTORS = BOARD_MAX_MOTORS;
+static_assert(MAX_MOTORS >= 1 && MAX_MOTORS <= 64, "BOARD_MAX_MOTORS must be 1..64");
+
+// Битовая маска моторов (бит m-1 - мотор m): самый узкий тип на MAX_MOTORS бит.
+// Для 10 моторов - uint16_t, как и раньше: ни памяти, ни тактов сверху.
+template <bool Fits16, bool Fits32>
+struct MotorMaskSelect { typedef uint64_t Type; };
+template <bool Fits32>
+struct MotorMaskSelect<true, Fits32> { typedef uint16_t Type; };
+template <>
+struct MotorMaskSelect<false, true> { typedef uint32_t Type; };
+
+typedef MotorMaskSelect<MAX_MOTORS <= 16, MAX_MOTORS <= 32>::Type MotorMask;
+
+// Ширина маски в ответах STATUS, TELEMETRY, WAIT_EVENT (little-endian)
+constexpr uint8_t MOTOR_MASK_SIZE = sizeof(MotorMask);
+constexpr MotorMask ALL_MOTORS_MASK =
+    static_cast<MotorMask>(static_cast<MotorMask>(~static_cast<MotorMask>(0)) >> (8 * MOTOR_MASK_SIZE - MAX_MOTORS));
+
+constexpr MotorMask motorBit(uint8_t index) {
+    return static_cast<MotorMask>(static_cast<MotorMask>(1) << index);
+}
+
+// Моторы, которые на этой плате нельзя двигать (снятые оси, занятые каналы):
+// -DBOARD_RESERVED_MOTORS=0x200 - мотор 10. Команды с ними отклоняются целиком.
+#ifndef BOARD_RESERVED_MOTORS
+#define BOARD_RESERVED_MOTORS 0
+#endif
+
+constexpr MotorMask RESERVED_MOTORS = static_cast<MotorMask>(BOARD_RESERVED_MOTORS);
+static_assert((static_cast<uint64_t>(BOARD_RESERVED_MOTORS) & ~static_cast<uint64_t>(ALL_MOTORS_MASK)) == 0,
+              "BOARD_RESERVED_MOTORS has bits above MAX_MOTORS");
+
+// Индекс младшего мотора в непустой маске (RBIT + CLZ на Cortex-M4)
+inline uint8_t lowestMotorIndex(MotorMask mask) {
+    return static_cast<uint8_t>(MOTOR_MASK_SIZE > 4 ? __builtin_ctzll(mask) : __builtin_ctz(static_cast<uint32_t>(mask)));
+}
 
 // Команда для драйвера мотора
 constexpr uint8_t DRIVER_CMD = 0x78;
@@ -70,6 +207,12 @@ extern uint8_t usart4_rx_array[256];
 extern uint8_t usart2_mrk;
 extern uint8_t usart4_mrk;
 
+// Флаги текущей сессии (Session::*), 0 - классический формат со STX
+extern volatile uint8_t sessionFlags;
+
+// Миллисекунды с момента старта (инкремент в SysTick_Handler)
+extern volatile uint32_t systemTicks;
+
 // Внешние переменные состояния из main.cpp
 extern volatile bool waitingForMotorData;
 extern volatile uint16_t expectedDataSize;
@@ -77,8 +220,8 @@ extern volatile uint32_t timeoutCounter;
 extern volatile bool timeoutOccurred;
 
 // Глобальные переменные для отслеживания состояния моторов
-extern volatile uint16_t activeMotors;        // Битовое поле активных моторов
-extern volatile uint16_t completedMotors;     // Битовое поле завершенных моторов
+extern volatile MotorMask activeMotors;       // Битовое поле активных моторов
+extern volatile MotorMask completedMotors;    // Битовое поле завершенных моторов
 extern volatile bool emergencyStop;           // Флаг аварийной остановки
 extern volatile uint8_t currentMotorCount;    // Количество моторов в текущей команде
-extern volatile uint16_t syncMotorBuffer;     // Битовое поле моторов для синхронного запуска
+extern volatile MotorMask syncMotorBuffer;    // Битовое поле моторов для синхронного запуска
@@ -0,0 +1,55 @@
+#include "crc32.hpp"
+#include "constants.hpp"
+#include "protocol.hpp"
+#include "profiler.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+uint32_t Crc32::_xorCycles = 0;
+uint32_t Crc32::_crcCycles = 0;
+
+void Crc32::init() {
+    RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+    CRC->CR = CRC_CR_RESET;
+}
+
+// То же, что LL_CRC_ResetCRCCalculationUnit / LL_CRC_FeedData32, но без
+// вызова функции на каждое слово при -O0
+uint32_t Crc32::compute(const uint8_t* data, uint16_t length) {
+    CRC->CR = CRC_CR_RESET;
+
+    uint16_t words = length / 4;
+    for (uint16_t i = 0; i < words; ++i) {
+        CRC->DR = __UNALIGNED_UINT32_READ(data + i * 4);
+    }
+
+    uint16_t tail = length % 4;
+    if (tail != 0) {
+        const uint8_t* p = data + words * 4;
+        uint32_t last = 0;
+        for (uint16_t i = 0; i < tail; ++i) {
+            last |= static_cast<uint32_t>(p[i]) << (i * 8);
+        }
+        CRC->DR = last;
+    }
+
+    return CRC->DR;
+}
+
+void Crc32::benchmark() {
+    static uint8_t sample[PROTOCOL_MAX_PACKET_SIZE];
+    for (uint16_t i = 0; i < PROTOCOL_MAX_PACKET_SIZE; ++i) {
+        sample[i] = static_cast<uint8_t>(i);
+    }
+
+    Profiler::enableCycleCounter();
+
+    volatile uint32_t sink;
+    uint32_t start = Profiler::cycles();
+    sink = calculateXor(sample, PROTOCOL_MAX_PACKET_SIZE);
+    _xorCycles = Profiler::cycles() - start;
+
+    start = Profiler::cycles();
+    sink = compute(sample, PROTOCOL_MAX_PACKET_SIZE);
+    _crcCycles = Profiler::cycles() - start;
+    (void)sink;
+}
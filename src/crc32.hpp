@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * CRC-32 на аппаратном блоке CRC STM32F4.
+ *
+ * Полином 0x04C11DB7, начальное значение 0xFFFFFFFF, без отражения и без
+ * финального XOR (CRC-32/MPEG-2). Блок принимает только 32-битные слова:
+ * байты упаковываются в слова little-endian, хвост дополняется нулями.
+ * Табличная реализация того же алгоритма на хосте - scripts/squid/packet.py.
+ */
+class Crc32 {
+public:
+    static void init();
+    static uint32_t compute(const uint8_t* data, uint16_t length);
+
+    /**
+     * @brief Замер тактов (DWT CYCCNT) для кадра максимальной длины:
+     *        программный XOR против аппаратного CRC
+     */
+    static void benchmark();
+    static uint32_t getXorCycles() { return _xorCycles; }
+    static uint32_t getCrcCycles() { return _crcCycles; }
+
+private:
+    static uint32_t _xorCycles;
+    static uint32_t _crcCycles;
+};
@@ -0,0 +1,43 @@
+#include "event_wait.hpp"
+#include "motor_driver.hpp"
+#include "serial.hpp"
+#include "protocol.hpp"
+
+bool EventWait::_armed = false;
+MotorMask EventWait::_mask = 0;
+uint16_t EventWait::_timeoutMs = 0;
+uint32_t EventWait::_start = 0;
+
+void EventWait::arm(MotorMask mask, uint16_t timeoutMs, uint32_t now) {
+    _mask = mask;
+    _timeoutMs = timeoutMs;
+    _start = now;
+    _armed = true;
+    poll(now);  // Событие уже накоплено - ответ сразу
+}
+
+void EventWait::poll(uint32_t now) {
+    if (!_armed) {
+        return;
+    }
+
+    MotorMask fired = g_motorDriver.takeEvents(_mask);
+    if (fired != 0) {
+        respond(WaitStatus::EVENT, fired);
+    } else if (now - _start >= _timeoutMs) {
+        respond(WaitStatus::TIMEOUT, 0);
+    }
+}
+
+void EventWait::respond(uint8_t status, MotorMask fired) {
+    _armed = false;
+
+    uint8_t response[WAIT_EVENT_RESPONSE_SIZE];
+    uint8_t* p = response;
+    *p++ = status;
+    p = putMotorMask(p, fired);
+    p = putMotorMask(p, g_motorDriver.getFaultedMotors() & fired);
+    p = putMotorMask(p, g_motorDriver.getActiveMotors());
+    p = putMotorMask(p, g_motorDriver.getCompletedMotors());
+    sendPacket(Response::WAIT_EVENT, response, sizeof(response));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+
+// Размер ответа WAIT_EVENT: status u8, маски fired, faulted, active, completed
+// (по MOTOR_MASK_SIZE байт; для 10 моторов - 9 байт)
+constexpr uint8_t WAIT_EVENT_RESPONSE_SIZE = 1 + 4 * MOTOR_MASK_SIZE;
+
+// Поле status ответа WAIT_EVENT
+namespace WaitStatus {
+    constexpr uint8_t EVENT   = 0x00;
+    constexpr uint8_t TIMEOUT = 0x01;
+}
+
+/**
+ * Long-poll WAIT_EVENT: ответ откладывается до завершения (или аварии)
+ * любого мотора из маски либо до таймаута.
+ *
+ * Ожидание не блокирует главный цикл: команда только запоминает маску,
+ * остальные команды обрабатываются как обычно, а poll() отвечает, когда
+ * путь завершения MotorDriver отметил событие. Событие, случившееся до
+ * прихода WAIT_EVENT, не теряется - MotorDriver копит его до запроса.
+ * Ожидание одно: новый WAIT_EVENT заменяет предыдущий.
+ */
+class EventWait {
+public:
+    static void arm(MotorMask mask, uint16_t timeoutMs, uint32_t now);
+    static void poll(uint32_t now);
+    static bool isArmed() { return _armed; }
+
+private:
+    static void respond(uint8_t status, MotorMask fired);
+
+    static bool _armed;
+    static MotorMask _mask;
+    static uint16_t _timeoutMs;
+    static uint32_t _start;
+};
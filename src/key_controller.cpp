@@ -1,27 +1,53 @@
 #include "key_controller.hpp"
 #include "constants.hpp"
-#include "../system/include/cmsis/stm32f4xx.h"
+#include "board.hpp"
+#include "shift_out.hpp"
 
+#if BOARD_SHIFT_OUT
+
+// Линия меняется в теневом образе, на выходе - после защелки (~8 мкс на 64 линии)
+void KeyController::setKey(uint8_t motorNum, bool state) {
+    if (motorNum < 1 || motorNum > MAX_MOTORS) {
+        return;
+    }
+    ShiftOut::write(ShiftLine::KEY + motorNum - 1, state);
+}
+
+void KeyController::clearAll() {
+    ShiftOut::writeGroup(ShiftLine::KEY, MAX_MOTORS, 0);
+}
+
+bool KeyController::isKeySet(uint8_t motorNum) {
+    if (motorNum < 1 || motorNum > MAX_MOTORS) {
+        return false;
+    }
+    return ShiftOut::read(ShiftLine::KEY + motorNum - 1);
+}
+
+#else
+
+// KEY и светодиоды меняются из ISR, поэтому только записи BSRR, без RMW ODR
 void KeyController::setKey(uint8_t motorNum, bool state) {
     if (motorNum < 1 || motorNum > MAX_MOTORS) {
         return;
     }
-    uint8_t pin = motorNum - 1;
+    uint32_t bit = 1UL << (motorNum - 1);
     if (state) {
-        GPIOB->ODR |= (1UL << pin);
+        Board::Key::set(bit);
     } else {
-        GPIOB->ODR &= ~(1UL << pin);
+        Board::Key::clear(bit);
     }
 }
 
 void KeyController::clearAll() {
-    GPIOB->ODR &= ~0x3FF;
+    Board::Key::clearAll();
 }
 
 bool KeyController::isKeySet(uint8_t motorNum) {
     if (motorNum < 1 || motorNum > MAX_MOTORS) {
         return false;
     }
-    uint8_t pin = motorNum - 1;
-    return (GPIOB->ODR & (1UL << pin)) != 0;
+    return (Board::Key::readOutput() & (1UL << (motorNum - 1))) != 0;
 }
+
+#endif
@@ -2,9 +2,28 @@
 
 #include <cstdint>
 
+#include "board.hpp"
+#include "shift_out.hpp"
+
+/**
+ * Линии KEY моторов. Бэкенд выбирается при сборке: банк GPIO (PB0-PB9)
+ * или цепочка 74HC595 (BOARD_SHIFT_OUT), интерфейс одинаковый.
+ */
 class KeyController {
 public:
     static void setKey(uint8_t motorNum, bool state);
+
+    // Мотор известен при компиляции: одна запись константы в BSRR
+    template <uint8_t MotorNum>
+    static void setKey(bool state) {
+        static_assert(MotorNum >= 1 && MotorNum <= MAX_MOTORS, "Motor number out of range");
+#if BOARD_SHIFT_OUT
+        ShiftOut::write(ShiftLine::KEY + MotorNum - 1, state);
+#else
+        Board::Key::At<MotorNum - 1>::write(state);
+#endif
+    }
+
     static void clearAll();
     static bool isKeySet(uint8_t motorNum);
 };
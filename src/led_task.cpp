@@ -0,0 +1,32 @@
+#include "led_task.hpp"
+#include "board.hpp"
+
+uint8_t LedTask::_phase = 0;
+uint32_t LedTask::_lastToggle = 0;
+
+void LedTask::start(uint32_t now) {
+    _phase = BLINK_COUNT * 2;
+    _lastToggle = now;
+    Board::StartupBlink::setAll();
+}
+
+void LedTask::update(uint32_t now) {
+    if (_phase == 0 || now - _lastToggle < HALF_PERIOD_MS) {
+        return;
+    }
+
+    _lastToggle = now;
+    --_phase;
+    if (_phase & 1) {
+        Board::StartupBlink::clearAll();  // Погасить
+    } else if (_phase != 0) {
+        Board::StartupBlink::setAll();    // Зажечь
+    }
+}
+
+void LedTask::cancel() {
+    if (_phase != 0) {
+        _phase = 0;
+        Board::StartupBlink::clearAll();
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Стартовое мигание PB0-PB2 без блокировки главного цикла.
+ *
+ * PB0-PB2 - это KEY1-3 драйверов, поэтому мигание прекращается (пины в LOW)
+ * при первом байте от хоста, чтобы не мешать KeyController.
+ */
+class LedTask {
+public:
+    static void start(uint32_t now);
+    static void update(uint32_t now);
+    static void cancel();
+
+private:
+    static constexpr uint8_t BLINK_COUNT = 3;
+    static constexpr uint32_t HALF_PERIOD_MS = 100;
+
+    static uint8_t _phase;   // Оставшиеся полупериоды, 0 - задача завершена
+    static uint32_t _lastToggle;
+};
@@ -0,0 +1,89 @@
+#include "linear_planner.hpp"
+#include "protocol.hpp"
+
+// Квадраты сдвинутых модулей меньше 2^56: сумма 64 осей не переполнит uint64
+static constexpr uint8_t SQUARE_BITS = 28;
+
+uint32_t LinearPlanner::isqrt(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return static_cast<uint32_t>(result);
+}
+
+uint32_t LinearPlanner::pathLength(const uint32_t* magnitudes, uint8_t count) {
+    uint32_t longest = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        if (magnitudes[i] > longest) {
+            longest = magnitudes[i];
+        }
+    }
+
+    uint8_t shift = 0;
+    while ((longest >> shift) >= (1U << SQUARE_BITS)) {
+        shift++;
+    }
+
+    uint64_t sum = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        uint64_t m = magnitudes[i] >> shift;
+        sum += m * m;
+    }
+
+    // Сдвиг теряет младшие биты: длина не должна выйти короче самой длинной оси
+    uint64_t length = static_cast<uint64_t>(isqrt(sum)) << shift;
+    if (length < longest) {
+        return longest;
+    }
+    return length > 0xFFFFFFFFULL ? 0xFFFFFFFFU : static_cast<uint32_t>(length);
+}
+
+// value * magnitude / length с округлением; ось с шагами не получает 0
+uint32_t LinearPlanner::share(uint32_t value, uint32_t magnitude, uint32_t length) {
+    if (magnitude == 0 || length == 0) {
+        return value;  // Ось без шагов: параметры не влияют, лишь бы прошли проверку
+    }
+    uint64_t scaled = (static_cast<uint64_t>(value) * magnitude + length / 2) / length;
+    return scaled != 0 ? static_cast<uint32_t>(scaled) : 1;
+}
+
+uint8_t LinearPlanner::plan(const uint8_t* axes, uint8_t count, uint32_t acceleration,
+                            uint32_t speed, uint8_t* out, uint8_t* badIndex) {
+    *badIndex = 0;
+    if (acceleration == 0 || speed == 0) {
+        return ParamFault::PATH;
+    }
+
+    uint32_t magnitudes[MAX_MOTORS];
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint8_t* axis = axes + i * LINEAR_AXIS_SIZE;
+        if (axis[0] < 1 || axis[0] > MAX_MOTORS) {
+            *badIndex = i;
+            return ParamFault::NUMBER;
+        }
+        uint32_t steps = getLe32(axis + 1);
+        magnitudes[i] = (steps & 0x80000000U) ? 0U - steps : steps;
+    }
+
+    uint32_t length = pathLength(magnitudes, count);
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint8_t* axis = axes + i * LINEAR_AXIS_SIZE;
+        uint8_t* p = out + i * 16;
+        p = putLe32(p, axis[0]);
+        p = putLe32(p, share(acceleration, magnitudes[i], length));
+        p = putLe32(p, share(speed, magnitudes[i], length));
+        putLe32(p, getLe32(axis + 1));
+    }
+    return ParamFault::NONE;
+}
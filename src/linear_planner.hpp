@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+
+// Заголовок LINEAR_MOVE: mode u8 + accel u32 + speed u32 (по пути)
+constexpr uint8_t LINEAR_HEADER_SIZE = 9;
+// Ось LINEAR_MOVE: motor u8 + steps i32
+constexpr uint8_t LINEAR_AXIS_SIZE = 5;
+
+/**
+ * Планировщик согласованного линейного движения.
+ *
+ * Хост задает шаги по осям и ускорение/скорость вдоль пути, длина пути
+ * L = sqrt(sum steps^2). Ось i получает accel * |s_i| / L и
+ * speed * |s_i| / L: у всех осей одна и та же трапеция по времени
+ * (разгон speed / accel, тот же крейсерский участок), и оси приходят
+ * одновременно.
+ *
+ * Только целая арифметика (сборка -mfloat-abi=soft): корень - побитовый,
+ * доли - 64-битное умножение и деление с округлением. Ошибка округления -
+ * не больше 0.5 шаг/с и шаг/с^2 на ось, для медленных осей она заметнее.
+ */
+class LinearPlanner {
+public:
+    /**
+     * @brief Развернуть оси в записи MotorParams для startMotors()
+     * @param axes Оси по LINEAR_AXIS_SIZE байт
+     * @param out count записей по 16 байт
+     * @param badIndex Номер неверной оси (для PATH - 0)
+     * @return ParamFault::NONE, PATH или NUMBER (остальное - validateBatch())
+     */
+    static uint8_t plan(const uint8_t* axes, uint8_t count, uint32_t acceleration,
+                        uint32_t speed, uint8_t* out, uint8_t* badIndex);
+
+    // Целый корень, округленный вниз (побитовый, без деления)
+    static uint32_t isqrt(uint64_t value);
+
+private:
+    // Длина пути в шагах: корень суммы квадратов, не меньше max |s_i|
+    static uint32_t pathLength(const uint32_t* magnitudes, uint8_t count);
+    static uint32_t share(uint32_t value, uint32_t magnitude, uint32_t length);
+};
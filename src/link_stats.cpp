@@ -0,0 +1,35 @@
+#include "link_stats.hpp"
+#include "uart_dma.hpp"
+#include "protocol.hpp"
+
+extern PacketParser g_packetParser;
+
+uint8_t LinkStats::serialize(uint8_t* out) {
+    const UartDmaErrors& errors = g_uartDma.getErrors();
+
+    uint8_t* p = out;
+    p = putLe32(p, UART_DMA_BAUDRATE);
+    p = putLe32(p, errors.uartOverrun);
+    p = putLe32(p, errors.uartFraming);
+    p = putLe32(p, errors.uartNoise);
+    p = putLe32(p, errors.dmaRxTransfer);
+    p = putLe32(p, errors.dmaRxDirect);
+    p = putLe32(p, errors.dmaRxFifo);
+    p = putLe32(p, errors.dmaTxTransfer);
+    p = putLe32(p, errors.rxRingOverflow);
+    p = putLe32(p, errors.rxRestarts);
+    p = putLe32(p, g_packetParser.acceptedFrames);
+    p = putLe32(p, g_packetParser.lengthErrors);
+    p = putLe32(p, g_packetParser.xorErrors);
+    p = putLe32(p, g_packetParser.crcErrors);
+    p = putLe32(p, g_packetParser.abortedFrames);
+    p = putLe32(p, g_packetParser.resyncedFrames);
+    return static_cast<uint8_t>(p - out);
+}
+
+// Парсер работает только в главном цикле, его счетчики сбрасываются без
+// запрета прерываний
+void LinkStats::clear() {
+    g_uartDma.clearErrors();
+    g_packetParser.clearCounters();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// Размер ответа LINK_STATS, раскладка - docs/COMMAND.md
+constexpr uint8_t LINK_STATS_RESPONSE_SIZE = 64;
+
+// Подкоманды LINK_STATS (первый байт данных, без данных - READ)
+namespace LinkStatsOp {
+    constexpr uint8_t READ  = 0x00;
+    constexpr uint8_t CLEAR = 0x01;
+}
+
+/**
+ * Состояние линии с ПК: ошибки UART4 и DMA (UartDma) и отказы парсера
+ * кадров (PacketParser). Перед повышением скорости линии счетчики ошибок
+ * должны оставаться нулевыми на длинном прогоне.
+ */
+class LinkStats {
+public:
+    /**
+     * @brief Сериализация ответа LINK_STATS (little-endian)
+     * @param out Буфер не меньше LINK_STATS_RESPONSE_SIZE
+     * @return Количество записанных байт
+     */
+    static uint8_t serialize(uint8_t* out);
+    static void clear();
+};
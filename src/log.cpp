@@ -0,0 +1,111 @@
+#include "log.hpp"
+#include "constants.hpp"
+#include "protocol.hpp"
+#include "memory_sections.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+#include <cstring>
+#include <sys/types.h>
+
+CCMRAM_BSS Log::Record Log::_ring[LOG_RING_SIZE];
+uint32_t Log::_head = 0;
+uint32_t Log::_tail = 0;
+uint32_t Log::_dropped = 0;
+
+// Заголовок ответа READ: dropped u16, count u8
+constexpr uint16_t LOG_HEADER_SIZE = 3;
+
+void Log::writeRecord(uint16_t id, const uint32_t* args, uint8_t argc) {
+    Record entry;
+    entry.ticks = systemTicks;
+    entry.id = id;
+    entry.argc = argc;
+    for (uint8_t i = 0; i < argc; ++i) {
+        entry.args[i] = args[i];
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    push(entry);
+    __set_PRIMASK(primask);
+}
+
+void Log::writeText(const char* text, size_t length) {
+    while (length > 0) {
+        uint8_t chunk = length > LOG_TEXT_CHUNK ? LOG_TEXT_CHUNK : static_cast<uint8_t>(length);
+
+        Record entry;
+        entry.ticks = systemTicks;
+        entry.id = LOG_TEXT_ID;
+        entry.argc = chunk;
+        std::memcpy(entry.args, text, chunk);
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        push(entry);
+        __set_PRIMASK(primask);
+
+        text += chunk;
+        length -= chunk;
+    }
+}
+
+// Вызывать с запрещенными прерываниями. Переполнение затирает старые записи
+void Log::push(const Record& entry) {
+    if (_head - _tail == LOG_RING_SIZE) {
+        _tail++;
+        _dropped++;
+    }
+    _ring[_head++ % LOG_RING_SIZE] = entry;
+}
+
+// Запись: ticks u32, id u16, n u8, затем n*u32 аргументов или n байт текста
+uint16_t Log::drain(uint8_t* out, uint16_t capacity) {
+    uint8_t* p = out + LOG_HEADER_SIZE;
+    uint8_t count = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    while (_tail != _head) {
+        const Record& entry = _ring[_tail % LOG_RING_SIZE];
+        uint16_t payload = (entry.id == LOG_TEXT_ID) ? entry.argc : entry.argc * 4;
+        if ((out + capacity) - p < 7 + payload) {
+            break;
+        }
+
+        p = putLe32(p, entry.ticks);
+        p = putLe16(p, entry.id);
+        *p++ = entry.argc;
+        if (entry.id == LOG_TEXT_ID) {
+            std::memcpy(p, entry.args, entry.argc);
+            p += entry.argc;
+        } else {
+            for (uint8_t i = 0; i < entry.argc; ++i) {
+                p = putLe32(p, entry.args[i]);
+            }
+        }
+        _tail++;
+        count++;
+    }
+    uint16_t dropped = _dropped > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(_dropped);
+    _dropped = 0;
+    __set_PRIMASK(primask);
+
+    uint8_t* h = putLe16(out, dropped);
+    *h = count;
+
+    return static_cast<uint16_t>(p - out);
+}
+
+void Log::clear() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    _tail = _head;
+    _dropped = 0;
+    __set_PRIMASK(primask);
+}
+
+// Бэкенд trace_write() для system/src/diag/trace-impl.c (OS_USE_TRACE_RAM_RING)
+extern "C" ssize_t log_trace_write(const char* buf, size_t nbyte) {
+    Log::writeText(buf, nbyte);
+    return static_cast<ssize_t>(nbyte);
+}
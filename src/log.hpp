@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Кольцо записей журнала (CCMRAM), до 4 аргументов u32 на запись
+constexpr uint8_t LOG_RING_SIZE = 128;
+constexpr uint8_t LOG_MAX_ARGS = 4;
+constexpr uint8_t LOG_TEXT_CHUNK = LOG_MAX_ARGS * 4;
+
+// Запись с готовым текстом (trace_printf/printf), а не с форматом
+constexpr uint16_t LOG_TEXT_ID = 0xFFFF;
+
+// Подкоманды LOG (первый байт данных, без данных - READ)
+namespace LogOp {
+    constexpr uint8_t READ  = 0x00;
+    constexpr uint8_t CLEAR = 0x01;
+}
+
+/**
+ * Журнал с отложенным форматированием.
+ *
+ * LOG("fmt", args...) не форматирует строку на MCU: в кольцо пишется только
+ * метка времени (мс), ID формата и аргументы, за постоянное время.
+ * Строка формата кладется в секцию .log_fmt, которая не загружается во FLASH
+ * (INFO в sections.ld), и ID - это ее смещение в секции. Хост читает
+ * таблицу форматов из main.elf (scripts/squid/logfmt.py) и форматирует сам.
+ *
+ * Аргументы - целые до 32 бит; %d на хосте трактуется как знаковое.
+ */
+class Log {
+public:
+    static void write(uint16_t id) { writeRecord(id, nullptr, 0); }
+
+    template <typename... Args>
+    static void write(uint16_t id, Args... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "LOG supports up to 4 arguments");
+        const uint32_t values[] = {static_cast<uint32_t>(args)...};
+        writeRecord(id, values, sizeof...(Args));
+    }
+
+    // Сырой текст по кускам LOG_TEXT_CHUNK байт (бэкенд trace_write)
+    static void writeText(const char* text, size_t length);
+
+    /**
+     * @brief Выдать и удалить из кольца самые старые записи
+     * @return Количество записанных байт
+     */
+    static uint16_t drain(uint8_t* out, uint16_t capacity);
+    static void clear();
+
+private:
+    struct Record {
+        uint32_t ticks;
+        uint16_t id;
+        uint8_t argc;  // Аргументов, у LOG_TEXT_ID - байт текста
+        uint32_t args[LOG_MAX_ARGS];
+    };
+
+    static void writeRecord(uint16_t id, const uint32_t* args, uint8_t argc);
+    static void push(const Record& entry);
+
+    static Record _ring[LOG_RING_SIZE];
+    static uint32_t _head;
+    static uint32_t _tail;
+    static uint32_t _dropped;
+};
+
+#define LOG(fmt, ...)                                                                  \
+    do {                                                                               \
+        static const char logFormat_[] __attribute__((section(".log_fmt"), used)) = fmt; \
+        Log::write(static_cast<uint16_t>(reinterpret_cast<uintptr_t>(logFormat_)), ##__VA_ARGS__); \
+    } while (0)
@@ -2,12 +2,29 @@
 #include "motor_controller.hpp"
 #include "constants.hpp"
 #include "gpio.hpp"
+#include "board.hpp"
 #include "protocol.hpp"
 #include "motor_driver.hpp"
 #include "uart_dma.hpp"
 #include "serial.hpp"
-
-PacketParser g_packetParser;
+#include "crc32.hpp"
+#include "memory_stats.hpp"
+#include "memory_sections.hpp"
+#include "boot_info.hpp"
+#include "led_task.hpp"
+#include "profiler.hpp"
+#include "pc_sampler.hpp"
+#include "trace.hpp"
+#include "log.hpp"
+#include "telemetry.hpp"
+#include "event_wait.hpp"
+#include "shift_out.hpp"
+#include "sequencer.hpp"
+#include "motion_profiles.hpp"
+#include "step_dir.hpp"
+#include "velocity_stream.hpp"
+
+CCMRAM_BSS PacketParser g_packetParser;
 volatile bool g_packetReady = false;
 
 void clear_usart4_rx_array() {
@@ -42,58 +59,130 @@ void SystemClock_HSI_Config(void) {
 void SysTick_Init(void) {
     SysTick->LOAD = (SystemCoreClock / 1000) - 1;
     SysTick->VAL = 0;
+    // Ниже всех: MotorDriver ждет в SysTick передачу пакета драйверу (2-3 мс),
+    // а кольцо StepDir, прием UART4 и PC-сэмплер столько ждать не могут
+    NVIC_SetPriority(SysTick_IRQn, 8);
     SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
 }
 
 int main(void) {
     SystemClock_HSI_Config();
-    clear_usart4_rx_array();
     initGPIO();
-    initSerial();
-    SysTick_Init();
-
-    RCC->AHB1ENR |= RCC_AHB1ENR_GPIODEN;
-    GPIOD->MODER |= GPIO_MODER_MODER12_0 | GPIO_MODER_MODER13_0 | GPIO_MODER_MODER14_0 | GPIO_MODER_MODER15_0;
-    GPIOD->ODR |= GPIO_ODR_OD12 | GPIO_ODR_OD13 | GPIO_ODR_OD14 | GPIO_ODR_OD15;
 
+    // Прием от ПК запускается первым: дальше байты копятся в кольце DMA,
+    // даже если остальная инициализация еще идет
     g_uartDma.init();
     g_uartDma.startRx();
+    BootInfo::markRxArmed();
 
-    for (uint8_t k = 0; k < 3; ++k) {
-        GPIOB->ODR |= (1UL << 0) | (1UL << 1) | (1UL << 2);
-        for (volatile uint32_t i = 0; i < 100000; ++i);
-        GPIOB->ODR &= ~((1UL << 0) | (1UL << 1) | (1UL << 2));
-        for (volatile uint32_t i = 0; i < 100000; ++i);
-    }
+    initSerial();
+    Crc32::init();
+    Crc32::benchmark();
+    MotionProfiles::init();
+    PcSampler::init();
+#if BOARD_STEP_DIR
+    StepDir::init();
+#endif
+
+    Board::Leds::configureOutput();
+    Board::Leds::setAll();
+
+    // Кадры инициализации уже сняты со стека, их глубина мала и в
+    // high-water mark не попадает
+    MemoryStats::paintStack();
+
+    BootInfo::markReady();
+    SysTick_Init();
+    LedTask::start(systemTicks);
+    LOG("boot: reset flags 0x%02x", BootInfo::resetFlags());
 
+    bool rxStalled = false;
     while (1) {
-        if (g_uartDma.hasPendingRxData()) {
+        if (g_uartDma.hasPendingRxData() || g_packetParser.hasCarry()) {
+            if (!BootInfo::hasFirstRx()) {
+                BootInfo::markFirstRx();
+                LedTask::cancel();
+            }
+            g_uartDma.processRxData();
+        }
+
+        // Линия замолчала (IDLE) посреди кадра - по межбайтовому таймауту
+        // сбрасываем кадр и ищем STX среди уже принятых байтов. IDLE
+        // приходит один раз, поэтому таймаут ждем, пока кадр не закончится
+        if (g_uartDma.takeLineIdle()) {
+            rxStalled = true;
+        }
+        if (rxStalled && !g_packetReady) {
             g_uartDma.processRxData();
+            if (!g_packetReady && g_packetParser.checkTimeout(systemTicks)) {
+                Trace::frameComplete();
+                g_packetReady = true;
+            }
+            rxStalled = !g_packetReady && g_packetParser.state != PacketState::WAIT_STX;
+        }
+
+        // Битый кадр: сразу отвечаем NAK, чтобы хост не ждал таймаут
+        if (g_packetParser.hasError()) {
+            uint8_t code = g_packetParser.takeError();
+            LOG("rx NAK 0x%02x", code);
+            sendErrorPacket(code);
         }
 
         if (g_packetReady) {
             g_packetReady = false;
-            GPIOD->ODR ^= GPIO_ODR_OD12;
+            Board::LedGreen::toggle();
 
             processPacketCommand(g_packetParser);
 
             g_packetParser.reset();
         }
+
+        Sequencer::poll(systemTicks);
+        EventWait::poll(systemTicks);
+
+        // Телеметрия не занимает линию, пока принимается или ждет ответа команда
+        bool linkBusy = g_packetReady || g_uartDma.hasPendingRxData() || g_packetParser.hasCarry() ||
+                        g_packetParser.state != PacketState::WAIT_STX;
+        Telemetry::poll(systemTicks, linkBusy);
+
+        LedTask::update(systemTicks);
     }
 }
 
 extern "C" void __attribute__((interrupt, used)) DMA1_Stream2_IRQHandler(void) {
+    PROFILE_SCOPE(ProfileSection::ISR_DMA_RX);
     g_uartDma.handleDmaRxIrq();
 }
 
 extern "C" void __attribute__((interrupt, used)) DMA1_Stream4_IRQHandler(void) {
+    PROFILE_SCOPE(ProfileSection::ISR_DMA_TX);
     g_uartDma.handleDmaTxIrq();
 }
 
 extern "C" void __attribute__((interrupt, used)) UART4_IRQHandler(void) {
-    g_uartDma.handleUartIdleIrq();
+    PROFILE_SCOPE(ProfileSection::ISR_UART);
+    g_uartDma.handleUartIrq();
+}
+
+#if BOARD_SHIFT_OUT
+extern "C" void __attribute__((interrupt, used)) DMA1_Stream5_IRQHandler(void) {
+    ShiftOut::handleDmaIrq();
+}
+#endif
+
+#if BOARD_STEP_DIR
+extern "C" void __attribute__((interrupt, used)) DMA2_Stream5_IRQHandler(void) {
+    StepDir::handleDmaIrq(0);
+}
+
+extern "C" void __attribute__((interrupt, used)) DMA1_Stream1_IRQHandler(void) {
+    StepDir::handleDmaIrq(1);
 }
+#endif
 
 extern "C" void __attribute__((interrupt, used)) SysTick_Handler(void) {
+    PROFILE_SCOPE(ProfileSection::ISR_SYSTICK);
+    systemTicks++;
     g_motorDriver.tick();
+    VelocityStream::tick(systemTicks);
 }
@@ -0,0 +1,22 @@
+#pragma once
+
+/**
+ * Размещение статических объектов по областям RAM (ldscripts/sections.ld).
+ *
+ * CCMRAM (64 KB, 0x10000000) подключена только к шине D ядра: доступ без
+ * ожиданий и без конкуренции с DMA1 на матрице шин, но DMA ее не видит.
+ * Поэтому туда идет только состояние, которое трогает CPU, а буферы,
+ * в которые пишет/читает DMA, явно кладутся в SRAM.
+ *
+ * Линкер проверяет политику: секция .bss_DMA обязана лежать в RAM,
+ * иначе сборка падает на ASSERT в sections.ld.
+ */
+
+// Состояние только для CPU (обнуляется при старте, конструкторы отрабатывают как обычно)
+#define CCMRAM_BSS __attribute__((section(".bss.CCMRAM")))
+
+// Инициализированные данные только для CPU (копируются из FLASH при старте)
+#define CCMRAM_DATA __attribute__((section(".data.CCMRAM")))
+
+// Объекты с буферами DMA - всегда в основной SRAM
+#define DMA_BUFFER __attribute__((section(".bss.DMA")))
@@ -0,0 +1,90 @@
+#include "memory_stats.hpp"
+#include "protocol.hpp"
+#include "uart_dma.hpp"
+#include "motor_driver.hpp"
+#include "crc32.hpp"
+#include "shift_out.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+#include <cstddef>
+
+// Символы линкера (ldscripts/sections.ld)
+extern "C" {
+extern uint32_t __stack;
+extern uint32_t _Main_Stack_Limit;
+extern uint32_t __data_start__;
+extern uint32_t __data_end__;
+extern uint32_t __bss_start__;
+extern uint32_t __bss_end__;
+extern uint32_t __dma_start__;
+extern uint32_t __dma_end__;
+extern uint32_t _noinit;
+extern uint32_t _end_noinit;
+extern uint32_t __ccmram_start__;
+extern uint32_t __ccmram_end__;
+extern char _Heap_Begin;
+void* _sbrk(int incr);
+}
+
+extern PacketParser g_packetParser;
+
+static uint32_t regionSize(const uint32_t* begin, const uint32_t* end) {
+    return reinterpret_cast<uint32_t>(end) - reinterpret_cast<uint32_t>(begin);
+}
+
+// Кадр paintStack() и все, что выше него, уже заняты - оставляем запас
+void MemoryStats::paintStack() {
+    constexpr uint32_t SAFETY_MARGIN = 64;
+    uint32_t* p = &_Main_Stack_Limit;
+    uint32_t* top = reinterpret_cast<uint32_t*>(__get_MSP() - SAFETY_MARGIN);
+
+    while (p < top) {
+        *p++ = STACK_PAINT_PATTERN;
+    }
+}
+
+uint32_t MemoryStats::getStackSize() {
+    return regionSize(&_Main_Stack_Limit, &__stack);
+}
+
+// Первое слово снизу, в котором шаблон затерт, - самая глубокая точка стека.
+// Если затерто слово на самой границе, стек мог уйти и ниже (в кучу).
+uint32_t MemoryStats::getStackHighWater() {
+    const uint32_t* p = &_Main_Stack_Limit;
+    while (p < &__stack && *p == STACK_PAINT_PATTERN) {
+        ++p;
+    }
+    return regionSize(p, &__stack);
+}
+
+uint32_t MemoryStats::getStaticRamUsed() {
+    return regionSize(&__data_start__, &__data_end__) +
+           regionSize(&__bss_start__, &__bss_end__) +
+           regionSize(&__dma_start__, &__dma_end__) +
+           regionSize(&_noinit, &_end_noinit);
+}
+
+uint32_t MemoryStats::getHeapUsed() {
+    return reinterpret_cast<uint32_t>(_sbrk(0)) - reinterpret_cast<uint32_t>(&_Heap_Begin);
+}
+
+uint32_t MemoryStats::getCcmRamUsed() {
+    return regionSize(&__ccmram_start__, &__ccmram_end__);
+}
+
+uint8_t MemoryStats::serialize(uint8_t* out) {
+    uint8_t* p = out;
+    p = putLe32(p, getStackSize());
+    p = putLe32(p, getStackHighWater());
+    p = putLe32(p, getStaticRamUsed());
+    p = putLe32(p, getHeapUsed());
+    p = putLe32(p, getCcmRamUsed());
+    p = putLe16(p, sizeof(g_packetParser));
+    p = putLe16(p, sizeof(g_uartDma));
+    p = putLe16(p, PROTOCOL_MAX_PACKET_SIZE);  // Кадр ответа в serial.cpp
+    p = putLe16(p, sizeof(g_motorDriver));
+    p = putLe32(p, Crc32::getXorCycles());
+    p = putLe32(p, Crc32::getCrcCycles());
+    p = putLe32(p, ShiftOut::lastRefreshCycles());
+    p = putLe32(p, ShiftOut::maxRefreshCycles());
+    return static_cast<uint8_t>(p - out);
+}
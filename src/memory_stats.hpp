@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+// Шаблон, которым заливается свободная часть стека при старте
+constexpr uint32_t STACK_PAINT_PATTERN = 0xA5A5A5A5;
+
+// Размер ответа STATS, раскладка - docs/COMMAND.md
+constexpr uint8_t STATS_RESPONSE_SIZE = 44;
+
+/**
+ * Запас по RAM: high-water mark стека и статическая память подсистем.
+ *
+ * Прерывания на Cortex-M без RTOS работают на том же стеке MSP, поэтому
+ * отдельного стека ISR нет: high-water mark учитывает и их вложенность.
+ */
+class MemoryStats {
+public:
+    /**
+     * @brief Залить свободную часть стека шаблоном (вызывать первым в main)
+     */
+    static void paintStack();
+
+    static uint32_t getStackSize();
+    static uint32_t getStackHighWater();
+    static uint32_t getStaticRamUsed();
+    static uint32_t getHeapUsed();
+    static uint32_t getCcmRamUsed();
+
+    /**
+     * @brief Сериализация ответа STATS (little-endian)
+     * @param out Буфер не меньше STATS_RESPONSE_SIZE
+     * @return Количество записанных байт
+     */
+    static uint8_t serialize(uint8_t* out);
+};
@@ -0,0 +1,305 @@
+#include "motion_profiles.hpp"
+#include "protocol.hpp"
+#include "memory_sections.hpp"
+#include "log.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+CCMRAM_BSS MotionProfiles::Entry MotionProfiles::_table[MOTION_PROFILE_COUNT];
+uint64_t MotionProfiles::_valid = 0;
+uint8_t MotionProfiles::_sector = 0;
+uint32_t MotionProfiles::_generation = 0;
+uint16_t MotionProfiles::_nextSlot = 0;
+
+// Секторы 10 и 11 (по 128 KB) - конец FLASH, см. ldscripts/mem.ld
+static constexpr uint8_t SECTOR_A = 10;
+static constexpr uint8_t SECTOR_B = 11;
+static constexpr uint32_t SECTOR_A_ADDRESS = 0x080C0000;
+static constexpr uint32_t SECTOR_SIZE = 0x20000;
+static constexpr uint32_t RECORD_SIZE = 16;
+static constexpr uint16_t SECTOR_SLOTS = SECTOR_SIZE / RECORD_SIZE;
+
+// Запись 0 сектора - заголовок: MAGIC, generation. Пишется последним,
+// после переноса профилей: сектор без заголовка не используется.
+static constexpr uint32_t SECTOR_MAGIC = 0x31465250;  // "PRF1"
+// Заголовок записи: TAG | op << 8 | id; стертая flash - 0xFFFFFFFF
+static constexpr uint32_t RECORD_TAG = 0x5A000000;
+static constexpr uint32_t RECORD_TAG_MASK = 0xFF000000;
+static constexpr uint8_t RECORD_SET = 0x01;
+static constexpr uint8_t RECORD_DELETE = 0x02;
+static constexpr uint32_t ERASED = 0xFFFFFFFF;
+
+static constexpr uint32_t FLASH_ERRORS = FLASH_SR_PGSERR | FLASH_SR_PGPERR | FLASH_SR_PGAERR | FLASH_SR_WRPERR;
+
+static uint32_t sectorAddress(uint8_t sector) {
+    return SECTOR_A_ADDRESS + (sector - SECTOR_A) * SECTOR_SIZE;
+}
+
+static const volatile uint32_t* slotWords(uint8_t sector, uint16_t slot) {
+    return reinterpret_cast<const volatile uint32_t*>(sectorAddress(sector) + slot * RECORD_SIZE);
+}
+
+static bool slotErased(uint8_t sector, uint16_t slot) {
+    const volatile uint32_t* w = slotWords(sector, slot);
+    return w[0] == ERASED && w[1] == ERASED && w[2] == ERASED && w[3] == ERASED;
+}
+
+static bool sectorGeneration(uint8_t sector, uint32_t* generation) {
+    const volatile uint32_t* w = slotWords(sector, 0);
+    if (w[0] != SECTOR_MAGIC) {
+        return false;
+    }
+    *generation = w[1];
+    return true;
+}
+
+static bool flashWait() {
+    while (FLASH->SR & FLASH_SR_BSY);
+    uint32_t errors = FLASH->SR & FLASH_ERRORS;
+    FLASH->SR = errors;
+    return errors == 0;
+}
+
+static void flashUnlock() {
+    if (FLASH->CR & FLASH_CR_LOCK) {
+        FLASH->KEYR = FLASH_KEY1;
+        FLASH->KEYR = FLASH_KEY2;
+    }
+    FLASH->SR = FLASH_ERRORS;
+}
+
+static void flashLock() {
+    FLASH->CR = FLASH_CR_LOCK;
+}
+
+// Кэш данных ART после стирания может отдать старое содержимое
+static void flashFlushCaches() {
+    if (FLASH->ACR & FLASH_ACR_DCEN) {
+        FLASH->ACR &= ~FLASH_ACR_DCEN;
+        FLASH->ACR |= FLASH_ACR_DCRST;
+        FLASH->ACR &= ~FLASH_ACR_DCRST;
+        FLASH->ACR |= FLASH_ACR_DCEN;
+    }
+}
+
+static bool flashProgramWord(uint32_t address, uint32_t value) {
+    FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_PG;
+    *reinterpret_cast<volatile uint32_t*>(address) = value;
+    bool ok = flashWait();
+    FLASH->CR = 0;
+    return ok;
+}
+
+static bool flashEraseSector(uint8_t sector) {
+    FLASH->CR = FLASH_CR_PSIZE_1 | FLASH_CR_SER | (static_cast<uint32_t>(sector) << FLASH_CR_SNB_Pos);
+    FLASH->CR |= FLASH_CR_STRT;
+    bool ok = flashWait();
+    FLASH->CR = 0;
+    flashFlushCaches();
+    return ok;
+}
+
+void MotionProfiles::init() {
+    _valid = 0;
+    _sector = 0;
+    _generation = 0;
+    _nextSlot = 0;
+
+    uint32_t genA = 0;
+    uint32_t genB = 0;
+    bool hasA = sectorGeneration(SECTOR_A, &genA);
+    bool hasB = sectorGeneration(SECTOR_B, &genB);
+    if (hasA && (!hasB || genA > genB)) {
+        _sector = SECTOR_A;
+        _generation = genA;
+    } else if (hasB) {
+        _sector = SECTOR_B;
+        _generation = genB;
+    } else {
+        return;  // Таблица пуста, сектор заведет первый SET
+    }
+
+    replay(_sector);
+    LOG("profiles: sector %u gen %u, %u slots used", _sector, _generation, _nextSlot);
+}
+
+// Записи применяются по порядку; запись с недописанным заголовком
+// (питание пропало посреди append) пропускается
+void MotionProfiles::replay(uint8_t sector) {
+    uint16_t slot = 1;
+    for (; slot < SECTOR_SLOTS && !slotErased(sector, slot); ++slot) {
+        const volatile uint32_t* w = slotWords(sector, slot);
+        uint32_t header = w[0];
+        if ((header & RECORD_TAG_MASK) != RECORD_TAG) {
+            continue;
+        }
+
+        uint8_t id = static_cast<uint8_t>(header & 0xFF);
+        uint8_t op = static_cast<uint8_t>((header >> 8) & 0xFF);
+        if (id >= MOTION_PROFILE_COUNT) {
+            continue;
+        }
+        if (op == RECORD_SET) {
+            _table[id].acceleration = w[1];
+            _table[id].maxSpeed = w[2];
+            _table[id].steps = w[3];
+            _valid |= 1ULL << id;
+        } else if (op == RECORD_DELETE) {
+            _valid &= ~(1ULL << id);
+        }
+    }
+    _nextSlot = slot;
+}
+
+uint8_t MotionProfiles::set(uint8_t id, uint32_t acceleration, uint32_t maxSpeed, uint32_t steps) {
+    // Номер мотора в профиле не хранится, для проверки подойдет любой допустимый
+    if (id >= MOTION_PROFILE_COUNT || !MotorSettings(1, acceleration, maxSpeed, steps)) {
+        return ProfileResult::INVALID;
+    }
+
+    Entry entry = {acceleration, maxSpeed, steps};
+    uint8_t result = append(RECORD_SET, id, entry);
+    if (result == ProfileResult::OK) {
+        _table[id] = entry;
+        _valid |= 1ULL << id;
+    }
+    return result;
+}
+
+uint8_t MotionProfiles::remove(uint8_t id) {
+    if (id >= MOTION_PROFILE_COUNT) {
+        return ProfileResult::INVALID;
+    }
+    if (!(_valid & (1ULL << id))) {
+        return ProfileResult::OK;
+    }
+
+    Entry entry = {0, 0, 0};
+    uint8_t result = append(RECORD_DELETE, id, entry);
+    if (result == ProfileResult::OK) {
+        _valid &= ~(1ULL << id);
+    }
+    return result;
+}
+
+uint8_t MotionProfiles::append(uint8_t op, uint8_t id, const Entry& entry) {
+    if (_sector == 0 || _nextSlot >= SECTOR_SLOTS) {
+        if (!compact()) {
+            return ProfileResult::FLASH_ERROR;
+        }
+    }
+
+    uint32_t address = sectorAddress(_sector) + _nextSlot * RECORD_SIZE;
+    uint32_t header = RECORD_TAG | (static_cast<uint32_t>(op) << 8) | id;
+    flashUnlock();
+    bool ok = programRecord(address, header, entry);
+    flashLock();
+
+    // Неудачная запись занимает место: повторно программировать слово нельзя.
+    // Но слот, оставшийся стертым, - конец журнала для replay(): следующая
+    // запись идет в него же, иначе все после него пропало бы при загрузке
+    if (ok || !slotErased(_sector, _nextSlot)) {
+        _nextSlot++;
+    }
+    return ok ? ProfileResult::OK : ProfileResult::FLASH_ERROR;
+}
+
+// Данные, затем заголовок: без заголовка запись не применяется
+bool MotionProfiles::programRecord(uint32_t address, uint32_t header, const Entry& entry) {
+    return flashProgramWord(address + 4, entry.acceleration) &&
+           flashProgramWord(address + 8, entry.maxSpeed) &&
+           flashProgramWord(address + 12, entry.steps) &&
+           flashProgramWord(address, header);
+}
+
+// Перенос живых профилей в другой сектор; заголовок с новым поколением - последним
+bool MotionProfiles::compact() {
+    uint8_t target = _sector == SECTOR_A ? SECTOR_B : SECTOR_A;
+    uint32_t base = sectorAddress(target);
+
+    flashUnlock();
+    bool ok = flashEraseSector(target);
+    uint16_t slot = 1;
+    for (uint8_t id = 0; ok && id < MOTION_PROFILE_COUNT; ++id) {
+        if (_valid & (1ULL << id)) {
+            uint32_t header = RECORD_TAG | (static_cast<uint32_t>(RECORD_SET) << 8) | id;
+            ok = programRecord(base + slot * RECORD_SIZE, header, _table[id]);
+            slot++;
+        }
+    }
+    ok = ok && flashProgramWord(base + 4, _generation + 1) &&
+         flashProgramWord(base + 8, 0) &&
+         flashProgramWord(base + 12, 0) &&
+         flashProgramWord(base, SECTOR_MAGIC);
+    flashLock();
+
+    if (!ok) {
+        LOG("profiles: compact to sector %u failed", target);
+        return false;
+    }
+
+    _sector = target;
+    _generation++;
+    _nextSlot = slot;
+    LOG("profiles: compacted to sector %u gen %u", target, _generation);
+    return true;
+}
+
+uint8_t MotionProfiles::expand(const uint8_t* refs, uint8_t count, uint8_t* out, uint8_t* badIndex) {
+    for (uint8_t i = 0; i < count; ++i) {
+        *badIndex = i;
+        uint8_t motor = refs[i * PROFILE_REF_SIZE] & ~PROFILE_REF_REVERSE;
+        bool reverse = (refs[i * PROFILE_REF_SIZE] & PROFILE_REF_REVERSE) != 0;
+        uint8_t id = refs[i * PROFILE_REF_SIZE + 1];
+        if (motor < 1 || motor > MAX_MOTORS) {
+            return ParamFault::NUMBER;
+        }
+        if (id >= MOTION_PROFILE_COUNT || !(_valid & (1ULL << id))) {
+            return ParamFault::PROFILE;
+        }
+
+        const Entry& entry = _table[id];
+        uint32_t steps = reverse ? 0U - entry.steps : entry.steps;
+        uint8_t* p = out + i * 16;
+        p = putLe32(p, motor);
+        p = putLe32(p, entry.acceleration);
+        p = putLe32(p, entry.maxSpeed);
+        putLe32(p, steps);
+    }
+    *badIndex = 0;
+    return ParamFault::NONE;
+}
+
+uint8_t MotionProfiles::serializePage(uint8_t start, uint8_t* out) {
+    uint8_t* p = out + 2;
+    uint8_t count = 0;
+    uint8_t id = start;
+    for (; id < MOTION_PROFILE_COUNT && count < MOTION_PROFILE_PAGE; ++id) {
+        if (!(_valid & (1ULL << id))) {
+            continue;
+        }
+        *p++ = id;
+        p = putLe32(p, _table[id].acceleration);
+        p = putLe32(p, _table[id].maxSpeed);
+        p = putLe32(p, _table[id].steps);
+        count++;
+    }
+    out[0] = id;  // next: MOTION_PROFILE_COUNT - таблица прочитана
+    out[1] = count;
+    return static_cast<uint8_t>(p - out);
+}
+
+uint8_t MotionProfiles::serializeInfo(uint8_t* out) {
+    uint16_t used = _sector != 0 ? _nextSlot : 0;
+    uint16_t freeSlots = _sector != 0 ? SECTOR_SLOTS - _nextSlot : 0;
+
+    uint8_t count = 0;
+    for (uint64_t v = _valid; v != 0; v &= v - 1) {
+        count++;
+    }
+
+    uint8_t* p = putLe32(out, _generation);
+    p = putLe16(p, used);
+    p = putLe16(p, freeSlots);
+    *p++ = count;
+    return static_cast<uint8_t>(p - out);
+}
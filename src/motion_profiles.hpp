@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+#include "motor_settings.hpp"
+
+// Профилей в таблице: id 0..MOTION_PROFILE_COUNT-1
+constexpr uint8_t MOTION_PROFILE_COUNT = 64;
+// Запись профиля в ответе READ: id u8 + accel u32 + speed u32 + steps u32
+constexpr uint8_t MOTION_PROFILE_ENTRY_SIZE = 13;
+// Записей на страницу READ: страница влезает в кадр 256 байт
+constexpr uint8_t MOTION_PROFILE_PAGE = 16;
+// Ссылка на профиль в PROFILE_MOVE: motor u8 + id u8
+constexpr uint8_t PROFILE_REF_SIZE = 2;
+// Бит 7 номера мотора в PROFILE_MOVE: шаги профиля с обратным знаком
+constexpr uint8_t PROFILE_REF_REVERSE = 0x80;
+
+// Подкоманды PROFILE_STORE (первый байт данных)
+namespace ProfileOp {
+    constexpr uint8_t READ   = 0x00;  // start u8 -> next u8, count u8, записи
+    constexpr uint8_t SET    = 0x01;  // id u8, accel u32, speed u32, steps u32
+    constexpr uint8_t DELETE = 0x02;  // id u8
+    constexpr uint8_t INFO   = 0x03;  // -> generation u32, used u16, free u16, count u8
+}
+
+namespace ProfileResult {
+    constexpr uint8_t OK          = 0x00;
+    constexpr uint8_t BUSY        = 0x01;  // Идет движение или программа: запись flash остановит ядро
+    constexpr uint8_t INVALID     = 0x02;  // id вне таблицы или параметры не прошли проверку
+    constexpr uint8_t FLASH_ERROR = 0x03;
+}
+
+/**
+ * Библиотека профилей движения (accel, speed, steps) во flash.
+ *
+ * PROFILE_MOVE ссылается на профиль двумя байтами вместо 16 байт
+ * MotorParams: 10 моторов - кадр 26 байт вместо 165 (2.3 мс против 14 мс
+ * на 115200).
+ *
+ * Хранилище - журнал записей по 16 байт в секторах 10 и 11 (по 128 KB,
+ * вырезаны из FLASH в ldscripts/mem.ld). SET и DELETE дописывают запись
+ * в конец активного сектора, сектор не стирается. Когда место кончилось,
+ * живые профили переносятся в другой сектор со следующим номером
+ * поколения, и только потом старый сектор считается свободным - пропадание
+ * питания в любой момент оставляет целую таблицу. Сектор стирается раз на
+ * ~8000 записей, ресурс flash (10 000 циклов) на практике не достижим.
+ *
+ * init() при старте собирает таблицу в CCMRAM; PROFILE_MOVE читает только ее.
+ *
+ * Запись и стирание останавливают выборку из flash: ядро и прерывания
+ * стоят ~16 мкс на слово и 1-2 с на стирание сектора. Поэтому изменения
+ * принимаются только без движения.
+ */
+class MotionProfiles {
+public:
+    static void init();
+
+    static uint8_t set(uint8_t id, uint32_t acceleration, uint32_t maxSpeed, uint32_t steps);
+    static uint8_t remove(uint8_t id);
+
+    /**
+     * @brief Развернуть ссылки (motor, id) в записи MotorParams для startMotors()
+     * @param badIndex Номер первой неверной ссылки
+     * @return ParamFault::NONE, NUMBER или PROFILE (остальное - validateBatch())
+     */
+    static uint8_t expand(const uint8_t* refs, uint8_t count, uint8_t* out, uint8_t* badIndex);
+
+    // Страница READ с id start; возвращает длину
+    static uint8_t serializePage(uint8_t start, uint8_t* out);
+    static uint8_t serializeInfo(uint8_t* out);
+
+private:
+    struct Entry {
+        uint32_t acceleration;
+        uint32_t maxSpeed;
+        uint32_t steps;
+    };
+
+    static uint8_t append(uint8_t op, uint8_t id, const Entry& entry);
+    static bool compact();
+    static bool programRecord(uint32_t address, uint32_t header, const Entry& entry);
+    static void replay(uint8_t sector);
+
+    static Entry _table[MOTION_PROFILE_COUNT];
+    static uint64_t _valid;        // Бит id - профиль задан
+    static uint8_t _sector;        // Активный сектор, 0 - ни одного
+    static uint32_t _generation;
+    static uint16_t _nextSlot;     // Первая свободная запись активного сектора
+};
@@ -1,18 +1,54 @@
 #include "motor_controller.hpp"
 #include "motor_driver.hpp"
+#include "memory_stats.hpp"
+#include "boot_info.hpp"
+#include "profiler.hpp"
+#include "pc_sampler.hpp"
+#include "trace.hpp"
+#include "log.hpp"
+#include "link_stats.hpp"
+#include "telemetry.hpp"
+#include "event_wait.hpp"
+#include "sequencer.hpp"
+#include "motion_profiles.hpp"
+#include "linear_planner.hpp"
+#include "segment_planner.hpp"
+#include "velocity_stream.hpp"
+#include "board.hpp"
+#include "memory_sections.hpp"
 #include "../system/include/cmsis/stm32f4xx.h"
 #include <cstring>
 
 static void handleVersionCommand();
 static void handleStatusCommand();
 static void handleStopCommand();
+static void handleSessionCommand(const uint8_t* data, uint16_t dataLen);
+static void handleStatsCommand();
+static void handleBootInfoCommand();
+static void handleProfileCommand();
+static void handleSamplesCommand(const uint8_t* data, uint16_t dataLen);
+static void handleTraceCommand(const uint8_t* data, uint16_t dataLen);
+static void handleLogCommand(const uint8_t* data, uint16_t dataLen);
+static void handleLinkStatsCommand(const uint8_t* data, uint16_t dataLen);
+static void handleSubscribeCommand(const uint8_t* data, uint16_t dataLen);
+static void handleWaitEventCommand(const uint8_t* data, uint16_t dataLen);
 static void handleSyncMoveCommand(const uint8_t* data, uint16_t dataLen);
 static void handleAsyncMoveCommand(const uint8_t* data, uint16_t dataLen);
+static void handleSequenceCommand(const uint8_t* data, uint16_t dataLen);
+static void handleProfileMoveCommand(const uint8_t* data, uint16_t dataLen);
+static void handleCompactMoveCommand(const uint8_t* data, uint16_t dataLen);
+static void handleLinearMoveCommand(const uint8_t* data, uint16_t dataLen);
+static void handleSegmentMoveCommand(const uint8_t* data, uint16_t dataLen);
+static void handleVelocityCommand(const uint8_t* data, uint16_t dataLen);
+static void handleVelocitySetCommand(const uint8_t* data, uint16_t dataLen);
+static void handleProfileStoreCommand(const uint8_t* data, uint16_t dataLen);
 
 void processPacketCommand(const PacketParser& packet) {
+    PROFILE_SCOPE(ProfileSection::COMMAND);
     uint8_t cmd = packet.getCommand();
     const uint8_t* data = packet.getData();
     uint16_t dataLen = packet.getDataLength();
+    Trace::dispatch(cmd);
 
     switch (cmd) {
         case Cmd::VERSION:
@@ -27,6 +63,46 @@ void processPacketCommand(const PacketParser& packet) {
             handleStopCommand();
             break;
 
+        case Cmd::SESSION:
+            handleSessionCommand(data, dataLen);
+            break;
+
+        case Cmd::STATS:
+            handleStatsCommand();
+            break;
+
+        case Cmd::BOOT_INFO:
+            handleBootInfoCommand();
+            break;
+
+        case Cmd::PROFILE:
+            handleProfileCommand();
+            break;
+
+        case Cmd::SAMPLES:
+            handleSamplesCommand(data, dataLen);
+            break;
+
+        case Cmd::TRACE_READ:
+            handleTraceCommand(data, dataLen);
+            break;
+
+        case Cmd::LOG:
+            handleLogCommand(data, dataLen);
+            break;
+
+        case Cmd::LINK_STATS:
+            handleLinkStatsCommand(data, dataLen);
+            break;
+
+        case Cmd::SUBSCRIBE:
+            handleSubscribeCommand(data, dataLen);
+            break;
+
+        case Cmd::WAIT_EVENT:
+            handleWaitEventCommand(data, dataLen);
+            break;
+
         case Cmd::SYNC_MOVE:
             handleSyncMoveCommand(data, dataLen);
             break;
@@ -35,10 +111,44 @@ void processPacketCommand(const PacketParser& packet) {
             handleAsyncMoveCommand(data, dataLen);
             break;
 
+        case Cmd::PROFILE_MOVE:
+            handleProfileMoveCommand(data, dataLen);
+            break;
+
+        case Cmd::COMPACT_MOVE:
+            handleCompactMoveCommand(data, dataLen);
+            break;
+
+        case Cmd::LINEAR_MOVE:
+            handleLinearMoveCommand(data, dataLen);
+            break;
+
+        case Cmd::SEGMENT_MOVE:
+            handleSegmentMoveCommand(data, dataLen);
+            break;
+
+        case Cmd::VELOCITY:
+            handleVelocityCommand(data, dataLen);
+            break;
+
+        case Cmd::VELOCITY_SET:
+            handleVelocitySetCommand(data, dataLen);
+            break;
+
+        case Cmd::PROFILE_STORE:
+            handleProfileStoreCommand(data, dataLen);
+            break;
+
+        case Cmd::SEQUENCE:
+            handleSequenceCommand(data, dataLen);
+            break;
+
         default:
             sendErrorPacket(Error::INVALID_COMMAND);
             break;
     }
+
+    Trace::endDispatch();
 }
 
 static void handleVersionCommand() {
@@ -46,15 +156,209 @@ static void handleVersionCommand() {
 }
 
 static void handleStatusCommand() {
-    uint16_t statusPins = GPIOE->IDR & 0x03FF;
+    MotorMask statusPins = static_cast<MotorMask>(Board::Status::read());
     sendStatusResponse(g_motorDriver.getActiveMotors(), g_motorDriver.getCompletedMotors(), statusPins);
 }
 
 static void handleStopCommand() {
+    VelocityStream::abort();
+    Sequencer::stop();
     g_motorDriver.stopAll();
     sendStopResponse(Result::SUCCESS);
 }
 
+// Ответ уходит еще в старом формате, новый действует со следующего кадра
+static void handleSessionCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen != 1) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    uint8_t accepted = data[0] & Session::SUPPORTED;
+    sendSessionResponse(accepted);
+    if (accepted != sessionFlags) {
+        LOG("session flags 0x%02x -> 0x%02x", sessionFlags, accepted);
+    }
+    sessionFlags = accepted;
+}
+
+static void handleStatsCommand() {
+    uint8_t data[STATS_RESPONSE_SIZE];
+    uint8_t len = MemoryStats::serialize(data);
+    sendPacket(Response::STATS, data, len);
+}
+
+static void handleBootInfoCommand() {
+    uint8_t data[BOOT_INFO_RESPONSE_SIZE];
+    uint8_t len = BootInfo::serialize(data);
+    sendPacket(Response::BOOT_INFO, data, len);
+}
+
+// Таблица копируется и сбрасывается до отправки: сама отправка
+// попадет уже в следующий замер участка COMMAND
+static void handleProfileCommand() {
+    uint8_t data[PROFILE_RESPONSE_SIZE];
+    uint16_t len = Profiler::takeSnapshot(data);
+    sendPacket(Response::PROFILE, data, len);
+}
+
+static void handleSamplesCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen == 0) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    uint8_t op = data[0];
+    uint16_t arg = dataLen >= 3 ? static_cast<uint16_t>(data[1] | (data[2] << 8)) : 0;
+    bool hasArg = (op == SampleOp::READ || op == SampleOp::START);
+    if (dataLen != (hasArg ? 3 : 1)) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    switch (op) {
+        case SampleOp::READ: {
+            uint8_t page[PROTOCOL_MAX_DATA_SIZE];
+            uint16_t len = PcSampler::readPage(arg, page, sizeof(page));
+            sendPacket(Response::SAMPLES, page, len);
+            return;
+        }
+        case SampleOp::START:
+            PcSampler::start(arg);
+            break;
+        case SampleOp::STOP:
+            PcSampler::stop();
+            break;
+        case SampleOp::CLEAR:
+            PcSampler::clear();
+            break;
+        default:
+            sendErrorPacket(Error::INVALID_COMMAND);
+            return;
+    }
+
+    uint8_t result = Result::SUCCESS;
+    sendPacket(Response::SAMPLES, &result, 1);
+}
+
+static void handleTraceCommand(const uint8_t* data, uint16_t dataLen) {
+    uint8_t op = dataLen > 0 ? data[0] : TraceOp::READ;
+    if (dataLen > 1) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    if (op == TraceOp::READ) {
+        uint8_t page[PROTOCOL_MAX_DATA_SIZE];
+        uint16_t len = Trace::drain(page, sizeof(page));
+        sendPacket(Response::TRACE_READ, page, len);
+    } else if (op == TraceOp::CLEAR) {
+        Trace::clear();
+        uint8_t result = Result::SUCCESS;
+        sendPacket(Response::TRACE_READ, &result, 1);
+    } else {
+        sendErrorPacket(Error::INVALID_COMMAND);
+    }
+}
+
+static void handleLogCommand(const uint8_t* data, uint16_t dataLen) {
+    uint8_t op = dataLen > 0 ? data[0] : LogOp::READ;
+    if (dataLen > 1) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    if (op == LogOp::READ) {
+        uint8_t page[PROTOCOL_MAX_DATA_SIZE];
+        uint16_t len = Log::drain(page, sizeof(page));
+        sendPacket(Response::LOG, page, len);
+    } else if (op == LogOp::CLEAR) {
+        Log::clear();
+        uint8_t result = Result::SUCCESS;
+        sendPacket(Response::LOG, &result, 1);
+    } else {
+        sendErrorPacket(Error::INVALID_COMMAND);
+    }
+}
+
+static void handleLinkStatsCommand(const uint8_t* data, uint16_t dataLen) {
+    uint8_t op = dataLen > 0 ? data[0] : LinkStatsOp::READ;
+    if (dataLen > 1) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    if (op == LinkStatsOp::READ) {
+        uint8_t response[LINK_STATS_RESPONSE_SIZE];
+        uint8_t len = LinkStats::serialize(response);
+        sendPacket(Response::LINK_STATS, response, len);
+    } else if (op == LinkStatsOp::CLEAR) {
+        LinkStats::clear();
+        uint8_t result = Result::SUCCESS;
+        sendPacket(Response::LINK_STATS, &result, 1);
+    } else {
+        sendErrorPacket(Error::INVALID_COMMAND);
+    }
+}
+
+// period u16 (мс, 0 - выкл) + flags u8; ответ - принятые period и flags
+static void handleSubscribeCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen != 3) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    uint16_t period = static_cast<uint16_t>(data[0] | (data[1] << 8));
+    uint8_t flags = data[2] & TelemetryFlag::SUPPORTED;
+    period = Telemetry::configure(period, flags, systemTicks);
+
+    uint8_t response[3];
+    uint8_t* p = putLe16(response, period);
+    *p = flags;
+    sendPacket(Response::SUBSCRIBE, response, sizeof(response));
+}
+
+// mask (2, 4 или 8 байт) + timeout u16 (мс); ответ отправит EventWait::poll().
+// Хост шлет маску минимальной ширины, поэтому прежний запрос u16 + u16
+// работает при любом MAX_MOTORS.
+static void handleWaitEventCommand(const uint8_t* data, uint16_t dataLen) {
+    uint16_t maskSize = dataLen - 2;
+    if (dataLen < 4 || (maskSize != 2 && maskSize != 4 && maskSize != 8)) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    uint64_t mask = 0;
+    for (uint8_t i = 0; i < maskSize; ++i) {
+        mask |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    uint16_t timeoutMs = static_cast<uint16_t>(data[maskSize] | (data[maskSize + 1] << 8));
+    if (mask == 0 || (mask & ~static_cast<uint64_t>(ALL_MOTORS_MASK)) != 0) {
+        sendErrorPacket(Error::MOTOR_PARAM_ERROR);
+        return;
+    }
+
+    EventWait::arm(static_cast<MotorMask>(mask), timeoutMs, systemTicks);
+}
+
+// Моторами управляет программа или поток скоростей: прямое движение им помешает
+static bool motorsOwned() {
+    return Sequencer::isRunning() || VelocityStream::isActive();
+}
+
+// Весь кадр проверяется до запуска: ни один драйвер не тронут, если
+// хоть одна запись неверна. false - ERROR с причиной уже отправлен.
+static bool validateMotorRecords(const uint8_t* motorData, uint8_t motorCount) {
+    uint8_t badIndex = 0;
+    uint8_t reason = MotorSettings::validateBatch(motorData, motorCount, &badIndex);
+    if (reason != ParamFault::NONE) {
+        LOG("move rejected: record %u, reason %u", badIndex, reason);
+        sendParamErrorPacket(reason, badIndex);
+        return false;
+    }
+    return true;
+}
+
 static void handleSyncMoveCommand(const uint8_t* data, uint16_t dataLen) {
     if (dataLen == 0 || dataLen % 16 != 0) {
         sendErrorPacket(Error::INVALID_MOTOR_COUNT);
@@ -67,6 +371,15 @@ static void handleSyncMoveCommand(const uint8_t* data, uint16_t dataLen) {
         return;
     }
 
+    if (!validateMotorRecords(data, motorCount)) {
+        return;
+    }
+
+    if (motorsOwned()) {
+        sendMoveResponse(Result::BUSY);
+        return;
+    }
+
     g_motorDriver.startMotors(data, motorCount);
     while (!g_motorDriver.allComplete()) {
         __WFI();
@@ -87,6 +400,430 @@ static void handleAsyncMoveCommand(const uint8_t* data, uint16_t dataLen) {
         return;
     }
 
+    if (!validateMotorRecords(data, motorCount)) {
+        return;
+    }
+
+    if (motorsOwned()) {
+        sendMoveResponse(Result::BUSY);
+        return;
+    }
+
     g_motorDriver.startMotors(data, motorCount);
     sendMoveResponse(Result::SUCCESS);
 }
+
+// op u8 + операнды подкоманды; ответ - op u8 + результат подкоманды
+static void handleSequenceCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen == 0) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    uint8_t op = data[0];
+    if (op != SeqOp::LOAD && dataLen != 1) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    uint8_t response[1 + SEQUENCE_STATUS_SIZE];
+    uint8_t* p = response;
+    *p++ = op;
+
+    switch (op) {
+        case SeqOp::CLEAR:
+            if (Sequencer::isRunning()) {
+                *p++ = SeqResult::BUSY;
+            } else {
+                Sequencer::clear();
+                *p++ = SeqResult::OK;
+            }
+            break;
+
+        case SeqOp::LOAD: {
+            if (dataLen < 3) {
+                sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+                return;
+            }
+            uint16_t offset = static_cast<uint16_t>(data[1] | (data[2] << 8));
+            *p++ = Sequencer::load(offset, data + 3, dataLen - 3);
+            p = putLe16(p, Sequencer::length());
+            break;
+        }
+
+        case SeqOp::RUN: {
+            uint16_t badPc = 0;
+            *p++ = VelocityStream::isActive() ? SeqResult::BUSY : Sequencer::run(systemTicks, &badPc);
+            p = putLe16(p, badPc);
+            break;
+        }
+
+        case SeqOp::STOP:
+            *p++ = Sequencer::stop() ? 1 : 0;  // 1 - программа шла и остановлена
+            break;
+
+        case SeqOp::STATUS:
+            p += Sequencer::serialize(p, systemTicks);
+            break;
+
+        default:
+            sendErrorPacket(Error::INVALID_COMMAND);
+            return;
+    }
+
+    sendPacket(Response::SEQUENCE, response, static_cast<uint16_t>(p - response));
+}
+
+// mode u8 + N * (motor u8, profileId u8); бит 7 номера мотора - обратное направление
+static void handleProfileMoveCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen < 1 + PROFILE_REF_SIZE || (dataLen - 1) % PROFILE_REF_SIZE != 0) {
+        sendErrorPacket(Error::INVALID_MOTOR_COUNT);
+        return;
+    }
+
+    uint8_t mode = data[0];
+    uint16_t motorCount = (dataLen - 1) / PROFILE_REF_SIZE;
+    if (motorCount > MAX_MOTORS || mode > MoveMode::SYNC) {
+        sendErrorPacket(Error::INVALID_MOTOR_COUNT);
+        return;
+    }
+
+    uint8_t motorData[16 * MAX_MOTORS];
+    uint8_t badIndex = 0;
+    uint8_t reason = MotionProfiles::expand(data + 1, static_cast<uint8_t>(motorCount), motorData, &badIndex);
+    if (reason != ParamFault::NONE) {
+        sendParamErrorPacket(reason, badIndex);
+        return;
+    }
+    if (!validateMotorRecords(motorData, static_cast<uint8_t>(motorCount))) {
+        return;
+    }
+
+    if (motorsOwned()) {
+        sendMoveResponse(Result::BUSY);
+        return;
+    }
+
+    g_motorDriver.startMotors(motorData, static_cast<uint8_t>(motorCount));
+    if (mode == MoveMode::SYNC) {
+        while (!g_motorDriver.allComplete()) {
+            __WFI();
+        }
+    }
+    sendMoveResponse(Result::SUCCESS);
+}
+
+// op u8 + операнды; ответ - op u8 + результат подкоманды
+static void handleProfileStoreCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen == 0) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    uint8_t op = data[0];
+    uint8_t response[2 + 2 + MOTION_PROFILE_PAGE * MOTION_PROFILE_ENTRY_SIZE];
+    uint8_t* p = response;
+    *p++ = op;
+
+    // Запись во flash останавливает ядро: не во время движения
+    bool busy = g_motorDriver.isRunning() || motorsOwned();
+
+    switch (op) {
+        case ProfileOp::READ:
+            if (dataLen != 2) {
+                sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+                return;
+            }
+            p += MotionProfiles::serializePage(data[1], p);
+            break;
+
+        case ProfileOp::SET: {
+            if (dataLen != 14) {
+                sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+                return;
+            }
+            *p++ = busy ? ProfileResult::BUSY
+                        : MotionProfiles::set(data[1], getLe32(data + 2), getLe32(data + 6), getLe32(data + 10));
+            break;
+        }
+
+        case ProfileOp::DELETE:
+            if (dataLen != 2) {
+                sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+                return;
+            }
+            *p++ = busy ? ProfileResult::BUSY : MotionProfiles::remove(data[1]);
+            break;
+
+        case ProfileOp::INFO:
+            if (dataLen != 1) {
+                sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+                return;
+            }
+            p += MotionProfiles::serializeInfo(p);
+            break;
+
+        default:
+            sendErrorPacket(Error::INVALID_COMMAND);
+            return;
+    }
+
+    sendPacket(Response::PROFILE_STORE, response, static_cast<uint16_t>(p - response));
+}
+
+// Последние параметры COMPACT_MOVE по моторам: опущенные поля берутся отсюда.
+// Меняет их только COMPACT_MOVE - копия на хосте не расходится с MCU из-за
+// движений SEQUENCE или PROFILE_MOVE.
+CCMRAM_BSS static MotorSettings s_compactCache[MAX_MOTORS];
+// Поля s_compactCache, принятые с запуска: после сброса опущенное поле - ENCODING
+static uint8_t s_compactKnown[MAX_MOTORS];
+
+// mode u8 + записи MotorSettings::decodeCompact() до конца данных
+static void handleCompactMoveCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen < 2 || data[0] > MoveMode::SYNC) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    MotorSettings settings[MAX_MOTORS];
+    uint8_t motorData[16 * MAX_MOTORS];
+    uint8_t motorCount = 0;
+    uint16_t pos = 1;
+    while (pos < dataLen) {
+        if (motorCount == MAX_MOTORS) {
+            sendErrorPacket(Error::INVALID_MOTOR_COUNT);
+            return;
+        }
+        uint16_t size = MotorSettings::decodeCompact(data + pos, dataLen - pos, s_compactCache, s_compactKnown,
+                                                     &settings[motorCount]);
+        if (size == 0) {
+            sendParamErrorPacket(ParamFault::ENCODING, motorCount);
+            return;
+        }
+        settings[motorCount].serialize(motorData + motorCount * 16);
+        pos += size;
+        motorCount++;
+    }
+
+    if (!validateMotorRecords(motorData, motorCount)) {
+        return;
+    }
+
+    if (motorsOwned()) {
+        sendMoveResponse(Result::BUSY);
+        return;
+    }
+
+    for (uint8_t i = 0; i < motorCount; ++i) {
+        s_compactCache[settings[i].getNumber() - 1] = settings[i];
+        s_compactKnown[settings[i].getNumber() - 1] = COMPACT_ALL_FIELDS;
+    }
+
+    g_motorDriver.startMotors(motorData, motorCount);
+    if (data[0] == MoveMode::SYNC) {
+        while (!g_motorDriver.allComplete()) {
+            __WFI();
+        }
+    }
+    sendMoveResponse(Result::SUCCESS);
+}
+
+// mode u8 + accel u32 + speed u32 (по пути) + N * (motor u8, steps i32)
+static void handleLinearMoveCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen < LINEAR_HEADER_SIZE + LINEAR_AXIS_SIZE ||
+        (dataLen - LINEAR_HEADER_SIZE) % LINEAR_AXIS_SIZE != 0) {
+        sendErrorPacket(Error::INVALID_MOTOR_COUNT);
+        return;
+    }
+
+    uint8_t mode = data[0];
+    uint16_t motorCount = (dataLen - LINEAR_HEADER_SIZE) / LINEAR_AXIS_SIZE;
+    if (motorCount > MAX_MOTORS || mode > MoveMode::SYNC) {
+        sendErrorPacket(Error::INVALID_MOTOR_COUNT);
+        return;
+    }
+
+    uint8_t motorData[16 * MAX_MOTORS];
+    uint8_t badIndex = 0;
+    uint8_t reason = LinearPlanner::plan(data + LINEAR_HEADER_SIZE, static_cast<uint8_t>(motorCount),
+                                         getLe32(data + 1), getLe32(data + 5), motorData, &badIndex);
+    if (reason != ParamFault::NONE) {
+        sendParamErrorPacket(reason, badIndex);
+        return;
+    }
+    if (!validateMotorRecords(motorData, static_cast<uint8_t>(motorCount))) {
+        return;
+    }
+
+    if (motorsOwned()) {
+        sendMoveResponse(Result::BUSY);
+        return;
+    }
+
+    g_motorDriver.startMotors(motorData, static_cast<uint8_t>(motorCount));
+    if (mode == MoveMode::SYNC) {
+        while (!g_motorDriver.allComplete()) {
+            __WFI();
+        }
+    }
+    sendMoveResponse(Result::SUCCESS);
+}
+
+// motor u8 + N * (accel u32, speed u32, steps i32); исполняется как SYNC_MOVE,
+// команды драйверу - одна за другой после завершения предыдущей
+static void handleSegmentMoveCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen < 1 + SEGMENT_RECORD_SIZE || (dataLen - 1) % SEGMENT_RECORD_SIZE != 0) {
+        sendErrorPacket(Error::INVALID_MOTOR_COUNT);
+        return;
+    }
+
+    uint16_t segmentCount = (dataLen - 1) / SEGMENT_RECORD_SIZE;
+    if (segmentCount > SEGMENT_MAX) {
+        sendErrorPacket(Error::INVALID_MOTOR_COUNT);
+        return;
+    }
+
+    uint8_t badIndex = 0;
+    uint8_t reason = SegmentPlanner::plan(data[0], data + 1, static_cast<uint8_t>(segmentCount), &badIndex);
+    if (reason != ParamFault::NONE) {
+        LOG("segments rejected: segment %u, reason %u", badIndex, reason);
+        sendParamErrorPacket(reason, badIndex);
+        return;
+    }
+
+    // Цепочка запускается только с простоя: драйвер занят командами по очереди
+    uint8_t result = Result::SUCCESS;
+    uint8_t commandCount = SegmentPlanner::commandCount();
+    if (motorsOwned() || g_motorDriver.isRunning()) {
+        result = Result::BUSY;
+        commandCount = 0;
+    }
+
+    uint32_t start = systemTicks;
+    for (uint8_t i = 0; i < commandCount; ++i) {
+        g_motorDriver.startMotors(SegmentPlanner::command(i), 1);
+        while (!g_motorDriver.allComplete()) {
+            __WFI();
+        }
+        if (g_motorDriver.getFaultedMotors() != 0) {
+            result = Result::FAULT;
+            break;
+        }
+    }
+
+    uint8_t report[SEGMENT_REPORT_SIZE];
+    uint8_t* p = report;
+    *p++ = result;
+    *p++ = static_cast<uint8_t>(segmentCount);
+    *p++ = SegmentPlanner::commandCount();
+    p = putLe32(p, SegmentPlanner::standaloneMs());
+    p = putLe32(p, SegmentPlanner::plannedMs());
+    p = putLe32(p, systemTicks - start);
+    sendPacket(Response::SEGMENT_MOVE, report, static_cast<uint16_t>(p - report));
+}
+
+// op u8 + операнды; ответ - op u8 + результат (STATS - и счетчики потока)
+static void handleVelocityCommand(const uint8_t* data, uint16_t dataLen) {
+    if (dataLen == 0) {
+        sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+        return;
+    }
+
+    uint8_t op = data[0];
+    uint8_t response[VELOCITY_STATS_SIZE];
+    uint8_t* p = response;
+    *p++ = op;
+
+    switch (op) {
+        case VelocityOp::START: {
+            if (dataLen != 9) {
+                sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+                return;
+            }
+            // Каналы свободны: движение по шагам и программа их не держат
+            if (g_motorDriver.isRunning() || Sequencer::isRunning()) {
+                *p++ = VelocityResult::BUSY;
+                break;
+            }
+            uint16_t periodUs = static_cast<uint16_t>(data[1] | (data[2] << 8));
+            uint16_t timeoutMs = static_cast<uint16_t>(data[3] | (data[4] << 8));
+            *p++ = VelocityStream::start(periodUs, timeoutMs, getLe32(data + 5), systemTicks);
+            break;
+        }
+
+        case VelocityOp::STOP:
+            if (dataLen != 1) {
+                sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+                return;
+            }
+            VelocityStream::stop();
+            *p++ = VelocityResult::OK;
+            break;
+
+        case VelocityOp::STATS:
+            if (dataLen != 1) {
+                sendErrorPacket(Error::INVALID_PACKET_LENGTH);
+                return;
+            }
+            *p++ = VelocityResult::OK;
+            p += VelocityStream::serialize(p);
+            break;
+
+        default:
+            sendErrorPacket(Error::INVALID_COMMAND);
+            return;
+    }
+
+    sendPacket(Response::VELOCITY, response, static_cast<uint16_t>(p - response));
+}
+
+// Ширина маски VELOCITY_SET по длине кадра: 2, 4 или 8 байт. Разбор однозначен:
+// при ширине 2 длина кадра по модулю 4 иная, чем при 4 и 8, а младшие 4 байта
+// 8-байтовой маски дали бы ту же длину, только будь в них на бит больше, чем во всей
+static uint8_t velocityMaskSize(const uint8_t* data, uint16_t dataLen, uint64_t* mask) {
+    static const uint8_t sizes[] = {2, 4, 8};
+    for (uint8_t size : sizes) {
+        if (dataLen < 1 + size) {
+            break;
+        }
+        uint64_t value = 0;
+        for (uint8_t i = 0; i < size; ++i) {
+            value |= static_cast<uint64_t>(data[1 + i]) << (8 * i);
+        }
+        if (dataLen == 1 + size + VELOCITY_VALUE_SIZE * __builtin_popcountll(value)) {
+            *mask = value;
+            return size;
+        }
+    }
+    return 0;
+}
+
+// seq u8 + mask + velocity i32 на бит маски. Ответа нет и на ошибку: ERROR
+// без запроса хост принял бы за ответ на следующую команду. Отклоненный кадр
+// считается в STATS (rejected, последняя ошибка). Пустая маска - кадр-пульс:
+// только сторож и счетчики.
+static void handleVelocitySetCommand(const uint8_t* data, uint16_t dataLen) {
+    uint64_t mask = 0;
+    uint8_t maskSize = velocityMaskSize(data, dataLen, &mask);
+    if (maskSize == 0) {
+        VelocityStream::reject(Error::INVALID_PACKET_LENGTH, ParamFault::NONE, 0);
+        return;
+    }
+    if (!VelocityStream::isStreaming()) {
+        VelocityStream::reject(Error::STREAM_INACTIVE, ParamFault::NONE, 0);
+        return;
+    }
+    if ((mask & ~static_cast<uint64_t>(ALL_MOTORS_MASK)) != 0) {
+        uint64_t valid = mask & static_cast<uint64_t>(ALL_MOTORS_MASK);
+        VelocityStream::reject(Error::MOTOR_PARAM_ERROR, ParamFault::NUMBER,
+                               static_cast<uint8_t>(__builtin_popcountll(valid)));
+        return;
+    }
+
+    uint8_t badIndex = 0;
+    uint8_t reason = VelocityStream::submit(data[0], static_cast<MotorMask>(mask), data + 1 + maskSize,
+                                            &badIndex, systemTicks);
+    if (reason != ParamFault::NONE) {
+        VelocityStream::reject(Error::MOTOR_PARAM_ERROR, reason, badIndex);
+    }
+}
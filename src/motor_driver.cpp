@@ -1,10 +1,16 @@
 #include "motor_driver.hpp"
 #include "key_controller.hpp"
+#include "board.hpp"
 #include "usart2_driver.hpp"
+#include "step_dir.hpp"
+#include "memory_sections.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
+#include "log.hpp"
 #include "../system/include/cmsis/stm32f4xx.h"
 #include <cstring>
 
-MotorDriver g_motorDriver;
+CCMRAM_BSS MotorDriver g_motorDriver;
 
 MotorDriver::MotorDriver() {
     reset();
@@ -15,12 +21,19 @@ void MotorDriver::reset() {
     _activeMotors = 0;
     _completedMotors = 0;
     _pendingMotors = 0;
+    _faultedMotors = 0;
+    _eventMotors = 0;
     _motorCount = 0;
     _currentSendIndex = 0;
     _timeoutCounter = 0;
     _running = false;
+    _traceTxn = 0;
+    _lastStatusBits = 0;
+    _motionStart = 0;
+    _debounceLo = 0;
+    _debounceHi = 0;
     for (uint8_t i = 0; i < MAX_MOTORS; ++i) {
-        _debounceCounters[i] = 0;
+        _doneAt[i] = 0;
     }
     KeyController::clearAll();
 }
@@ -34,10 +47,14 @@ void MotorDriver::startMotors(const uint8_t* motorData, uint8_t motorCount) {
         _settings[i] = MotorSettings(i, motorData);
         uint8_t motorNum = static_cast<uint8_t>(_settings[i].getNumber());
         if (motorNum >= 1 && motorNum <= MAX_MOTORS) {
-            _activeMotors |= (1U << (motorNum - 1));
+            _activeMotors |= motorBit(motorNum - 1);
         }
     }
 
+    _traceTxn = Trace::activeTransaction();
+    _motionStart = systemTicks;
+    _lastStatusBits = readStatus();
+
     _running = true;
     _state = DriverState::CHECKING_RX;
 }
@@ -68,19 +85,24 @@ void MotorDriver::sendCommandToDriver(uint8_t motorNum) {
     for (volatile uint32_t i = 0; i < 1000; ++i);
 
     uint8_t len = buildDriverPacket(_settings[_currentSendIndex]);
+    Trace::record(TraceEvent::DRIVER_TX_START, motorNum, _traceTxn);
     Usart2Driver::send(_txBuffer, len);
     Usart2Driver::waitTransmitComplete();
+    Trace::record(TraceEvent::DRIVER_TX_END, motorNum, _traceTxn);
 
     for (volatile uint32_t i = 0; i < 1000; ++i);
     KeyController::setKey(motorNum, false);
 
-    _pendingMotors |= (1U << (motorNum - 1));
+    _pendingMotors |= motorBit(motorNum - 1);
 }
 
 void MotorDriver::processNextMotor() {
     if (_currentSendIndex < _motorCount) {
         uint8_t motorNum = static_cast<uint8_t>(_settings[_currentSendIndex].getNumber());
-        if (motorNum >= 1 && motorNum <= MAX_MOTORS) {
+        if (StepDir::owns(motorNum)) {
+            StepDir::start(_settings[_currentSendIndex]);
+            _pendingMotors |= motorBit(motorNum - 1);
+        } else if (motorNum >= 1 && motorNum <= MAX_MOTORS) {
             sendCommandToDriver(motorNum);
         }
         _currentSendIndex++;
@@ -97,17 +119,28 @@ void MotorDriver::startSending() {
     _state = DriverState::SENDING;
 }
 
+static_assert(static_cast<uint8_t>(ProfileSection::DRIVER_COMPLETE) -
+              static_cast<uint8_t>(ProfileSection::DRIVER_IDLE) ==
+              static_cast<uint8_t>(DriverState::COMPLETE),
+              "DRIVER_* profile sections must follow DriverState order");
+
 void MotorDriver::tick() {
     if (!_running) {
         return;
     }
 
+    // Участок выбирается по состоянию на входе в tick()
+    PROFILE_SCOPE(static_cast<ProfileSection>(
+        static_cast<uint8_t>(ProfileSection::DRIVER_IDLE) + static_cast<uint8_t>(_state)));
+    StepDir::poll();
+    traceStatusEdges();
+
     switch (_state) {
         case DriverState::IDLE:
             break;
 
         case DriverState::CHECKING_RX: {
-            GPIOD->ODR |= GPIO_ODR_OD13;
+            Board::LedOrange::set();
             uint8_t maxReads = 32;
             while (Usart2Driver::hasData() && maxReads > 0) {
                 Usart2Driver::readByte();
@@ -118,51 +151,112 @@ void MotorDriver::tick() {
         }
 
         case DriverState::SENDING:
-            GPIOD->ODR |= GPIO_ODR_OD14;
+            Board::LedRed::set();
             processNextMotor();
             break;
 
         case DriverState::WAITING_STATUS: {
             _timeoutCounter++;
-            uint16_t statusBits = GPIOE->IDR & 0x03FF;
-            for (uint8_t i = 0; i < MAX_MOTORS; ++i) {
-                if (_pendingMotors & (1U << i)) {
-                    if (!(statusBits & (1U << i))) {
-                        _debounceCounters[i]++;
-                        if (_debounceCounters[i] >= DEBOUNCE_MS) {
-                            _completedMotors |= (1U << i);
-                            _pendingMotors &= ~(1U << i);
-                        }
-                    } else {
-                        _debounceCounters[i] = 0;
-                    }
-                }
+            // Счетчик мотора растет, пока его STATUS в LOW, и сбрасывается на HIGH;
+            // завершение - DEBOUNCE_MS тиков LOW подряд
+            MotorMask low = _pendingMotors & ~readStatus();
+            MotorMask lo = _debounceLo & low;
+            MotorMask hi = _debounceHi & low;
+            hi ^= lo;
+            lo ^= low;
+            MotorMask done = lo & hi;
+            _debounceLo = lo;
+            _debounceHi = hi;
+            if (done != 0) {
+                _completedMotors |= done;
+                _pendingMotors &= ~done;
+                markDone(done, false);
             }
             if (_pendingMotors == 0) {
                 _state = DriverState::COMPLETE;
-                GPIOD->ODR |= GPIO_ODR_OD15;
+                Board::LedBlue::set();
             } else if (_timeoutCounter >= SAFETY_TIMEOUT_MS) {
+                LOG("safety timeout, pending 0x%03x", static_cast<uint32_t>(_pendingMotors));
+                markDone(_pendingMotors, true);
                 _completedMotors = _activeMotors;
                 _pendingMotors = 0;
                 _state = DriverState::COMPLETE;
-                GPIOD->ODR |= GPIO_ODR_OD15;
+                Board::LedBlue::set();
             }
             break;
         }
 
         case DriverState::COMPLETE:
             _running = false;
-            GPIOD->ODR &= ~(GPIO_ODR_OD13 | GPIO_ODR_OD14);
+            Board::LedOrange::clear();
+            Board::LedRed::clear();
             break;
     }
 }
 
+// STATUS: линии PE для драйверов 0x78, занятость канала таймера для STEP/DIR
+MotorMask MotorDriver::readStatus() const {
+    MotorMask lines = static_cast<MotorMask>(Board::Status::read()) & ~STEP_DIR_MOTORS;
+    return STEP_DIR_MOTORS != 0 ? lines | StepDir::movingMotors() : lines;
+}
+
+// Фронты STATUS активных моторов: опрос раз в тик SysTick, точность 1 мс
+void MotorDriver::traceStatusEdges() {
+    MotorMask statusBits = readStatus();
+    MotorMask changed = (statusBits ^ _lastStatusBits) & _activeMotors;
+    _lastStatusBits = statusBits;
+
+    // Только по изменившимся битам: без фронтов тик не зависит от числа моторов
+    for (; changed != 0; changed &= changed - 1) {
+        uint8_t i = lowestMotorIndex(changed);
+        TraceEvent edge = (statusBits & motorBit(i)) ? TraceEvent::STATUS_RISE : TraceEvent::STATUS_FALL;
+        Trace::record(edge, i + 1, _traceTxn);
+    }
+}
+
 void MotorDriver::stopAll() {
-    _running = false;
+    _running = false;  // Сначала: tick() больше не трогает маски
+    markDone(_activeMotors & ~_completedMotors, true);
     _completedMotors = _activeMotors;
     _pendingMotors = 0;
     _state = DriverState::IDLE;
     KeyController::clearAll();
+    StepDir::stopAll();
+}
+
+// Путь завершения: время для телеметрии и события для WAIT_EVENT
+void MotorDriver::markDone(MotorMask motors, bool fault) {
+    if (fault) {
+        _faultedMotors |= motors;
+    }
+    _eventMotors |= motors;
+
+    uint32_t now = systemTicks;
+    for (; motors != 0; motors &= motors - 1) {
+        uint8_t i = lowestMotorIndex(motors);
+        if (_doneAt[i] == 0) {
+            _doneAt[i] = now != 0 ? now : 1;
+        }
+    }
+}
+
+// stopAll() вызывается из главного цикла, markDone() - из SysTick
+MotorMask MotorDriver::takeEvents(MotorMask mask) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    MotorMask events = _eventMotors & mask;
+    _eventMotors &= ~events;
+    __set_PRIMASK(primask);
+    return events;
+}
+
+uint16_t MotorDriver::getElapsedMs(uint8_t index, uint32_t now) const {
+    if (index >= MAX_MOTORS || !(_activeMotors & motorBit(index))) {
+        return 0;
+    }
+    uint32_t end = _doneAt[index] != 0 ? _doneAt[index] : now;
+    uint32_t elapsed = end - _motionStart;
+    return elapsed > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(elapsed);
 }
 
 bool MotorDriver::allComplete() const {
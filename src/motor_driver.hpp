@@ -3,6 +3,7 @@
 #include <cstdint>
 #include "constants.hpp"
 #include "motor_settings.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
 
 enum class DriverState : uint8_t {
     IDLE,
@@ -17,6 +18,7 @@ public:
     MotorDriver();
 
     void reset();
+    // Записи уже проверены MotorSettings::validateBatch(): здесь только запуск
     void startMotors(const uint8_t* motorData, uint8_t motorCount);
     void tick();
     void stopAll();
@@ -24,8 +26,26 @@ public:
     bool allComplete() const;
     bool isRunning() const;
 
-    uint16_t getActiveMotors() const { return _activeMotors; }
-    uint16_t getCompletedMotors() const { return _completedMotors; }
+    MotorMask getActiveMotors() const { return readMask(_activeMotors); }
+    MotorMask getCompletedMotors() const { return readMask(_completedMotors); }
+
+    /**
+     * @brief Время движения мотора с запуска команды, мс
+     * @param index Индекс мотора (0..MAX_MOTORS-1)
+     * @return До завершения - текущее время, после - время завершения;
+     *         0 для моторов вне команды
+     */
+    uint16_t getElapsedMs(uint8_t index, uint32_t now) const;
+
+    // Моторы, завершенные аварийно: таймаут безопасности или STOP до STATUS
+    MotorMask getFaultedMotors() const { return readMask(_faultedMotors); }
+
+    /**
+     * @brief Забрать накопленные события завершения по маске
+     * @return Моторы из mask, завершившиеся (или аварийно) с запуска команды
+     *         или прошлого вызова; их биты сбрасываются
+     */
+    MotorMask takeEvents(MotorMask mask);
 
     DriverState getState() const { return _state; }
 
@@ -34,23 +54,52 @@ private:
     static constexpr uint32_t SAFETY_TIMEOUT_MS = 30000;
     static constexpr uint8_t DEBOUNCE_MS = 3;
 
+    static_assert(DEBOUNCE_MS == 3, "Debounce counter is two bit planes, completion at count 3");
+
     MotorSettings _settings[MAX_MOTORS];
     uint8_t _txBuffer[TX_BUFFER_SIZE];
-    uint8_t _debounceCounters[MAX_MOTORS];
+
+    // Счетчики антидребезга STATUS - вертикальные: бит i плоскости _debounceLo/_debounceHi -
+    // младший/старший бит счетчика мотора i. Все моторы обновляются парой
+    // логических операций за тик, без цикла по MAX_MOTORS.
+    MotorMask _debounceLo;
+    MotorMask _debounceHi;
 
     volatile DriverState _state;
-    volatile uint16_t _activeMotors;
-    volatile uint16_t _completedMotors;
-    volatile uint16_t _pendingMotors;
+    volatile MotorMask _activeMotors;
+    volatile MotorMask _completedMotors;
+    volatile MotorMask _pendingMotors;
+    volatile MotorMask _faultedMotors;
+    volatile MotorMask _eventMotors;  // Завершения, еще не отданные WAIT_EVENT
     volatile uint8_t _motorCount;
     volatile uint8_t _currentSendIndex;
     volatile uint32_t _timeoutCounter;
     volatile bool _running;
+    uint16_t _traceTxn;       // Транзакция, запустившая движение
+    uint32_t _motionStart;    // systemTicks при запуске команды
+    uint32_t _doneAt[MAX_MOTORS];  // systemTicks завершения мотора, 0 - еще движется
+    MotorMask _lastStatusBits;
 
     uint8_t buildDriverPacket(const MotorSettings& settings);
     void sendCommandToDriver(uint8_t motorNum);
     void processNextMotor();
     void startSending();
+    void traceStatusEdges();
+    MotorMask readStatus() const;
+    void markDone(MotorMask motors, bool fault);
+
+    // Маска шире слова (больше 32 моторов) читается двумя LDR: под PRIMASK,
+    // чтобы SysTick не изменил ее между половинами. Для uint16/uint32 - просто чтение.
+    static MotorMask readMask(const volatile MotorMask& mask) {
+        if (MOTOR_MASK_SIZE <= 4) {
+            return mask;
+        }
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        MotorMask value = mask;
+        __set_PRIMASK(primask);
+        return value;
+    }
 };
 
 extern MotorDriver g_motorDriver;
@@ -1,5 +1,6 @@
 #include "motor_settings.hpp"
 #include "constants.hpp"
+#include "protocol.hpp"
 
 
 MotorSettings::MotorSettings(uint8_t motorIndex, const uint8_t* rxData) {
@@ -22,6 +23,75 @@ MotorSettings::MotorSettings(uint8_t motorIndex, const uint8_t* rxData) {
     
 }
 
+namespace CompactField {
+    constexpr uint8_t ACCEL = 0x01;
+    constexpr uint8_t SPEED = 0x02;
+    constexpr uint8_t STEPS = 0x04;
+    constexpr uint8_t BITS  = 3;
+}
+static_assert((CompactField::ACCEL | CompactField::SPEED | CompactField::STEPS) == COMPACT_ALL_FIELDS,
+              "COMPACT_ALL_FIELDS covers every header field bit");
+
+// Поле varint не шире 32 бит; 0 - ошибка
+static uint8_t readField(const uint8_t* data, uint16_t length, uint32_t* value) {
+    uint64_t raw = 0;
+    uint8_t size = decodeVarint(data, length, &raw);
+    if (size == 0 || raw > 0xFFFFFFFFULL) {
+        return 0;
+    }
+    *value = static_cast<uint32_t>(raw);
+    return size;
+}
+
+uint16_t MotorSettings::decodeCompact(const uint8_t* data, uint16_t length,
+                                      const MotorSettings* cache, const uint8_t* known,
+                                      MotorSettings* settings) {
+    uint32_t header = 0;
+    uint16_t pos = readField(data, length, &header);
+    if (pos == 0) {
+        return 0;
+    }
+
+    uint32_t number = (header >> CompactField::BITS) + 1;
+    if (number > MAX_MOTORS) {
+        return 0;
+    }
+    // Опущенное поле, которого в кэше нет: подставился бы 0 (шаги) и
+    // запись прошла бы проверку - хост не узнал бы о сбросе MCU
+    uint8_t omitted = ~header & COMPACT_ALL_FIELDS;
+    if ((omitted & ~known[number - 1]) != 0) {
+        return 0;
+    }
+    *settings = cache[number - 1];
+    settings->number_ = number;
+
+    uint32_t* fields[] = {&settings->acceleration_, &settings->maxSpeed_, &settings->steps_};
+    for (uint8_t i = 0; i < CompactField::BITS; ++i) {
+        if (!(header & (1U << i))) {
+            continue;
+        }
+        uint8_t size = readField(data + pos, length - pos, fields[i]);
+        if (size == 0) {
+            return 0;
+        }
+        pos += size;
+    }
+
+    // zig-zag: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+    if (header & CompactField::STEPS) {
+        uint32_t zz = settings->steps_;
+        settings->steps_ = (zz >> 1) ^ (0U - (zz & 1U));
+    }
+    return pos;
+}
+
+uint8_t* MotorSettings::serialize(uint8_t* out) const {
+    out = putLe32(out, number_);
+    out = putLe32(out, acceleration_);
+    out = putLe32(out, maxSpeed_);
+    return putLe32(out, steps_);
+}
+
 uint32_t MotorSettings::getNumber() const {
     return number_;
 }
@@ -70,17 +140,45 @@ MotorSettings::operator bool() const {
 }
 
 bool MotorSettings::isValid() const {
+    return fault() == ParamFault::NONE;
+}
+
+uint8_t MotorSettings::fault() const {
     if (number_ < 1 || number_ > MAX_MOTORS) {
-        return false;
+        return ParamFault::NUMBER;
     }
-    
+
+    if (RESERVED_MOTORS & motorBit(static_cast<uint8_t>(number_ - 1))) {
+        return ParamFault::RESERVED;
+    }
+
     if (acceleration_ == 0) {
-        return false;
+        return ParamFault::ACCEL;
     }
-    
+
     if (maxSpeed_ == 0) {
-        return false;
+        return ParamFault::SPEED;
     }
-    
-    return true;
-}
\ No newline at end of file
+
+    return ParamFault::NONE;
+}
+
+uint8_t MotorSettings::validateBatch(const uint8_t* rxData, uint8_t count, uint8_t* badIndex) {
+    MotorMask seen = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        *badIndex = i;
+        MotorSettings settings(i, rxData);
+        uint8_t reason = settings.fault();
+        if (reason != ParamFault::NONE) {
+            return reason;
+        }
+
+        MotorMask bit = motorBit(static_cast<uint8_t>(settings.number_ - 1));
+        if (seen & bit) {
+            return ParamFault::DUPLICATE;
+        }
+        seen |= bit;
+    }
+    *badIndex = 0;
+    return ParamFault::NONE;
+}
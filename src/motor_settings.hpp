@@ -2,6 +2,9 @@
 
 #include <cstdint>
 
+// Биты полей accel/speed/steps в header записи COMPACT_MOVE
+constexpr uint8_t COMPACT_ALL_FIELDS = 0x07;
+
 class MotorSettings {
 public:
     MotorSettings() = default;
@@ -15,6 +18,32 @@ public:
      * @param rxData Указатель на массив данных для парсинга
      */
     MotorSettings(uint8_t motorIndex, const uint8_t* rxData);
+
+    /**
+     * @brief Разбор записи COMPACT_MOVE
+     *
+     * Запись: varint header (биты 0-2 - поля accel/speed/steps есть,
+     * старшие - номер мотора - 1), затем присутствующие поля varint,
+     * шаги - zig-zag. Отсутствующее поле берется из cache[номер - 1],
+     * если оно там уже было задано (бит в known[номер - 1]).
+     *
+     * @param data Начало записи
+     * @param length Байт, доступных от data
+     * @param cache Последние параметры COMPACT_MOVE по моторам (MAX_MOTORS)
+     * @param known Поля cache, принятые хоть раз: биты accel/speed/steps, как в header
+     * @param settings Результат (не проверяется)
+     * @return Длина записи, 0 если она обрезана, мотор вне 1..MAX_MOTORS, поле шире
+     *         32 бит или опущено поле, которого в cache нет (после сброса MCU)
+     */
+    static uint16_t decodeCompact(const uint8_t* data, uint16_t length,
+                                  const MotorSettings* cache, const uint8_t* known,
+                                  MotorSettings* settings);
+
+    /**
+     * @brief Запись 16 байт в формате MotorParams (как ее читает конструктор)
+     * @return Позиция за записью
+     */
+    uint8_t* serialize(uint8_t* out) const;
     MotorSettings(const MotorSettings& other) = default;
     MotorSettings& operator=(const MotorSettings& other) = default;
     ~MotorSettings() = default;
@@ -81,6 +110,25 @@ public:
      */
     bool operator!=(const MotorSettings& other) const;
     
+    /**
+     * @brief Причина, по которой запись нельзя исполнить
+     * @return ParamFault::NONE, NUMBER, ACCEL, SPEED или RESERVED
+     */
+    uint8_t fault() const;
+
+    /**
+     * @brief Проверка всех записей кадра до запуска движения
+     *
+     * Одним проходом: fault() каждой записи и повтор номера мотора.
+     * Ни один драйвер не трогается, пока весь кадр не прошел проверку.
+     *
+     * @param rxData Записи по 16 байт (формат MotorParams)
+     * @param count Число записей
+     * @param badIndex Номер первой неверной записи
+     * @return ParamFault::NONE или причина для badIndex
+     */
+    static uint8_t validateBatch(const uint8_t* rxData, uint8_t count, uint8_t* badIndex);
+
     /**
      * @brief Оператор преобразования в bool для использования в условиях
      * @return true если параметры валидны, false в противном случае
@@ -1,6 +1,7 @@
 #include "motor_simulator.hpp"
+#include "memory_sections.hpp"
 
-MotorSimulator g_motorSimulator;
+CCMRAM_BSS MotorSimulator g_motorSimulator;
 
 MotorSimulator::MotorSimulator() {
     reset();
@@ -26,7 +27,7 @@ void MotorSimulator::startMotor(uint8_t motorNum, uint32_t steps) {
         _simulationTicks[idx] = 1;
     }
 
-    _activeMotors |= (1U << idx);
+    _activeMotors |= motorBit(idx);
     _running = true;
 }
 
@@ -45,15 +46,15 @@ void MotorSimulator::tick() {
         return;
     }
 
-    for (uint8_t i = 0; i < MAX_MOTORS; ++i) {
-        if ((_activeMotors & (1U << i)) && !(_completedMotors & (1U << i))) {
-            if (_simulationTicks[i] > 0) {
-                _simulationTicks[i]--;
-            }
+    // Только по движущимся моторам, а не по всем MAX_MOTORS
+    for (MotorMask moving = _activeMotors & ~_completedMotors; moving != 0; moving &= moving - 1) {
+        uint8_t i = lowestMotorIndex(moving);
+        if (_simulationTicks[i] > 0) {
+            _simulationTicks[i]--;
+        }
 
-            if (_simulationTicks[i] == 0) {
-                _completedMotors |= (1U << i);
-            }
+        if (_simulationTicks[i] == 0) {
+            _completedMotors |= motorBit(i);
         }
     }
 
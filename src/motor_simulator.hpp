@@ -16,15 +16,15 @@ public:
     bool allComplete() const;
     bool isRunning() const;
 
-    uint16_t getActiveMotors() const { return _activeMotors; }
-    uint16_t getCompletedMotors() const { return _completedMotors; }
+    MotorMask getActiveMotors() const { return _activeMotors; }
+    MotorMask getCompletedMotors() const { return _completedMotors; }
 
 private:
     static constexpr uint32_t STEPS_PER_TICK = 1;
 
     volatile uint32_t _simulationTicks[MAX_MOTORS];
-    volatile uint16_t _activeMotors;
-    volatile uint16_t _completedMotors;
+    volatile MotorMask _activeMotors;
+    volatile MotorMask _completedMotors;
     volatile bool _running;
 };
 
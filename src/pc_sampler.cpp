@@ -0,0 +1,133 @@
+#include "pc_sampler.hpp"
+#include "protocol.hpp"
+#include "memory_sections.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+extern "C" unsigned int __vectors_start;
+extern "C" unsigned int _etext;
+
+CCMRAM_BSS uint16_t PcSampler::_buckets[PC_SAMPLE_BUCKETS];
+uint32_t PcSampler::_base = 0;
+uint8_t PcSampler::_shift = 0;
+uint32_t PcSampler::_totalSamples = 0;
+uint32_t PcSampler::_outOfRange = 0;
+volatile bool PcSampler::_running = false;
+
+// Заголовок страницы: base u32, shift u8, buckets u16, total u32, outOfRange u32, next u16
+constexpr uint16_t PAGE_HEADER_SIZE = 17;
+constexpr uint16_t PAGE_PAIR_SIZE = 4;
+
+void PcSampler::init() {
+    _base = reinterpret_cast<uint32_t>(&__vectors_start);
+    uint32_t codeSize = reinterpret_cast<uint32_t>(&_etext) - _base;
+
+    _shift = 2;  // Инструкции Thumb выровнены на 2, корзина меньше 4 байт бесполезна
+    while ((codeSize >> _shift) >= PC_SAMPLE_BUCKETS) {
+        ++_shift;
+    }
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM7EN;
+    TIM7->CR1 = 0;
+    TIM7->DIER = TIM_DIER_UIE;
+
+    // Выше остальных прерываний, в том числе SysTick (8, см. SysTick_Init):
+    // иначе не видно, что делают ISR, например ожидание пакета драйверу
+    NVIC_SetPriority(TIM7_IRQn, 1);
+    NVIC_EnableIRQ(TIM7_IRQn);
+}
+
+// Тактирование TIM7 = APB1 (16 МГц, без делителя): счет 1 МГц
+void PcSampler::start(uint16_t hz) {
+    if (hz == 0) {
+        hz = PC_SAMPLE_DEFAULT_HZ;
+    } else if (hz < PC_SAMPLE_MIN_HZ) {
+        hz = PC_SAMPLE_MIN_HZ;
+    } else if (hz > PC_SAMPLE_MAX_HZ) {
+        hz = PC_SAMPLE_MAX_HZ;
+    }
+
+    TIM7->CR1 &= ~TIM_CR1_CEN;
+    TIM7->PSC = SystemCoreClock / 1000000 - 1;
+    TIM7->ARR = 1000000 / hz - 1;
+    TIM7->CNT = 0;
+    TIM7->EGR = TIM_EGR_UG;
+    TIM7->SR = 0;
+
+    _running = true;
+    TIM7->CR1 |= TIM_CR1_CEN;
+}
+
+void PcSampler::stop() {
+    TIM7->CR1 &= ~TIM_CR1_CEN;
+    _running = false;
+}
+
+void PcSampler::clear() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint16_t i = 0; i < PC_SAMPLE_BUCKETS; ++i) {
+        _buckets[i] = 0;
+    }
+    _totalSamples = 0;
+    _outOfRange = 0;
+    __set_PRIMASK(primask);
+}
+
+void PcSampler::sample(uint32_t pc) {
+    _totalSamples++;
+
+    uint32_t index = (pc - _base) >> _shift;
+    if (pc < _base || index >= PC_SAMPLE_BUCKETS) {
+        _outOfRange++;
+        return;
+    }
+    if (_buckets[index] != 0xFFFF) {
+        _buckets[index]++;
+    }
+}
+
+// Только ненулевые корзины парами (index u16, count u16). next - индекс,
+// с которого читать следующую страницу, PC_SAMPLE_BUCKETS - конец.
+uint16_t PcSampler::readPage(uint16_t start, uint8_t* out, uint16_t capacity) {
+    uint8_t* p = out + PAGE_HEADER_SIZE;
+    uint8_t* end = out + capacity;
+    uint16_t index = start;
+
+    for (; index < PC_SAMPLE_BUCKETS; ++index) {
+        uint16_t count = _buckets[index];
+        if (count == 0) {
+            continue;
+        }
+        if (end - p < PAGE_PAIR_SIZE) {
+            break;
+        }
+        p = putLe16(p, index);
+        p = putLe16(p, count);
+    }
+
+    uint8_t* h = out;
+    h = putLe32(h, _base);
+    *h++ = _shift;
+    h = putLe16(h, PC_SAMPLE_BUCKETS);
+    h = putLe32(h, _totalSamples);
+    h = putLe32(h, _outOfRange);
+    putLe16(h, index);
+
+    return static_cast<uint16_t>(p - out);
+}
+
+// Кадр исключения: r0, r1, r2, r3, r12, lr, pc, xpsr
+extern "C" void pcSamplerHandler(const uint32_t* frame) {
+    TIM7->SR = ~TIM_SR_UIF;
+    PcSampler::sample(frame[6]);
+}
+
+// Обработчик без пролога: стек еще указывает на кадр прерванного контекста
+extern "C" void __attribute__((naked, used)) TIM7_IRQHandler(void) {
+    __asm volatile(
+        "tst lr, #4      \n"
+        "ite eq          \n"
+        "mrseq r0, msp   \n"
+        "mrsne r0, psp   \n"
+        "b pcSamplerHandler \n");
+}
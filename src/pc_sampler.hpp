@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+// Гистограмма: счетчики u16 по диапазонам адресов FLASH
+constexpr uint16_t PC_SAMPLE_BUCKETS = 2048;
+constexpr uint16_t PC_SAMPLE_DEFAULT_HZ = 1000;
+constexpr uint16_t PC_SAMPLE_MIN_HZ = 16;      // ARR TIM7 16-битный при счете 1 МГц
+constexpr uint16_t PC_SAMPLE_MAX_HZ = 10000;
+
+// Подкоманды SAMPLES (первый байт данных)
+namespace SampleOp {
+    constexpr uint8_t READ  = 0x00;  // [start u16] -> страница ненулевых корзин
+    constexpr uint8_t START = 0x01;  // [hz u16]
+    constexpr uint8_t STOP  = 0x02;
+    constexpr uint8_t CLEAR = 0x03;
+}
+
+/**
+ * Статистический профилировщик: TIM7 с низкой частотой прерывает программу
+ * и берет PC из кадра исключения прерванного контекста.
+ *
+ * Корзина покрывает 2^shift байт кода начиная с __vectors_start; shift
+ * выбирается при init() так, чтобы весь .text (до _etext) уместился в
+ * PC_SAMPLE_BUCKETS. PC вне диапазона считаются отдельно.
+ * Символы по адресам восстанавливает хост (scripts/squid/symbols.py).
+ */
+class PcSampler {
+public:
+    static void init();
+    static void start(uint16_t hz);
+    static void stop();
+    static void clear();
+    static bool isRunning() { return _running; }
+
+    static void sample(uint32_t pc);
+
+    /**
+     * @brief Страница ненулевых корзин начиная с start
+     * @param out Буфер под ответ
+     * @param capacity Размер буфера
+     * @return Количество записанных байт
+     */
+    static uint16_t readPage(uint16_t start, uint8_t* out, uint16_t capacity);
+
+private:
+    static uint16_t _buckets[PC_SAMPLE_BUCKETS];
+    static uint32_t _base;
+    static uint8_t _shift;
+    static uint32_t _totalSamples;
+    static uint32_t _outOfRange;
+    static volatile bool _running;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include "../system/include/cmsis/stm32f4xx.h"
+
+// Встраивается и при -O0: иначе каждая запись BSRR стала бы вызовом функции
+#define PIN_INLINE __attribute__((always_inline)) inline
+
+enum class Port : uint8_t { A, B, C, D, E };
+
+enum class Pull : uint32_t {
+    NONE = 0,
+    UP   = 1,
+    DOWN = 2
+};
+
+namespace PinDetail {
+    constexpr uint32_t base(Port port) {
+        return GPIOA_BASE + static_cast<uint32_t>(port) * (GPIOB_BASE - GPIOA_BASE);
+    }
+
+    // Поле шириной width на каждый пин из mask в диапазоне [pin, end):
+    // MODER/OSPEEDR/PUPDR - 2 бита, AFR - 4 бита на пин
+    constexpr uint32_t spread(uint32_t mask, uint32_t value, uint8_t width, uint8_t pin, uint8_t end) {
+        return pin == end ? 0
+                          : ((((mask >> pin) & 1U) ? (value << (pin * width)) : 0) |
+                             spread(mask, value, width, pin + 1, end));
+    }
+}
+
+template <Port P, uint8_t N>
+struct Pin;
+
+/**
+ * Группа соседних пинов порта, все маски считаются при компиляции.
+ *
+ * Запись выходов идет только через BSRR: одна запись, без чтения ODR,
+ * поэтому не конфликтует с ISR, меняющими другие пины того же порта.
+ * Аргумент bits - биты группы (бит 0 - пин First).
+ */
+template <Port P, uint8_t First, uint8_t Count>
+struct PinGroup {
+    static_assert(Count >= 1 && First + Count <= 16, "Pin group must fit one 16-pin port");
+
+    static constexpr uint32_t BASE = PinDetail::base(P);
+    static constexpr uint32_t BITS = (1UL << Count) - 1;
+    static constexpr uint32_t MASK = BITS << First;
+    static constexpr uint32_t FIELD2 = PinDetail::spread(MASK, 3, 2, 0, 16);      // MODER/OSPEEDR/PUPDR
+    static constexpr uint32_t MODER_OUTPUT = PinDetail::spread(MASK, 1, 2, 0, 16);
+    static constexpr uint32_t MODER_ALTERNATE = PinDetail::spread(MASK, 2, 2, 0, 16);
+    static constexpr uint32_t AFRL_FIELD = PinDetail::spread(MASK, 0xF, 4, 0, 8);
+    static constexpr uint32_t AFRH_FIELD = PinDetail::spread(MASK >> 8, 0xF, 4, 0, 8);
+
+    // Пин группы с номером Index (0 - First)
+    template <uint8_t Index>
+    using At = Pin<P, First + Index>;
+
+    PIN_INLINE static GPIO_TypeDef* port() { return reinterpret_cast<GPIO_TypeDef*>(BASE); }
+
+    PIN_INLINE static void set(uint32_t bits) { port()->BSRR = (bits & BITS) << First; }
+    PIN_INLINE static void clear(uint32_t bits) { port()->BSRR = (bits & BITS) << (First + 16); }
+    PIN_INLINE static void setAll() { port()->BSRR = MASK; }
+    PIN_INLINE static void clearAll() { port()->BSRR = MASK << 16; }
+
+    // Вся группа одной записью: единицы bits в BS, нули в BR
+    PIN_INLINE static void write(uint32_t bits) {
+        port()->BSRR = ((~bits & BITS) << (First + 16)) | ((bits & BITS) << First);
+    }
+
+    PIN_INLINE static uint32_t read() { return (port()->IDR >> First) & BITS; }
+    PIN_INLINE static uint32_t readOutput() { return (port()->ODR >> First) & BITS; }
+
+    // Настройка - по одной записи на регистр, все маски - константы.
+    // Выход: push-pull, максимальная скорость, без подтяжки, начальный уровень LOW
+    static void configureOutput() {
+        GPIO_TypeDef* gpio = port();
+        gpio->BSRR = MASK << 16;
+        gpio->MODER = (gpio->MODER & ~FIELD2) | MODER_OUTPUT;
+        gpio->OTYPER &= ~MASK;
+        gpio->OSPEEDR |= FIELD2;
+        gpio->PUPDR &= ~FIELD2;
+    }
+
+    template <Pull Mode>
+    static void configureInput() {
+        constexpr uint32_t pupd = PinDetail::spread(MASK, static_cast<uint32_t>(Mode), 2, 0, 16);
+        GPIO_TypeDef* gpio = port();
+        gpio->MODER &= ~FIELD2;
+        gpio->PUPDR = (gpio->PUPDR & ~FIELD2) | pupd;
+    }
+
+    template <uint8_t Af>
+    static void configureAlternate() {
+        static_assert(Af < 16, "Alternate function is 4 bits");
+        constexpr uint32_t afrl = PinDetail::spread(MASK, Af, 4, 0, 8);
+        constexpr uint32_t afrh = PinDetail::spread(MASK >> 8, Af, 4, 0, 8);
+        GPIO_TypeDef* gpio = port();
+        gpio->AFR[0] = (gpio->AFR[0] & ~AFRL_FIELD) | afrl;
+        gpio->AFR[1] = (gpio->AFR[1] & ~AFRH_FIELD) | afrh;
+        gpio->MODER = (gpio->MODER & ~FIELD2) | MODER_ALTERNATE;
+        gpio->OSPEEDR |= FIELD2;
+    }
+};
+
+// Одиночный пин: set()/clear() - одна запись константы в BSRR
+template <Port P, uint8_t N>
+struct Pin : PinGroup<P, N, 1> {
+    using Group = PinGroup<P, N, 1>;
+
+    PIN_INLINE static void set() { Group::port()->BSRR = Group::MASK; }
+    PIN_INLINE static void clear() { Group::port()->BSRR = Group::MASK << 16; }
+    PIN_INLINE static void write(bool high) { Group::port()->BSRR = high ? Group::MASK : Group::MASK << 16; }
+    PIN_INLINE static bool read() { return (Group::port()->IDR & Group::MASK) != 0; }
+    PIN_INLINE static bool isSet() { return (Group::port()->ODR & Group::MASK) != 0; }
+
+    // Чтение ODR и одна запись BSRR: другие пины порта не затрагиваются
+    PIN_INLINE static void toggle() {
+        Group::port()->BSRR = (Group::port()->ODR & Group::MASK) ? Group::MASK << 16 : Group::MASK;
+    }
+};
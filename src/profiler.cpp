@@ -0,0 +1,57 @@
+#include "profiler.hpp"
+#include "constants.hpp"
+#include "protocol.hpp"
+#include "memory_sections.hpp"
+
+static_assert(PROFILE_RESPONSE_SIZE <= PROTOCOL_MAX_DATA_SIZE, "PROFILE response must fit into one packet");
+
+CCMRAM_BSS ProfileEntry Profiler::_entries[PROFILE_SECTION_COUNT];
+
+void Profiler::record(ProfileSection section, uint32_t elapsed) {
+    ProfileEntry& entry = _entries[static_cast<uint8_t>(section)];
+
+    if (entry.count == 0 || elapsed < entry.minCycles) {
+        entry.minCycles = elapsed;
+    }
+    if (elapsed > entry.maxCycles) {
+        entry.maxCycles = elapsed;
+    }
+    entry.totalCycles += elapsed;
+    entry.count++;
+}
+
+void Profiler::reset() {
+    for (uint8_t i = 0; i < PROFILE_SECTION_COUNT; ++i) {
+        _entries[i].count = 0;
+        _entries[i].minCycles = 0;
+        _entries[i].maxCycles = 0;
+        _entries[i].totalCycles = 0;
+    }
+}
+
+// Копия и сброс под запретом прерываний: записи ISR не должны
+// разорваться между чтением и обнулением
+uint16_t Profiler::takeSnapshot(uint8_t* out) {
+    uint8_t* p = out;
+
+#if PROFILER_ENABLED
+    *p++ = PROFILE_SECTION_COUNT;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; i < PROFILE_SECTION_COUNT; ++i) {
+        const ProfileEntry& entry = _entries[i];
+        p = putLe32(p, entry.count);
+        p = putLe32(p, entry.minCycles);
+        p = putLe32(p, entry.maxCycles);
+        p = putLe32(p, static_cast<uint32_t>(entry.totalCycles));
+        p = putLe32(p, static_cast<uint32_t>(entry.totalCycles >> 32));
+    }
+    reset();
+    __set_PRIMASK(primask);
+#else
+    *p++ = 0;
+#endif
+
+    return static_cast<uint16_t>(p - out);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include "../system/include/cmsis/stm32f4xx.h"
+
+// 0 - макросы PROFILE_* разворачиваются в пустоту, PROFILE отдает пустую таблицу
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+/**
+ * Профилируемые участки. Порядок - это индекс в ответе PROFILE,
+ * имена на хосте - PROFILE_SECTIONS в scripts/squid/diagnostics.py.
+ */
+enum class ProfileSection : uint8_t {
+    PARSER_BYTE,            // PacketParser::processByte
+    RX_PROCESS,             // UartDma::processRxData
+    COMMAND,                // processPacketCommand (вместе с отправкой ответа)
+    DRIVER_IDLE,            // MotorDriver::tick по состояниям
+    DRIVER_CHECKING_RX,
+    DRIVER_SENDING,
+    DRIVER_WAITING_STATUS,
+    DRIVER_COMPLETE,
+    ISR_DMA_RX,             // Точки входа прерываний
+    ISR_DMA_TX,
+    ISR_UART,
+    ISR_SYSTICK,
+    COUNT
+};
+
+constexpr uint8_t PROFILE_SECTION_COUNT = static_cast<uint8_t>(ProfileSection::COUNT);
+
+// Запись в ответе: count u32, min u32, max u32, total u64
+constexpr uint8_t PROFILE_ENTRY_SIZE = 20;
+constexpr uint16_t PROFILE_RESPONSE_SIZE = 1 + PROFILE_SECTION_COUNT * PROFILE_ENTRY_SIZE;
+
+struct ProfileEntry {
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+};
+
+/**
+ * Профилировщик участков по DWT CYCCNT (такты ядра).
+ *
+ * Время участка включает вытеснение прерываниями: ISR с более высоким
+ * приоритетом, сработавший внутри участка, попадет и в его такты.
+ * Каждую запись обновляет только один контекст (главный цикл или свой ISR),
+ * поэтому record() не блокирует прерывания.
+ */
+class Profiler {
+public:
+    static void enableCycleCounter() {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    static uint32_t cycles() { return DWT->CYCCNT; }
+
+    static void record(ProfileSection section, uint32_t elapsed);
+    static void reset();
+
+    /**
+     * @brief Сериализация таблицы (little-endian) и ее сброс
+     * @param out Буфер не меньше PROFILE_RESPONSE_SIZE
+     * @return Количество записанных байт
+     */
+    static uint16_t takeSnapshot(uint8_t* out);
+
+private:
+    static ProfileEntry _entries[PROFILE_SECTION_COUNT];
+};
+
+// Замер от объявления до конца области видимости
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileSection section)
+        : _section(section), _start(Profiler::cycles()) {}
+    ~ProfileScope() { Profiler::record(_section, Profiler::cycles() - _start); }
+
+private:
+    ProfileSection _section;
+    uint32_t _start;
+};
+
+#if PROFILER_ENABLED
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(section) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(section)
+#else
+#define PROFILE_SCOPE(section) do {} while (0)
+#endif
@@ -1,6 +1,14 @@
 #include "protocol.hpp"
+#include "crc32.hpp"
+#include "profiler.hpp"
+#include <cstring>
 
 PacketParser::PacketParser() {
+    error = 0;
+    lastByteTime = 0;
+    carryHead = 0;
+    carryLength = 0;
+    clearCounters();
     reset();
 }
 
@@ -8,81 +16,291 @@ void PacketParser::reset() {
     state = PacketState::WAIT_STX;
     expectedLength = 0;
     receivedBytes = 0;
-    dataIndex = 0;
     command = 0;
     calculatedXor = 0;
-    for (uint16_t i = 0; i < PROTOCOL_MAX_PACKET_SIZE; ++i) {
-        buffer[i] = 0;
+    trailerSize = (sessionFlags & Session::CRC32) ? PROTOCOL_CRC_SIZE : 1;
+}
+
+PacketState PacketParser::trailerState() const {
+    return trailerSize == 1 ? PacketState::WAIT_XOR : PacketState::WAIT_CRC;
+}
+
+// Проверка контрольной суммы готового кадра в buffer (с STX в buffer[0])
+uint8_t PacketParser::checkIntegrity() const {
+    uint16_t bodyLength = expectedLength - 1 - trailerSize;
+    const uint8_t* trailer = buffer + expectedLength - trailerSize;
+
+    if (trailerSize == 1) {
+        return calculateXor(buffer + 1, bodyLength) == trailer[0] ? 0 : Error::XOR_CHECKSUM_ERROR;
     }
+
+    uint32_t received = static_cast<uint32_t>(trailer[0]) |
+                        (static_cast<uint32_t>(trailer[1]) << 8) |
+                        (static_cast<uint32_t>(trailer[2]) << 16) |
+                        (static_cast<uint32_t>(trailer[3]) << 24);
+    return Crc32::compute(buffer + 1, bodyLength) == received ? 0 : Error::CRC_CHECKSUM_ERROR;
 }
 
 bool PacketParser::processByte(uint8_t byte) {
+    PROFILE_SCOPE(ProfileSection::PARSER_BYTE);
+    lastByteTime = systemTicks;
+
+    bool ready;
+    if (sessionFlags & Session::COBS_FRAMING) {
+        ready = consumeCobs(byte) == ByteResult::READY;
+    } else {
+        // Кадр, найденный resync() в тех же байтах, будет исполнен: NAK на
+        // них хост принял бы за "не исполнено" и прислал команду повторно
+        uint8_t pendingError = error;
+        ByteResult result = consume(byte);
+        ready = (result == ByteResult::REJECTED) ? resync() : result == ByteResult::READY;
+        if (ready) {
+            error = pendingError;
+        }
+    }
+
+    if (ready) {
+        acceptedFrames++;
+    }
+    return ready;
+}
+
+ByteResult PacketParser::consume(uint8_t byte) {
     switch (state) {
         case PacketState::WAIT_STX:
             if (byte == PROTOCOL_STX) {
+                buffer[0] = byte;
                 state = PacketState::WAIT_LENGTH_H;
                 receivedBytes = 1;
             }
             break;
 
         case PacketState::WAIT_LENGTH_H:
+            buffer[receivedBytes++] = byte;
             expectedLength = static_cast<uint16_t>(byte) << 8;
             calculatedXor = byte;
             state = PacketState::WAIT_LENGTH_L;
-            receivedBytes = 2;
             break;
 
         case PacketState::WAIT_LENGTH_L:
+            buffer[receivedBytes++] = byte;
             expectedLength |= byte;
             calculatedXor ^= byte;
-            receivedBytes = 3;
 
-            if (expectedLength < PROTOCOL_MIN_PACKET_SIZE ||
+            if (expectedLength < PROTOCOL_HEADER_SIZE + trailerSize ||
                 expectedLength > PROTOCOL_MAX_PACKET_SIZE) {
-                reset();
-                return false;
+                setError(Error::INVALID_PACKET_LENGTH);
+                return ByteResult::REJECTED;
             }
             state = PacketState::WAIT_CMD;
             break;
 
         case PacketState::WAIT_CMD:
+            buffer[receivedBytes++] = byte;
             command = byte;
             calculatedXor ^= byte;
-            receivedBytes = 4;
-            dataIndex = 0;
 
-            if (expectedLength == PROTOCOL_MIN_PACKET_SIZE) {
-                state = PacketState::WAIT_XOR;
+            if (expectedLength == PROTOCOL_HEADER_SIZE + trailerSize) {
+                state = trailerState();
             } else {
                 state = PacketState::WAIT_DATA;
             }
             break;
 
         case PacketState::WAIT_DATA:
-            buffer[dataIndex++] = byte;
+            buffer[receivedBytes++] = byte;
             calculatedXor ^= byte;
-            receivedBytes++;
 
-            if (receivedBytes == expectedLength - 1) {
-                state = PacketState::WAIT_XOR;
+            if (receivedBytes == expectedLength - trailerSize) {
+                state = trailerState();
             }
             break;
 
         case PacketState::WAIT_XOR:
-            receivedBytes++;
-            if (calculatedXor == byte) {
-                state = PacketState::PACKET_READY;
-                return true;
-            } else {
-                reset();
-                return false;
+            buffer[receivedBytes++] = byte;
+            if (calculatedXor != byte) {
+                setError(Error::XOR_CHECKSUM_ERROR);
+                return ByteResult::REJECTED;
             }
-            break;
+            state = PacketState::PACKET_READY;
+            return ByteResult::READY;
 
+        case PacketState::WAIT_CRC: {
+            buffer[receivedBytes++] = byte;
+            if (receivedBytes < expectedLength) {
+                break;
+            }
+            uint8_t code = checkIntegrity();
+            if (code != 0) {
+                setError(code);
+                return ByteResult::REJECTED;
+            }
+            state = PacketState::PACKET_READY;
+            return ByteResult::READY;
+        }
+
+        case PacketState::WAIT_DELIMITER:
         case PacketState::PACKET_READY:
             break;
     }
 
+    return ByteResult::PENDING;
+}
+
+// COBS: байты копятся с buffer[1] до разделителя, затем декодируются на месте.
+// buffer[0] оставлен под STX, чтобы раскладка совпадала с обычным кадром.
+ByteResult PacketParser::consumeCobs(uint8_t byte) {
+    if (state == PacketState::PACKET_READY) {
+        return ByteResult::PENDING;
+    }
+
+    if (byte == PROTOCOL_COBS_DELIMITER) {
+        bool dropped = (state == PacketState::WAIT_DELIMITER);
+        uint16_t encodedLength = receivedBytes;
+        reset();
+        if (dropped || encodedLength == 0) {
+            return ByteResult::PENDING;
+        }
+        if (!acceptCobsFrame(encodedLength)) {
+            return ByteResult::REJECTED;
+        }
+        state = PacketState::PACKET_READY;
+        return ByteResult::READY;
+    }
+
+    if (state == PacketState::WAIT_DELIMITER) {
+        return ByteResult::PENDING;
+    }
+    if (receivedBytes >= PROTOCOL_COBS_MAX_FRAME_SIZE) {
+        setError(Error::INVALID_PACKET_LENGTH);
+        state = PacketState::WAIT_DELIMITER;
+        return ByteResult::REJECTED;
+    }
+
+    buffer[1 + receivedBytes++] = byte;
+    state = PacketState::WAIT_DATA;
+    return ByteResult::PENDING;
+}
+
+bool PacketParser::acceptCobsFrame(uint16_t encodedLength) {
+    uint16_t length = cobsDecode(buffer + 1, encodedLength);
+    if (length < PROTOCOL_HEADER_SIZE - 1 + trailerSize) {
+        setError(Error::INVALID_PACKET_LENGTH);
+        return false;
+    }
+
+    uint16_t declared = (static_cast<uint16_t>(buffer[1]) << 8) | buffer[2];
+    if (declared != length + 1 || declared > PROTOCOL_MAX_PACKET_SIZE) {
+        setError(Error::INVALID_PACKET_LENGTH);
+        return false;
+    }
+
+    buffer[0] = PROTOCOL_STX;
+    expectedLength = declared;
+    receivedBytes = declared;
+    command = buffer[3];
+
+    uint8_t code = checkIntegrity();
+    if (code != 0) {
+        setError(code);
+        return false;
+    }
+    return true;
+}
+
+// Кадр отброшен, но настоящий STX мог оказаться среди уже принятых байтов
+// (например, потерялась часть предыдущего кадра). Ищем его и прогоняем
+// хвост через парсер заново. Хвост сдвигается в начало буфера, поэтому
+// при повторном разборе байт i записывается ровно в buffer[i].
+bool PacketParser::resync() {
+    uint16_t count = receivedBytes;
+    uint16_t start = 1;
+
+    while (true) {
+        while (start < count && buffer[start] != PROTOCOL_STX) {
+            ++start;
+        }
+        if (start >= count) {
+            reset();
+            return false;
+        }
+
+        count -= start;
+        std::memmove(buffer, buffer + start, count);
+        reset();
+        resyncedFrames++;
+
+        bool rejected = false;
+        for (uint16_t i = 0; i < count; ++i) {
+            ByteResult result = consume(buffer[i]);
+            if (result == ByteResult::REJECTED) {
+                rejected = true;
+                break;
+            }
+            if (result == ByteResult::READY) {
+                if (i + 1 < count) {
+                    keepTail(buffer + i + 1, count - i - 1);
+                }
+                return true;
+            }
+        }
+
+        if (!rejected) {
+            return false;
+        }
+        start = 1;
+    }
+}
+
+// Хвост встает перед еще не разобранным остатком прежнего хвоста. Пока
+// carry разбирается, хвост - это последние взятые из него байты, поэтому
+// место перед carryHead для него всегда есть.
+void PacketParser::keepTail(const uint8_t* tail, uint16_t length) {
+    if (carryLength == 0) {
+        carryHead = PROTOCOL_BUFFER_SIZE;
+    }
+    carryHead -= length;
+    carryLength += length;
+    std::memmove(carry + carryHead, tail, length);
+}
+
+bool PacketParser::replayCarry() {
+    while (carryLength != 0) {
+        uint8_t byte = carry[carryHead++];
+        carryLength--;
+        if (processByte(byte)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PacketParser::checkTimeout(uint32_t now) {
+    if (state == PacketState::WAIT_STX || state == PacketState::PACKET_READY) {
+        return false;
+    }
+    if (now - lastByteTime < PROTOCOL_INTERBYTE_TIMEOUT_MS) {
+        return false;
+    }
+    if (state == PacketState::WAIT_DELIMITER) {
+        reset();  // NAK уже отправлен при переполнении
+        return false;
+    }
+
+    abortedFrames++;
+    uint8_t pendingError = error;
+    setError(Error::FRAME_TIMEOUT);
+    if (sessionFlags & Session::COBS_FRAMING) {
+        // В COBS искать начало кадра внутри принятого незачем: опоздавший
+        // хвост отсеется на ближайшем 0x00, следующий кадр начнется с нуля
+        reset();
+        return false;
+    }
+    if (resync()) {
+        error = pendingError;  // Найденный кадр исполнится: без FRAME_TIMEOUT
+        acceptedFrames++;
+        return true;
+    }
     return false;
 }
 
@@ -90,11 +308,43 @@ bool PacketParser::isComplete() const {
     return state == PacketState::PACKET_READY;
 }
 
+// Счетчики учитывают каждый отказ, но до отправки NAK сохраняется первая
+// ошибка: ложные кадры, найденные при повторном поиске STX, не должны
+// подменять причину отказа
+void PacketParser::setError(uint8_t code) {
+    if (code == Error::INVALID_PACKET_LENGTH) {
+        lengthErrors++;
+    } else if (code == Error::XOR_CHECKSUM_ERROR) {
+        xorErrors++;
+    } else if (code == Error::CRC_CHECKSUM_ERROR) {
+        crcErrors++;
+    }
+
+    if (error == 0) {
+        error = code;
+    }
+}
+
+uint8_t PacketParser::takeError() {
+    uint8_t code = error;
+    error = 0;
+    return code;
+}
+
+void PacketParser::clearCounters() {
+    abortedFrames = 0;
+    resyncedFrames = 0;
+    acceptedFrames = 0;
+    lengthErrors = 0;
+    xorErrors = 0;
+    crcErrors = 0;
+}
+
 uint16_t PacketParser::getDataLength() const {
-    if (expectedLength <= PROTOCOL_MIN_PACKET_SIZE) {
+    if (expectedLength <= PROTOCOL_HEADER_SIZE + trailerSize) {
         return 0;
     }
-    return expectedLength - PROTOCOL_MIN_PACKET_SIZE;
+    return expectedLength - PROTOCOL_HEADER_SIZE - trailerSize;
 }
 
 uint8_t calculateXor(const uint8_t* data, uint16_t length) {
@@ -104,3 +354,66 @@ uint8_t calculateXor(const uint8_t* data, uint16_t length) {
     }
     return xorValue;
 }
+
+uint8_t decodeVarint(const uint8_t* data, uint16_t length, uint64_t* value) {
+    uint64_t result = 0;
+    for (uint8_t i = 0; i < 10 && i < length; ++i) {
+        result |= static_cast<uint64_t>(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+uint16_t cobsDecode(uint8_t* data, uint16_t length) {
+    uint16_t read = 0;
+    uint16_t write = 0;
+
+    while (read < length) {
+        uint8_t code = data[read++];
+        if (code == 0 || read + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; ++i) {
+            data[write++] = data[read++];
+        }
+        if (code != 0xFF && read < length) {
+            data[write++] = 0;
+        }
+    }
+
+    return write;
+}
+
+uint16_t cobsEncode(const uint8_t* data, uint16_t length, uint8_t* out, uint16_t capacity) {
+    uint16_t write = 1;
+    uint16_t codePos = 0;
+    uint8_t code = 1;
+
+    for (uint16_t i = 0; i < length; ++i) {
+        if (write >= capacity) {
+            return 0;
+        }
+        if (data[i] != 0) {
+            out[write++] = data[i];
+            code++;
+        }
+        if (data[i] == 0 || code == 0xFF) {
+            out[codePos] = code;
+            codePos = write++;
+            code = 1;
+            if (codePos >= capacity) {
+                return 0;
+            }
+        }
+    }
+
+    if (write >= capacity) {
+        return 0;
+    }
+    out[codePos] = code;
+    out[write++] = PROTOCOL_COBS_DELIMITER;
+    return write;
+}
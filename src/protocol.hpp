@@ -10,26 +10,122 @@ enum class PacketState : uint8_t {
     WAIT_CMD,
     WAIT_DATA,
     WAIT_XOR,
+    WAIT_CRC,
+    WAIT_DELIMITER,  // COBS: кадр отброшен, пропуск до разделителя 0x00
     PACKET_READY
 };
 
+enum class ByteResult : uint8_t {
+    PENDING,
+    READY,
+    REJECTED
+};
+
 struct PacketParser {
     PacketState state;
     uint16_t expectedLength;
     uint16_t receivedBytes;
-    uint16_t dataIndex;
     uint8_t command;
     uint8_t calculatedXor;
-    uint8_t buffer[PROTOCOL_MAX_PACKET_SIZE];
+    uint8_t error;        // Код ошибки для NAK (0 - ошибок нет)
+    uint8_t trailerSize;  // 1 (XOR) или PROTOCOL_CRC_SIZE, фиксируется в reset()
+    uint32_t lastByteTime;
+    uint32_t abortedFrames;   // Кадры, прерванные по межбайтовому таймауту
+    uint32_t resyncedFrames;  // Повторные захваты STX внутри отброшенного кадра
+    uint32_t acceptedFrames;  // Кадры, прошедшие проверку
+    uint32_t lengthErrors;    // Отказы по длине (включая переполнение COBS)
+    uint32_t xorErrors;
+    uint32_t crcErrors;
+    uint8_t buffer[PROTOCOL_BUFFER_SIZE];  // Кадр целиком, начиная с STX
+    // Байты за кадром, который нашел resync(): разбираются раньше новых из кольца
+    uint8_t carry[PROTOCOL_BUFFER_SIZE];
+    uint16_t carryHead;
+    uint16_t carryLength;
 
     PacketParser();
     void reset();
     bool processByte(uint8_t byte);
+    bool hasCarry() const { return carryLength != 0; }
+    bool replayCarry();
+    bool checkTimeout(uint32_t now);
     bool isComplete() const;
+    bool hasError() const { return error != 0; }
+    uint8_t takeError();
+    void clearCounters();
 
     uint8_t getCommand() const { return command; }
-    const uint8_t* getData() const { return buffer; }
+    const uint8_t* getData() const { return buffer + PROTOCOL_HEADER_SIZE; }
     uint16_t getDataLength() const;
+
+private:
+    ByteResult consume(uint8_t byte);
+    ByteResult consumeCobs(uint8_t byte);
+    PacketState trailerState() const;
+    uint8_t checkIntegrity() const;
+    bool acceptCobsFrame(uint16_t encodedLength);
+    bool resync();
+    void keepTail(const uint8_t* tail, uint16_t length);
+    void setError(uint8_t code);
 };
 
 uint8_t calculateXor(const uint8_t* data, uint16_t length);
+
+// Запись полей ответа в little-endian, возвращает позицию за записанным
+inline uint8_t* putLe16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value & 0xFF);
+    out[1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    return out + 2;
+}
+
+inline uint8_t* putLe32(uint8_t* out, uint32_t value) {
+    out = putLe16(out, static_cast<uint16_t>(value & 0xFFFF));
+    return putLe16(out, static_cast<uint16_t>(value >> 16));
+}
+
+inline uint8_t* putLe64(uint8_t* out, uint64_t value) {
+    out = putLe32(out, static_cast<uint32_t>(value & 0xFFFFFFFF));
+    return putLe32(out, static_cast<uint32_t>(value >> 32));
+}
+
+inline uint32_t getLe32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// Маска моторов шириной MOTOR_MASK_SIZE; ветка выбирается при компиляции
+inline uint8_t* putMotorMask(uint8_t* out, MotorMask mask) {
+    if (MOTOR_MASK_SIZE == 2) {
+        return putLe16(out, static_cast<uint16_t>(mask));
+    }
+    if (MOTOR_MASK_SIZE == 4) {
+        return putLe32(out, static_cast<uint32_t>(mask));
+    }
+    return putLe64(out, mask);
+}
+
+/**
+ * @brief Чтение varint (LEB128: по 7 бит, младшие первыми, старший бит - продолжение)
+ * @param data Начало поля
+ * @param length Байт, доступных от data
+ * @param value Результат
+ * @return Длина поля, 0 если оно обрезано или длиннее 10 байт
+ */
+uint8_t decodeVarint(const uint8_t* data, uint16_t length, uint64_t* value);
+
+/**
+ * @brief Декодирование COBS на месте (без разделителя)
+ * @param data Закодированные данные, сюда же пишется результат
+ * @param length Длина закодированных данных
+ * @return Длина декодированных данных, 0 если кадр некорректен
+ */
+uint16_t cobsDecode(uint8_t* data, uint16_t length);
+
+/**
+ * @brief Кодирование COBS в отдельный буфер, с разделителем 0x00 в конце
+ * @param data Исходные данные
+ * @param length Длина исходных данных
+ * @param out Буфер результата
+ * @param capacity Размер out
+ * @return Длина результата, 0 если не поместился
+ */
+uint16_t cobsEncode(const uint8_t* data, uint16_t length, uint8_t* out, uint16_t capacity);
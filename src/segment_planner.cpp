@@ -0,0 +1,95 @@
+#include "segment_planner.hpp"
+#include "linear_planner.hpp"
+#include "motor_settings.hpp"
+#include "protocol.hpp"
+
+uint8_t SegmentPlanner::_commands[SEGMENT_MAX * 16];
+uint8_t SegmentPlanner::_commandCount = 0;
+uint32_t SegmentPlanner::_standaloneMs = 0;
+uint32_t SegmentPlanner::_plannedMs = 0;
+
+static constexpr uint32_t MAX_RUN_STEPS = 0x7FFFFFFF;
+
+static uint32_t addSaturated(uint32_t a, uint32_t b) {
+    return a > 0xFFFFFFFFU - b ? 0xFFFFFFFFU : a + b;
+}
+
+uint32_t SegmentPlanner::trapezoidMs(uint32_t steps, uint32_t acceleration, uint32_t speed) {
+    uint64_t s = steps;
+    uint64_t ms = 0;
+    if (s * acceleration >= static_cast<uint64_t>(speed) * speed) {
+        // Разгон, крейсер, торможение: s / v + v / a
+        ms = (s * 1000 + speed / 2) / speed +
+             (static_cast<uint64_t>(speed) * 1000 + acceleration / 2) / acceleration;
+    } else {
+        // Треугольник, скорость не достигнута: 2 * sqrt(s / a)
+        ms = 2ULL * LinearPlanner::isqrt(s * 1000000ULL / acceleration);
+    }
+    return ms > 0xFFFFFFFFULL ? 0xFFFFFFFFU : static_cast<uint32_t>(ms);
+}
+
+void SegmentPlanner::emit(uint8_t motor, const Run& run) {
+    uint32_t steps = run.reverse ? 0U - run.steps : run.steps;
+    MotorSettings(motor, run.acceleration, run.speed, steps).serialize(_commands + _commandCount * 16);
+    _commandCount++;
+    _plannedMs = addSaturated(_plannedMs, run.ms);
+}
+
+uint8_t SegmentPlanner::plan(uint8_t motor, const uint8_t* segments, uint8_t count, uint8_t* badIndex) {
+    _commandCount = 0;
+    _standaloneMs = 0;
+    _plannedMs = 0;
+
+    for (uint8_t i = 0; i < count; ++i) {
+        *badIndex = i;
+        const uint8_t* seg = segments + i * SEGMENT_RECORD_SIZE;
+        uint8_t reason = MotorSettings(motor, getLe32(seg), getLe32(seg + 4), getLe32(seg + 8)).fault();
+        if (reason != ParamFault::NONE) {
+            return reason;
+        }
+    }
+    *badIndex = 0;
+
+    Run run = {0, 0, 0, false, 0, 0};
+    for (uint8_t i = 0; i < count; ++i) {
+        const uint8_t* seg = segments + i * SEGMENT_RECORD_SIZE;
+        uint32_t steps = getLe32(seg + 8);
+        if (steps == 0) {
+            continue;  // Без направления и без движения: стык не разрывает
+        }
+
+        Run next;
+        next.acceleration = getLe32(seg);
+        next.speed = getLe32(seg + 4);
+        next.reverse = (steps & 0x80000000U) != 0;
+        next.steps = next.reverse ? 0U - steps : steps;
+        next.ms = trapezoidMs(next.steps, next.acceleration, next.speed);
+        next.segments = 1;
+        _standaloneMs = addSaturated(_standaloneMs, next.ms);
+
+        // Стык с ненулевой скоростью: то же направление, окно не заполнено
+        if (run.segments != 0 && run.reverse == next.reverse &&
+            run.segments < SEGMENT_LOOKAHEAD && run.steps <= MAX_RUN_STEPS - next.steps) {
+            Run merged = run;
+            merged.acceleration = next.acceleration < run.acceleration ? next.acceleration : run.acceleration;
+            merged.speed = next.speed < run.speed ? next.speed : run.speed;
+            merged.steps = run.steps + next.steps;
+            merged.ms = trapezoidMs(merged.steps, merged.acceleration, merged.speed);
+            merged.segments = run.segments + 1;
+            if (merged.ms <= addSaturated(run.ms, next.ms)) {
+                run = merged;
+                continue;
+            }
+        }
+
+        if (run.segments != 0) {
+            emit(motor, run);
+        }
+        run = next;
+    }
+
+    if (run.segments != 0) {
+        emit(motor, run);
+    }
+    return ParamFault::NONE;
+}
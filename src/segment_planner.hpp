@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+
+// Сегмент SEGMENT_MOVE: accel u32 + speed u32 + steps i32
+constexpr uint8_t SEGMENT_RECORD_SIZE = 12;
+// Сегментов в кадре: motor u8 + 20 * 12 = 241 байт
+constexpr uint8_t SEGMENT_MAX = 20;
+// Сегментов в одной команде драйверу - окно, в котором сравниваются трапеции
+constexpr uint8_t SEGMENT_LOOKAHEAD = 8;
+// Ответ: result u8 | segments u8 | commands u8 | standaloneMs u32 | plannedMs u32 | elapsedMs u32
+constexpr uint8_t SEGMENT_REPORT_SIZE = 15;
+
+/**
+ * Слияние цепочки коротких движений одного мотора.
+ *
+ * Пакет драйверу (14 байт) - одна трапеция с нулевой скоростью на обоих
+ * концах: передать скорость стыка драйверу нельзя. Поэтому цепочка из N
+ * сегментов - это N остановок и N разгонов.
+ *
+ * Скорость стыка двух сегментов одного направления - min(speed), на
+ * развороте - 0. Если она не 0, сегменты можно исполнить одной трапецией:
+ * шаги - сумма, ускорение и скорость - минимум по сегментам (ни один
+ * сегмент не едет быстрее своего предела). Сегмент присоединяется, только
+ * если слитная трапеция не дольше, чем команда до него плюс он отдельно:
+ * медленный сегмент не тормозит длинный быстрый.
+ *
+ * Время трапеции считается целыми мс (как у моторов в LINEAR_MOVE, без FPU).
+ */
+class SegmentPlanner {
+public:
+    /**
+     * @brief Проверить сегменты и собрать команды драйверу
+     * @param segments count сегментов по SEGMENT_RECORD_SIZE байт
+     * @param badIndex Номер первого неверного сегмента
+     * @return ParamFault::NONE или причина из MotorSettings::fault()
+     */
+    static uint8_t plan(uint8_t motor, const uint8_t* segments, uint8_t count, uint8_t* badIndex);
+
+    static uint8_t commandCount() { return _commandCount; }
+    // Запись MotorParams команды index для startMotors()
+    static const uint8_t* command(uint8_t index) { return _commands + index * 16; }
+
+    // Оценка времени движения, мс: каждый сегмент отдельно и после слияния
+    static uint32_t standaloneMs() { return _standaloneMs; }
+    static uint32_t plannedMs() { return _plannedMs; }
+
+    // Время трапеции от 0 до 0, мс (насыщается на 0xFFFFFFFF)
+    static uint32_t trapezoidMs(uint32_t steps, uint32_t acceleration, uint32_t speed);
+
+private:
+    struct Run {
+        uint32_t acceleration;
+        uint32_t speed;
+        uint32_t steps;      // Модуль
+        bool reverse;
+        uint32_t ms;
+        uint8_t segments;
+    };
+
+    static void emit(uint8_t motor, const Run& run);
+
+    static uint8_t _commands[SEGMENT_MAX * 16];
+    static uint8_t _commandCount;
+    static uint32_t _standaloneMs;
+    static uint32_t _plannedMs;
+};
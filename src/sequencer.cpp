@@ -0,0 +1,329 @@
+#include "sequencer.hpp"
+#include "motor_driver.hpp"
+#include "motor_settings.hpp"
+#include "protocol.hpp"
+#include "memory_sections.hpp"
+#include "board.hpp"
+#include "log.hpp"
+
+CCMRAM_BSS uint8_t Sequencer::_program[SEQUENCE_PROGRAM_SIZE];
+uint16_t Sequencer::_length = 0;
+SeqState Sequencer::_state = SeqState::IDLE;
+uint8_t Sequencer::_reason = SeqResult::OK;
+uint16_t Sequencer::_pc = 0;
+Sequencer::Loop Sequencer::_loops[SEQUENCE_LOOP_DEPTH];
+uint8_t Sequencer::_loopDepth = 0;
+bool Sequencer::_stepEntered = false;
+uint32_t Sequencer::_steps = 0;
+uint32_t Sequencer::_runStart = 0;
+uint32_t Sequencer::_runEnd = 0;
+uint32_t Sequencer::_stepStart = 0;
+uint16_t Sequencer::_lastPc = 0;
+uint32_t Sequencer::_lastMs = 0;
+uint16_t Sequencer::_maxPc = 0;
+uint32_t Sequencer::_maxMs = 0;
+
+static constexpr uint8_t MOVE_RECORD_SIZE = 16;
+static constexpr uint8_t ENDSTOP_INPUTS = 6;
+
+void Sequencer::clear() {
+    _length = 0;
+    _state = SeqState::IDLE;
+    _reason = SeqResult::OK;
+    _pc = 0;
+}
+
+uint8_t Sequencer::load(uint16_t offset, const uint8_t* data, uint16_t length) {
+    if (_state == SeqState::RUNNING) {
+        return SeqResult::BUSY;
+    }
+    if (offset > _length || offset + length > SEQUENCE_PROGRAM_SIZE) {
+        return SeqResult::OVERFLOW;
+    }
+
+    for (uint16_t i = 0; i < length; ++i) {
+        _program[offset + i] = data[i];
+    }
+    if (offset + length > _length) {
+        _length = offset + length;
+    }
+    return SeqResult::OK;
+}
+
+// Длина инструкции с операндами, 0 - инструкция неизвестна или обрезана
+uint16_t Sequencer::instructionSize(uint16_t pc) {
+    const uint8_t* op = _program + pc;
+    uint16_t avail = _length - pc;
+    uint64_t value = 0;
+
+    switch (op[0]) {
+        case SeqOpcode::END:
+        case SeqOpcode::END_LOOP:
+            return 1;
+
+        case SeqOpcode::MOVE: {
+            if (avail < 2) {
+                return 0;
+            }
+            uint16_t size = 2 + op[1] * MOVE_RECORD_SIZE;
+            return size <= avail ? size : 0;
+        }
+
+        case SeqOpcode::WAIT:
+        case SeqOpcode::DELAY:
+        case SeqOpcode::LOOP: {
+            uint8_t field = decodeVarint(op + 1, avail - 1, &value);
+            return field != 0 ? 1 + field : 0;
+        }
+
+        case SeqOpcode::WAIT_INPUT:
+            return avail >= 3 ? 3 : 0;
+
+        default:
+            return 0;
+    }
+}
+
+// Проверка всей программы до запуска: формат, параметры моторов, вложенность циклов
+bool Sequencer::validate(uint16_t* badPc) {
+    uint8_t depth = 0;
+    uint16_t pc = 0;
+
+    while (pc < _length) {
+        *badPc = pc;
+        const uint8_t* op = _program + pc;
+        uint16_t size = instructionSize(pc);
+        if (size == 0) {
+            return false;
+        }
+
+        uint64_t value = 0;
+        switch (op[0]) {
+            case SeqOpcode::MOVE: {
+                uint8_t count = op[1];
+                uint8_t badIndex = 0;
+                if (count == 0 || count > MAX_MOTORS ||
+                    MotorSettings::validateBatch(op + 2, count, &badIndex) != ParamFault::NONE) {
+                    return false;
+                }
+                break;
+            }
+
+            case SeqOpcode::WAIT:
+                decodeVarint(op + 1, size - 1, &value);
+                if ((value & ~static_cast<uint64_t>(ALL_MOTORS_MASK)) != 0) {
+                    return false;
+                }
+                break;
+
+            case SeqOpcode::DELAY:
+                decodeVarint(op + 1, size - 1, &value);
+                if (value > 0xFFFFFFFFULL) {
+                    return false;
+                }
+                break;
+
+            case SeqOpcode::LOOP:
+                decodeVarint(op + 1, size - 1, &value);
+                if (value > 0xFFFFFFFFULL || ++depth > SEQUENCE_LOOP_DEPTH) {
+                    return false;
+                }
+                break;
+
+            case SeqOpcode::END_LOOP:
+                if (depth == 0) {
+                    return false;
+                }
+                depth--;
+                break;
+
+            case SeqOpcode::WAIT_INPUT:
+                if (op[1] >= ENDSTOP_INPUTS || op[2] > 1) {
+                    return false;
+                }
+                break;
+
+            default:
+                break;
+        }
+        pc += size;
+    }
+
+    *badPc = pc;
+    return depth == 0;
+}
+
+uint8_t Sequencer::run(uint32_t now, uint16_t* badPc) {
+    *badPc = 0;
+    if (_state == SeqState::RUNNING || g_motorDriver.isRunning()) {
+        return SeqResult::BUSY;
+    }
+    if (!validate(badPc)) {
+        return SeqResult::INVALID;
+    }
+
+    _state = SeqState::RUNNING;
+    _reason = SeqResult::OK;
+    _pc = 0;
+    _loopDepth = 0;
+    _stepEntered = false;
+    _steps = 0;
+    _runStart = now;
+    _runEnd = now;
+    _lastPc = 0;
+    _lastMs = 0;
+    _maxPc = 0;
+    _maxMs = 0;
+    *badPc = 0;
+    return SeqResult::OK;
+}
+
+bool Sequencer::stop() {
+    if (_state != SeqState::RUNNING) {
+        return false;
+    }
+    g_motorDriver.stopAll();
+    fail(SeqResult::STOPPED);
+    _state = SeqState::IDLE;
+    return true;
+}
+
+void Sequencer::fail(uint8_t reason) {
+    _state = SeqState::FAULT;
+    _reason = reason;
+    _runEnd = systemTicks;
+    LOG("seq stop at pc %u, reason %u", _pc, reason);
+}
+
+void Sequencer::poll(uint32_t now) {
+    for (uint8_t n = 0; n < SEQUENCE_STEPS_PER_POLL && _state == SeqState::RUNNING; ++n) {
+        if (!_stepEntered) {
+            _stepEntered = true;
+            _stepStart = now;
+            _steps++;
+        }
+
+        uint16_t pc = _pc;
+        Step step = execute(now);
+        if (step == Step::BLOCKED) {
+            return;
+        }
+
+        _lastPc = pc;
+        finishStep(now);
+        if (step == Step::FINISHED) {
+            return;
+        }
+    }
+}
+
+void Sequencer::finishStep(uint32_t now) {
+    _stepEntered = false;
+    _lastMs = now - _stepStart;
+    if (_lastMs >= _maxMs) {
+        _maxMs = _lastMs;
+        _maxPc = _lastPc;
+    }
+}
+
+// Программа уже проверена validate(): операнды в границах и корректны
+Sequencer::Step Sequencer::execute(uint32_t now) {
+    if (_pc >= _length) {
+        _state = SeqState::DONE;  // Без END в конце - то же, что END
+        _runEnd = now;
+        return Step::FINISHED;
+    }
+
+    const uint8_t* op = _program + _pc;
+    uint16_t size = instructionSize(_pc);
+    uint64_t value = 0;
+
+    switch (op[0]) {
+        case SeqOpcode::END:
+            _state = SeqState::DONE;
+            _runEnd = now;
+            return Step::FINISHED;
+
+        case SeqOpcode::MOVE:
+            if (g_motorDriver.isRunning()) {
+                return Step::BLOCKED;
+            }
+            g_motorDriver.startMotors(op + 2, op[1]);
+            break;
+
+        case SeqOpcode::WAIT: {
+            decodeVarint(op + 1, size - 1, &value);
+            MotorMask active = g_motorDriver.getActiveMotors();
+            MotorMask target = value != 0 ? static_cast<MotorMask>(value) & active : active;
+            if (g_motorDriver.getFaultedMotors() & target) {
+                fail(SeqResult::MOTOR_FAULT);
+                return Step::FINISHED;
+            }
+            if ((g_motorDriver.getCompletedMotors() & target) != target) {
+                return Step::BLOCKED;
+            }
+            break;
+        }
+
+        case SeqOpcode::DELAY:
+            decodeVarint(op + 1, size - 1, &value);
+            if (now - _stepStart < static_cast<uint32_t>(value)) {
+                return Step::BLOCKED;
+            }
+            break;
+
+        case SeqOpcode::LOOP:
+            decodeVarint(op + 1, size - 1, &value);
+            _loops[_loopDepth].start = _pc + size;
+            _loops[_loopDepth].remaining = static_cast<uint32_t>(value);
+            _loopDepth++;
+            break;
+
+        case SeqOpcode::END_LOOP: {
+            Loop& loop = _loops[_loopDepth - 1];
+            if (loop.remaining == 0 || --loop.remaining != 0) {
+                _pc = loop.start;
+                return Step::NEXT;
+            }
+            _loopDepth--;
+            break;
+        }
+
+        case SeqOpcode::WAIT_INPUT: {
+            uint32_t level = (Board::Endstop::read() >> op[1]) & 1U;
+            if (level != op[2]) {
+                return Step::BLOCKED;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    _pc += size;
+    return Step::NEXT;
+}
+
+uint8_t Sequencer::serialize(uint8_t* out, uint32_t now) {
+    bool running = _state == SeqState::RUNNING;
+    uint32_t runMs = (running ? now : _runEnd) - _runStart;
+    uint32_t stepMs = (running && _stepEntered) ? now - _stepStart : 0;
+    uint32_t loopRemaining = _loopDepth != 0 ? _loops[_loopDepth - 1].remaining : 0;
+
+    uint8_t* p = out;
+    *p++ = static_cast<uint8_t>(_state);
+    *p++ = _reason;
+    p = putLe16(p, _pc);
+    p = putLe16(p, _length);
+    p = putLe32(p, _steps);
+    p = putLe32(p, runMs);
+    p = putLe16(p, _pc);
+    p = putLe32(p, stepMs);
+    p = putLe16(p, _lastPc);
+    p = putLe32(p, _lastMs);
+    p = putLe16(p, _maxPc);
+    p = putLe32(p, _maxMs);
+    p = putLe32(p, loopRemaining);
+    return static_cast<uint8_t>(p - out);
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+
+// Программа в CCMRAM, загружается кусками командой SEQUENCE LOAD
+constexpr uint16_t SEQUENCE_PROGRAM_SIZE = 1024;
+constexpr uint8_t SEQUENCE_LOOP_DEPTH = 4;
+// Инструкций за один вызов poll(): цикл без ожиданий не задержит главный цикл
+constexpr uint8_t SEQUENCE_STEPS_PER_POLL = 16;
+constexpr uint8_t SEQUENCE_STATUS_SIZE = 36;
+
+// Подкоманды SEQUENCE (первый байт данных)
+namespace SeqOp {
+    constexpr uint8_t CLEAR  = 0x00;
+    constexpr uint8_t LOAD   = 0x01;  // offset u16 + байты программы
+    constexpr uint8_t RUN    = 0x02;
+    constexpr uint8_t STOP   = 0x03;
+    constexpr uint8_t STATUS = 0x04;
+}
+
+/**
+ * Инструкции. Числа - varint (LEB128), маска 0 - все моторы текущего движения.
+ *
+ *   END                                 конец программы
+ *   MOVE count u8, count * 16 байт      запуск как ASYNC_MOVE (ждет, пока MotorDriver занят)
+ *   WAIT mask                           все моторы маски завершились
+ *   DELAY ms                            пауза
+ *   LOOP count                          тело до END_LOOP count раз, 0 - бесконечно
+ *   END_LOOP
+ *   WAIT_INPUT input u8, level u8       ENDSTOP input (0-5) в уровне level
+ */
+namespace SeqOpcode {
+    constexpr uint8_t END        = 0x00;
+    constexpr uint8_t MOVE       = 0x01;
+    constexpr uint8_t WAIT       = 0x02;
+    constexpr uint8_t DELAY      = 0x03;
+    constexpr uint8_t LOOP       = 0x04;
+    constexpr uint8_t END_LOOP   = 0x05;
+    constexpr uint8_t WAIT_INPUT = 0x06;
+}
+
+// Результат подкоманд, он же причина остановки в STATUS
+namespace SeqResult {
+    constexpr uint8_t OK          = 0x00;
+    constexpr uint8_t BUSY        = 0x01;  // Программа или движение уже идут
+    constexpr uint8_t INVALID     = 0x02;  // Программа не прошла проверку, pc - где
+    constexpr uint8_t OVERFLOW    = 0x03;  // LOAD за пределами буфера или с пропуском
+    constexpr uint8_t MOTOR_FAULT = 0x04;  // WAIT: мотор маски завершился аварийно
+    constexpr uint8_t STOPPED     = 0x05;  // Остановлена командой
+}
+
+enum class SeqState : uint8_t {
+    IDLE,
+    RUNNING,
+    DONE,
+    FAULT
+};
+
+/**
+ * Интерпретатор программ движения поверх MotorDriver.
+ *
+ * Повторяющийся цикл (MOVE, WAIT, DELAY, LOOP) идет целиком на MCU,
+ * без круга до хоста на каждый шаг. Программа проверяется целиком до
+ * запуска (RUN), поэтому во время работы ошибок разбора не бывает.
+ *
+ * poll() из главного цикла исполняет инструкции подряд, пока очередная
+ * не должна ждать (движение, маска, пауза, вход), но не больше
+ * SEQUENCE_STEPS_PER_POLL за вызов. Шаг - одна инструкция; его время
+ * (мс, SysTick) от входа до перехода к следующей отдается в STATUS.
+ */
+class Sequencer {
+public:
+    static void clear();
+
+    /**
+     * @brief Записать кусок программы
+     * @param offset Смещение, не дальше текущей длины (повтор куска безопасен)
+     * @return SeqResult::OK, BUSY или OVERFLOW
+     */
+    static uint8_t load(uint16_t offset, const uint8_t* data, uint16_t length);
+
+    /**
+     * @brief Проверить и запустить программу с начала
+     * @param badPc Для INVALID - смещение неверной инструкции
+     */
+    static uint8_t run(uint32_t now, uint16_t* badPc);
+
+    // Остановка программы и моторов; false - программа не шла
+    static bool stop();
+
+    static void poll(uint32_t now);
+
+    static bool isRunning() { return _state == SeqState::RUNNING; }
+    static uint16_t length() { return _length; }
+
+    /**
+     * @brief STATUS: state u8 | reason u8 | pc u16 | length u16 | steps u32 |
+     *        runMs u32 | stepPc u16 | stepMs u32 | lastPc u16 | lastMs u32 |
+     *        maxPc u16 | maxMs u32 | loopRemaining u32
+     */
+    static uint8_t serialize(uint8_t* out, uint32_t now);
+
+private:
+    enum class Step : uint8_t { BLOCKED, NEXT, FINISHED };
+
+    struct Loop {
+        uint16_t start;      // Первая инструкция тела
+        uint32_t remaining;  // 0 - бесконечный цикл
+    };
+
+    static uint16_t instructionSize(uint16_t pc);
+    static bool validate(uint16_t* badPc);
+    static Step execute(uint32_t now);
+    static void finishStep(uint32_t now);
+    static void fail(uint8_t reason);
+
+    static uint8_t _program[SEQUENCE_PROGRAM_SIZE];
+    static uint16_t _length;
+    static SeqState _state;
+    static uint8_t _reason;
+    static uint16_t _pc;
+    static Loop _loops[SEQUENCE_LOOP_DEPTH];
+    static uint8_t _loopDepth;
+    static bool _stepEntered;
+    static uint32_t _steps;
+    static uint32_t _runStart;
+    static uint32_t _runEnd;
+    static uint32_t _stepStart;
+    static uint16_t _lastPc;
+    static uint32_t _lastMs;
+    static uint16_t _maxPc;
+    static uint32_t _maxMs;
+};
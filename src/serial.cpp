@@ -1,5 +1,10 @@
 #include "serial.hpp"
 #include "constants.hpp"
+#include "protocol.hpp"
+#include "crc32.hpp"
+#include "memory_sections.hpp"
+#include "trace.hpp"
+#include "uart_dma.hpp"
 #include "../system/include/cmsis/stm32f4xx.h"
 
 static void initUSART2()
@@ -14,25 +19,11 @@ static void initUSART2()
     USART2->CR1 |= USART_CR1_UE;
 }
 
-static void initUART4()
-{
-    RCC->APB1ENR |= RCC_APB1ENR_UART4EN;
-    UART4->CR1 = 0;
-    UART4->CR2 = 0;
-    UART4->CR3 = 0;
-
-    UART4->BRR = 0x8B;  // 115200
-    UART4->CR1 |= (USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE);
-    UART4->CR1 |= USART_CR1_UE;
-
-    NVIC_EnableIRQ(UART4_IRQn);
-    NVIC_SetPriority(UART4_IRQn, 5);
-}
-
+// UART4 (ПК) целиком настраивает UartDma::init(): повторная настройка
+// здесь сбросила бы уже запущенный прием по DMA
 void initSerial()
 {
     initUSART2();
-    initUART4();
 }
 
 void sendByte2PC(uint8_t data)
@@ -41,52 +32,143 @@ void sendByte2PC(uint8_t data)
     UART4->DR = data;
 }
 
-void sendPacket(uint8_t responseCmd, const uint8_t* data, uint16_t dataLen) {
-    uint16_t totalLength = PROTOCOL_MIN_PACKET_SIZE + dataLen;
-    uint8_t lengthH = static_cast<uint8_t>(totalLength >> 8);
-    uint8_t lengthL = static_cast<uint8_t>(totalLength & 0xFF);
+// Отправка побайтовая (CPU), DMA кадр не читает
+CCMRAM_BSS static uint8_t txFrame[PROTOCOL_MAX_PACKET_SIZE];
 
-    uint8_t xorValue = lengthH ^ lengthL ^ responseCmd;
-    for (uint16_t i = 0; i < dataLen; ++i) {
-        xorValue ^= data[i];
+static void sendCobsBlock(const uint8_t* block, uint16_t length) {
+    sendByte2PC(static_cast<uint8_t>(length + 1));
+    for (uint16_t i = 0; i < length; ++i) {
+        sendByte2PC(block[i]);
+    }
+}
+
+// Потоковое COBS-кодирование: каждый блок до нуля (не длиннее 254 байт)
+// уходит сразу, второй буфер под закодированный кадр не нужен
+static void sendCobs(const uint8_t* data, uint16_t length) {
+    uint16_t blockStart = 0;
+
+    for (uint16_t i = 0; i <= length; ++i) {
+        if (i == length || data[i] == 0) {
+            sendCobsBlock(data + blockStart, i - blockStart);
+            blockStart = i + 1;
+        } else if (i + 1 - blockStart == 254) {
+            sendCobsBlock(data + blockStart, 254);
+            blockStart = i + 1;
+        }
     }
 
-    sendByte2PC(PROTOCOL_STX);
-    sendByte2PC(lengthH);
-    sendByte2PC(lengthL);
-    sendByte2PC(responseCmd);
+    sendByte2PC(PROTOCOL_COBS_DELIMITER);
+}
 
+// Кадр в txFrame в формате текущей сессии (до COBS), 0 - не помещается
+static uint16_t buildFrame(uint8_t responseCmd, const uint8_t* data, uint16_t dataLen) {
+    bool useCrc = (sessionFlags & Session::CRC32) != 0;
+    uint8_t trailerSize = useCrc ? PROTOCOL_CRC_SIZE : 1;
+    uint16_t totalLength = PROTOCOL_HEADER_SIZE + dataLen + trailerSize;
+    if (totalLength > PROTOCOL_MAX_PACKET_SIZE) {
+        return 0;
+    }
+
+    txFrame[0] = PROTOCOL_STX;
+    txFrame[1] = static_cast<uint8_t>(totalLength >> 8);
+    txFrame[2] = static_cast<uint8_t>(totalLength & 0xFF);
+    txFrame[3] = responseCmd;
     for (uint16_t i = 0; i < dataLen; ++i) {
-        sendByte2PC(data[i]);
+        txFrame[PROTOCOL_HEADER_SIZE + i] = data[i];
+    }
+
+    uint16_t bodyLength = totalLength - 1 - trailerSize;
+    if (useCrc) {
+        uint32_t crc = Crc32::compute(txFrame + 1, bodyLength);
+        for (uint8_t i = 0; i < PROTOCOL_CRC_SIZE; ++i) {
+            txFrame[totalLength - PROTOCOL_CRC_SIZE + i] = static_cast<uint8_t>(crc >> (i * 8));
+        }
+    } else {
+        txFrame[totalLength - 1] = calculateXor(txFrame + 1, bodyLength);
+    }
+    return totalLength;
+}
+
+void sendPacket(uint8_t responseCmd, const uint8_t* data, uint16_t dataLen) {
+    Trace::response(responseCmd);
+    uint16_t totalLength = buildFrame(responseCmd, data, dataLen);
+    if (totalLength == 0) {
+        return;
+    }
+
+    // Кадр телеметрии, уже отданный DMA, дописывается первым: байты
+    // двух кадров не перемешиваются
+    while (g_uartDma.isTxBusy());
+
+    if (sessionFlags & Session::COBS_FRAMING) {
+        sendCobs(txFrame + 1, totalLength - 1);
+        return;
+    }
+
+    for (uint16_t i = 0; i < totalLength; ++i) {
+        sendByte2PC(txFrame[i]);
+    }
+}
+
+bool trySendPacketDma(uint8_t responseCmd, const uint8_t* data, uint16_t dataLen) {
+    if (g_uartDma.isTxBusy()) {
+        return false;
     }
 
-    sendByte2PC(xorValue);
+    uint16_t totalLength = buildFrame(responseCmd, data, dataLen);
+    if (totalLength == 0) {
+        return false;
+    }
+
+    if (sessionFlags & Session::COBS_FRAMING) {
+        uint8_t encoded[UART_DMA_TX_BUFFER_SIZE];
+        uint16_t length = cobsEncode(txFrame + 1, totalLength - 1, encoded, sizeof(encoded));
+        if (length == 0) {
+            return false;
+        }
+        g_uartDma.sendPacket(encoded, length);
+        return true;
+    }
+
+    if (totalLength > UART_DMA_TX_BUFFER_SIZE) {
+        return false;
+    }
+    g_uartDma.sendPacket(txFrame, totalLength);
+    return true;
 }
 
 void sendErrorPacket(uint8_t errorCode) {
     sendPacket(Response::ERROR, &errorCode, 1);
 }
 
+void sendParamErrorPacket(uint8_t reason, uint8_t index) {
+    uint8_t data[3] = {Error::MOTOR_PARAM_ERROR, reason, index};
+    sendPacket(Response::ERROR, data, sizeof(data));
+}
+
 void sendVersionResponse() {
     uint8_t version = FIRMWARE_VERSION;
     sendPacket(Response::VERSION, &version, 1);
 }
 
-void sendStatusResponse(uint16_t activeMotors, uint16_t completedMotors, uint16_t statusPins) {
-    uint8_t data[6];
-    data[0] = static_cast<uint8_t>(activeMotors & 0xFF);
-    data[1] = static_cast<uint8_t>((activeMotors >> 8) & 0xFF);
-    data[2] = static_cast<uint8_t>(completedMotors & 0xFF);
-    data[3] = static_cast<uint8_t>((completedMotors >> 8) & 0xFF);
-    data[4] = static_cast<uint8_t>(statusPins & 0xFF);
-    data[5] = static_cast<uint8_t>((statusPins >> 8) & 0xFF);
-    sendPacket(Response::STATUS, data, 6);
+// Три маски по MOTOR_MASK_SIZE байт: для 10 моторов - прежние 6 байт
+void sendStatusResponse(MotorMask activeMotors, MotorMask completedMotors, MotorMask statusPins) {
+    uint8_t data[3 * MOTOR_MASK_SIZE];
+    uint8_t* p = data;
+    p = putMotorMask(p, activeMotors);
+    p = putMotorMask(p, completedMotors);
+    putMotorMask(p, statusPins);
+    sendPacket(Response::STATUS, data, sizeof(data));
 }
 
 void sendStopResponse(uint8_t result) {
     sendPacket(Response::STOP, &result, 1);
 }
 
+void sendSessionResponse(uint8_t flags) {
+    sendPacket(Response::SESSION, &flags, 1);
+}
+
 void sendMoveResponse(uint8_t result) {
     sendPacket(Response::MOVE, &result, 1);
 }
\ No newline at end of file
@@ -1,12 +1,25 @@
 #pragma once
 
 #include <cstdint>
+#include "constants.hpp"
 
 void initSerial();
 void sendByte2PC(uint8_t data);
 void sendPacket(uint8_t responseCmd, const uint8_t* data, uint16_t dataLen);
+
+/**
+ * @brief Отправка короткого кадра через DMA UART4 без ожидания
+ * @return false, если передатчик занят или кадр не помещается в буфер DMA
+ */
+bool trySendPacketDma(uint8_t responseCmd, const uint8_t* data, uint16_t dataLen);
 void sendErrorPacket(uint8_t errorCode);
+
+/**
+ * @brief MOTOR_PARAM_ERROR с причиной (ParamFault) и номером записи в кадре
+ */
+void sendParamErrorPacket(uint8_t reason, uint8_t index);
 void sendVersionResponse();
-void sendStatusResponse(uint16_t activeMotors, uint16_t completedMotors, uint16_t statusPins);
+void sendStatusResponse(MotorMask activeMotors, MotorMask completedMotors, MotorMask statusPins);
 void sendStopResponse(uint8_t result);
+void sendSessionResponse(uint8_t flags);
 void sendMoveResponse(uint8_t result);
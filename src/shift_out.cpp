@@ -0,0 +1,173 @@
+#include "shift_out.hpp"
+#include "board.hpp"
+#include "memory_sections.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+uint8_t ShiftOut::_image[SHIFT_OUT_BYTES] = {};
+DMA_BUFFER uint8_t ShiftOut::_tx[SHIFT_OUT_BYTES];
+volatile bool ShiftOut::_busy = false;
+volatile bool ShiftOut::_dirty = false;
+uint32_t ShiftOut::_startCycles = 0;
+uint32_t ShiftOut::_lastRefreshCycles = 0;
+uint32_t ShiftOut::_maxRefreshCycles = 0;
+
+static constexpr uint32_t STREAM5_FLAGS = DMA_HIFCR_CTCIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTEIF5 |
+                                          DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CFEIF5;
+
+void ShiftOut::init() {
+    RCC->APB1ENR |= RCC_APB1ENR_SPI3EN;
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+
+    // До первой защелки содержимое регистров случайно - выходы отключены
+    Board::ShiftOe::configureOutput();
+    Board::ShiftOe::set();
+    Board::ShiftLatch::configureOutput();
+    Board::ShiftSck::configureAlternate<6>();
+    Board::ShiftMosi::configureAlternate<6>();
+
+    // Master, программный NSS, CPOL=0 CPHA=0 (74HC595 берет бит по фронту SRCLK),
+    // MSB первым, BR=0: fPCLK/2
+    SPI3->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI;
+    SPI3->CR2 = SPI_CR2_TXDMAEN;
+    SPI3->CR1 |= SPI_CR1_SPE;
+
+    DMA1_Stream5->CR &= ~DMA_SxCR_EN;
+    while (DMA1_Stream5->CR & DMA_SxCR_EN);
+
+    DMA1_Stream5->CR = 0;  // CHSEL=0: SPI3_TX
+    DMA1_Stream5->CR |= DMA_SxCR_MINC;
+    DMA1_Stream5->CR |= DMA_SxCR_DIR_0;
+    DMA1_Stream5->CR |= DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    DMA1_Stream5->PAR = reinterpret_cast<uint32_t>(&SPI3->DR);
+
+    NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+    NVIC_SetPriority(DMA1_Stream5_IRQn, 7);
+
+    flush();  // Все линии LOW, затем /OE включит выходы
+}
+
+// Вызывается и из SysTick (MotorDriver), и из главного цикла
+void ShiftOut::write(uint16_t line, bool state) {
+    if (line >= ShiftLine::COUNT) {
+        return;
+    }
+    uint8_t bit = static_cast<uint8_t>(1U << (line % 8));
+    uint8_t index = SHIFT_OUT_BYTES - 1 - line / 8;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (state) {
+        _image[index] |= bit;
+    } else {
+        _image[index] &= ~bit;
+    }
+    __set_PRIMASK(primask);
+
+    flush();
+}
+
+bool ShiftOut::read(uint16_t line) {
+    if (line >= ShiftLine::COUNT) {
+        return false;
+    }
+    return (_image[SHIFT_OUT_BYTES - 1 - line / 8] & (1U << (line % 8))) != 0;
+}
+
+void ShiftOut::writeGroup(uint16_t first, uint8_t count, uint64_t bits) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; i < count && first + i < ShiftLine::COUNT; ++i) {
+        uint16_t line = first + i;
+        uint8_t bit = static_cast<uint8_t>(1U << (line % 8));
+        uint8_t& byte = _image[SHIFT_OUT_BYTES - 1 - line / 8];
+        if ((bits >> i) & 1U) {
+            byte |= bit;
+        } else {
+            byte &= ~bit;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    flush();
+}
+
+void ShiftOut::flush() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (_busy) {
+        _dirty = true;
+    } else {
+        startTransfer();
+    }
+    __set_PRIMASK(primask);
+
+    // В обработчике (SysTick - MotorDriver::sendCommandToDriver) ISR DMA
+    // может не вытеснить вызывающего: защелка до возврата, иначе KEY
+    // переключится уже после пакета драйверу
+    if (__get_IPSR() != 0) {
+        waitLatched();
+    }
+}
+
+// Опрос флагов потока вместо прерывания; повторная передача (_dirty) - тоже здесь
+void ShiftOut::waitLatched() {
+    while (_busy) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (DMA1->HISR & (DMA_HISR_TCIF5 | DMA_HISR_TEIF5)) {
+            handleDmaIrq();
+            NVIC_ClearPendingIRQ(DMA1_Stream5_IRQn);
+        }
+        __set_PRIMASK(primask);
+    }
+}
+
+// Прерывания запрещены или вызов из ISR DMA. Образ копируется целиком,
+// чтобы запись во время передачи не попала в нее наполовину
+void ShiftOut::startTransfer() {
+    for (uint8_t i = 0; i < SHIFT_OUT_BYTES; ++i) {
+        _tx[i] = _image[i];
+    }
+    _dirty = false;
+    _busy = true;
+    _startCycles = Profiler::cycles();
+    Trace::record(TraceEvent::SHIFT_FLUSH, SHIFT_OUT_BYTES, 0);
+
+    DMA1->HIFCR = STREAM5_FLAGS;
+    DMA1_Stream5->M0AR = reinterpret_cast<uint32_t>(_tx);
+    DMA1_Stream5->NDTR = SHIFT_OUT_BYTES;
+    DMA1_Stream5->CR |= DMA_SxCR_EN;
+}
+
+void ShiftOut::handleDmaIrq() {
+    uint32_t flags = DMA1->HISR;
+    if (!(flags & (DMA_HISR_TCIF5 | DMA_HISR_TEIF5))) {
+        return;  // Передачу уже завершил waitLatched()
+    }
+    DMA1->HIFCR = STREAM5_FLAGS;
+
+    if (flags & DMA_HISR_TCIF5) {
+        // TC - последний байт только записан в DR: ждем, пока он выдвинется
+        while (!(SPI3->SR & SPI_SR_TXE));
+        while (SPI3->SR & SPI_SR_BSY);
+
+        Board::ShiftLatch::set();  // Фронт RCLK: все выходы цепочки разом
+        Board::ShiftLatch::clear();
+        Board::ShiftOe::clear();
+
+        _lastRefreshCycles = Profiler::cycles() - _startCycles;
+        if (_lastRefreshCycles > _maxRefreshCycles) {
+            _maxRefreshCycles = _lastRefreshCycles;
+        }
+        Trace::record(TraceEvent::SHIFT_LATCH, SHIFT_OUT_BYTES, 0);
+    } else if (flags & DMA_HISR_TEIF5) {
+        _dirty = true;  // Образ не защелкнут - передать заново
+    }
+
+    _busy = false;
+    if (_dirty) {
+        startTransfer();
+    }
+}
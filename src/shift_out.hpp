@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+
+// Выходы KEY/EN/SELECT через цепочку 74HC595 вместо банков GPIO (по умолчанию выключено)
+#ifndef BOARD_SHIFT_OUT
+#define BOARD_SHIFT_OUT 0
+#endif
+
+// Раскладка линий цепочки: сначала KEY1..N, затем EN1..N, затем SELECT1..N.
+// Линия i - выход Q(i % 8) регистра i / 8, регистр 0 ближний к MCU.
+namespace ShiftLine {
+    constexpr uint16_t KEY    = 0;
+    constexpr uint16_t EN     = MAX_MOTORS;
+    constexpr uint16_t SELECT = 2 * MAX_MOTORS;
+    constexpr uint16_t COUNT  = 3 * MAX_MOTORS;
+}
+
+constexpr uint8_t SHIFT_OUT_BYTES = (ShiftLine::COUNT + 7) / 8;
+
+/**
+ * Цепочка сдвиговых регистров 74HC595 на SPI3 + DMA1 Stream5.
+ *
+ * Изменения копятся в теневом образе; flush() копирует его в буфер DMA и
+ * выдвигает целиком, а после последнего бита один фронт RCLK защелкивает
+ * все выходы сразу - группы линий переключаются атомарно. Изменения во
+ * время передачи не теряются: по окончании уходит следующий образ.
+ *
+ * SPI3 на APB1 / 2 = 8 МГц: байт регистра - 1 мкс, 64 линии (8 регистров) -
+ * около 8 мкс от flush() до фронта RCLK. Замер - участок shift_out между
+ * событиями SHIFT_FLUSH и SHIFT_LATCH в TRACE; последнее и худшее время в
+ * тактах - lastRefreshCycles()/maxRefreshCycles(), их отдает STATS.
+ * До первой защелки /OE держит выходы регистров отключенными.
+ */
+class ShiftOut {
+public:
+    static void init();
+
+    static void write(uint16_t line, bool state);
+    static bool read(uint16_t line);
+
+    // Группа count линий с first одним значением маски (бит 0 - линия first)
+    static void writeGroup(uint16_t first, uint8_t count, uint64_t bits);
+
+    // Запустить передачу образа; если DMA занят - образ уйдет следом.
+    // Из обработчика прерывания возвращается после фронта RCLK
+    static void flush();
+
+    static bool isLatched() { return !_busy && !_dirty; }
+    static uint32_t lastRefreshCycles() { return _lastRefreshCycles; }
+    static uint32_t maxRefreshCycles() { return _maxRefreshCycles; }
+
+    static void handleDmaIrq();
+
+private:
+    static void startTransfer();
+    static void waitLatched();
+
+    static uint8_t _image[SHIFT_OUT_BYTES];  // Байт 0 - дальний регистр, как в порядке выдвигания
+    static uint8_t _tx[SHIFT_OUT_BYTES];
+    static volatile bool _busy;
+    static volatile bool _dirty;
+    static uint32_t _startCycles;
+    static uint32_t _lastRefreshCycles;
+    static uint32_t _maxRefreshCycles;
+};
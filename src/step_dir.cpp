@@ -0,0 +1,304 @@
+#include "step_dir.hpp"
+#include "board.hpp"
+#include "memory_sections.hpp"
+#include "profiler.hpp"
+#include "log.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+CCMRAM_BSS StepDir::Channel StepDir::_channels[STEP_DIR_CHANNELS];
+DMA_BUFFER uint32_t StepDir::_periods[STEP_DIR_CHANNELS][2 * STEP_DMA_BLOCK];
+uint32_t StepDir::_maxRefillCycles = 0;
+uint32_t StepDir::_underruns = 0;
+
+static constexpr uint8_t CHANNEL_COUNT = maskBits(BOARD_STEP_DIR);
+static constexpr uint16_t RING_SIZE = 2 * STEP_DMA_BLOCK;
+static constexpr uint32_t MAX_ARR = 0xFFFF;  // TIM1 16-битный, у TIM2 используем столько же
+// Крейсерский период не короче - такт дрожания остается долей процента периода
+static constexpr uint32_t CRUISE_TICKS = 4096;
+
+// DMA burst пишет с регистра ARR (смещение 0x2C), одно слово на обновление
+static constexpr uint32_t BURST_BASE = 0x2C / 4;
+
+// Поток 1 в LISR и поток 5 в HISR - одни и те же биты 6-11
+static_assert(DMA_HISR_TCIF5 == DMA_LISR_TCIF1 && DMA_HISR_HTIF5 == DMA_LISR_HTIF1, "Stream flag layout");
+static constexpr uint32_t STREAM_FLAGS = DMA_LISR_TCIF1 | DMA_LISR_HTIF1 | DMA_LISR_TEIF1 |
+                                         DMA_LISR_DMEIF1 | DMA_LISR_FEIF1;
+
+struct ChannelHw {
+    TIM_TypeDef* tim;
+    DMA_Stream_TypeDef* stream;
+    volatile uint32_t* isr;
+    volatile uint32_t* ifcr;
+    uint32_t request;
+    IRQn_Type irq;
+};
+
+// Канал 0: TIM1_UP - DMA2 Stream5 Channel 6; канал 1: TIM2_UP - DMA1 Stream1 Channel 3
+static ChannelHw channelHw(uint8_t channel) {
+    if (channel == 0) {
+        return {TIM1, DMA2_Stream5, &DMA2->HISR, &DMA2->HIFCR, 6U << DMA_SxCR_CHSEL_Pos, DMA2_Stream5_IRQn};
+    }
+    return {TIM2, DMA1_Stream1, &DMA1->LISR, &DMA1->LIFCR, 3U << DMA_SxCR_CHSEL_Pos, DMA1_Stream1_IRQn};
+}
+
+void StepDir::init() {
+    RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN | RCC_AHB1ENR_DMA2EN;
+
+    Board::StepDirection::configureOutput();
+    Board::StepPulse0::configureAlternate<1>();
+    if (CHANNEL_COUNT > 1) {
+        Board::StepPulse1::configureAlternate<1>();
+    }
+
+    MotorMask motors = STEP_DIR_MOTORS;
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ++ch) {
+        _channels[ch].motorNum = lowestMotorIndex(motors) + 1;
+        _channels[ch].running = false;
+        _channels[ch].velocity = 0;
+        motors &= motors - 1;
+
+        ChannelHw hw = channelHw(ch);
+        TIM_TypeDef* tim = hw.tim;
+        tim->CR1 = TIM_CR1_ARPE;
+        tim->PSC = 0;
+        tim->ARR = 0;
+        // PWM mode 2: LOW, пока CNT < CCR1; с ARR = 0 выход стоит в LOW
+        tim->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1M_0 | TIM_CCMR1_OC1PE;
+        tim->CCR1 = STEP_PULSE_TICKS;
+        tim->CCER = TIM_CCER_CC1E;
+        if (tim == TIM1) {
+            tim->BDTR = TIM_BDTR_MOE;  // Выходы расширенного таймера
+        }
+        tim->DCR = BURST_BASE << TIM_DCR_DBA_Pos;  // DBL = 0: одна передача
+        tim->EGR = TIM_EGR_UG;
+        tim->SR = 0;
+
+        DMA_Stream_TypeDef* stream = hw.stream;
+        stream->CR &= ~DMA_SxCR_EN;
+        while (stream->CR & DMA_SxCR_EN);
+        stream->CR = hw.request | DMA_SxCR_PL_1 | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 |
+                     DMA_SxCR_MINC | DMA_SxCR_CIRC | DMA_SxCR_DIR_0 |
+                     DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+        stream->PAR = reinterpret_cast<uint32_t>(&tim->DMAR);
+        stream->M0AR = reinterpret_cast<uint32_t>(_periods[ch]);
+
+        // Выше UART и SysTick (приоритет 8, см. SysTick_Init): половина кольца
+        // на 100 кГц - 0.64 мс, а SysTick ждет пакет драйверу 2-3 мс.
+        // Опоздание с половиной кольца - лишние шаги
+        NVIC_SetPriority(hw.irq, 2);
+        NVIC_EnableIRQ(hw.irq);
+    }
+}
+
+// Делитель таймера (PSC + 1): 1 для быстрых осей. Медленной оси с малым
+// ускорением он растягивает такт, чтобы первый период разгона влез в 16 бит
+// и старт не прыгал сразу на 244 шаг/с; крейсерский период при этом не
+// короче CRUISE_TICKS
+static uint32_t timerDivider(uint32_t acceleration, uint32_t speed) {
+    uint64_t clock = SystemCoreClock;
+    uint64_t span = static_cast<uint64_t>(MAX_ARR) * speed;
+    uint64_t minimum = (clock + span - 1) / span;
+    uint64_t first = ((StepRamp::firstPeriod(acceleration, SystemCoreClock) >> 15) + MAX_ARR - 1) / MAX_ARR;
+    uint64_t cruise = clock / (static_cast<uint64_t>(speed) * CRUISE_TICKS);
+    uint64_t divider = first < cruise ? first : cruise;
+    if (divider < minimum) {
+        divider = minimum;
+    }
+    return divider != 0 ? static_cast<uint32_t>(divider) : 1;
+}
+
+uint8_t StepDir::channelOf(uint8_t motorNum) {
+    MotorMask below = STEP_DIR_MOTORS & static_cast<MotorMask>(motorBit(motorNum - 1) - 1);
+    return static_cast<uint8_t>(__builtin_popcountll(below));
+}
+
+// Из SysTick (MotorDriver::processNextMotor)
+void StepDir::start(const MotorSettings& settings) {
+    uint8_t motorNum = static_cast<uint8_t>(settings.getNumber());
+    uint8_t ch = channelOf(motorNum);
+    Channel& channel = _channels[ch];
+    stopChannel(ch);
+
+    int32_t steps = static_cast<int32_t>(settings.getSteps());
+    uint32_t count = steps < 0 ? 0U - static_cast<uint32_t>(steps) : static_cast<uint32_t>(steps);
+    if (steps < 0) {
+        Board::StepDirection::set(1U << ch);
+    } else {
+        Board::StepDirection::clear(1U << ch);
+    }
+    if (count == 0) {
+        return;
+    }
+
+    uint32_t speed = settings.getMaxSpeed();
+    if (speed > STEP_MAX_RATE_HZ) {
+        speed = STEP_MAX_RATE_HZ;
+    }
+    uint32_t divider = timerDivider(settings.getAcceleration(), speed);
+    channel.ramp.start(count, settings.getAcceleration(), speed, SystemCoreClock / divider);
+
+    uint32_t first[2] = {0, 0};
+    uint16_t head = channel.ramp.fill(first, 2);
+    refill(ch, 0);
+    refill(ch, STEP_DMA_BLOCK);
+    channel.stopIndex = static_cast<uint16_t>(count % RING_SIZE);
+    channel.running = true;
+
+    // Первые два периода - в ARR напрямую (активный и предзагрузка), кольцо
+    // начинается с третьего: DMA пишет период шага k + 2 в конце шага k
+    ChannelHw hw = channelHw(ch);
+    TIM_TypeDef* tim = hw.tim;
+    tim->PSC = divider - 1;
+    tim->ARR = first[0] - 1;
+    tim->CNT = 0;
+    tim->EGR = TIM_EGR_UG;
+    tim->SR = 0;
+    tim->ARR = head > 1 ? first[1] - 1 : 0;
+
+    *hw.ifcr = STREAM_FLAGS;
+    hw.stream->NDTR = RING_SIZE;
+    hw.stream->CR |= DMA_SxCR_EN;
+    tim->DIER = TIM_DIER_UDE;
+    tim->CR1 |= TIM_CR1_CEN;  // DIR выставлен за STEP_PULSE_TICKS до первого фронта
+}
+
+// Половина кольца с first: следующие периоды как ARR, после последнего шага - маркеры 0
+void StepDir::refill(uint8_t channel, uint16_t first) {
+    uint32_t* periods = _periods[channel] + first;
+    uint16_t count = _channels[channel].ramp.fill(periods, STEP_DMA_BLOCK);
+    for (uint16_t i = 0; i < count; ++i) {
+        periods[i] -= 1;
+    }
+    for (uint16_t i = count; i < STEP_DMA_BLOCK; ++i) {
+        periods[i] = 0;
+    }
+}
+
+// HT - DMA читает вторую половину, первую можно дописать; TC - наоборот
+void StepDir::handleDmaIrq(uint8_t channel) {
+    uint32_t start = Profiler::cycles();
+    ChannelHw hw = channelHw(channel);
+    uint32_t flags = *hw.isr & STREAM_FLAGS;
+    *hw.ifcr = flags;
+    if (!_channels[channel].running) {
+        return;
+    }
+
+    if (flags & DMA_LISR_TEIF1) {
+        LOG("stepdir %u: DMA error", _channels[channel].motorNum);
+        stopChannel(channel);
+        return;
+    }
+    // Обе половины прочитаны до прерывания: DMA уже повторял старые периоды
+    if ((flags & DMA_LISR_HTIF1) && (flags & DMA_LISR_TCIF1)) {
+        _underruns++;
+    }
+    if (flags & DMA_LISR_HTIF1) {
+        refill(channel, 0);
+    }
+    if (flags & DMA_LISR_TCIF1) {
+        refill(channel, STEP_DMA_BLOCK);
+    }
+
+    uint32_t cycles = Profiler::cycles() - start;
+    if (cycles > _maxRefillCycles) {
+        _maxRefillCycles = cycles;
+    }
+}
+
+void StepDir::poll() {
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ++ch) {
+        Channel& channel = _channels[ch];
+        if (!channel.running) {
+            continue;
+        }
+        // ARR = 0 только на последнем шаге или после него; передачи после
+        // конца последнего шага - ровно stopIndex
+        ChannelHw hw = channelHw(ch);
+        uint16_t position = static_cast<uint16_t>((RING_SIZE - hw.stream->NDTR) % RING_SIZE);
+        if (hw.tim->ARR == 0 && position == channel.stopIndex) {
+            stopChannel(ch);
+            LOG("stepdir %u done, refill max %u cycles, underruns %u",
+                channel.motorNum, _maxRefillCycles, _underruns);
+        }
+    }
+}
+
+void StepDir::stopAll() {
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ++ch) {
+        stopChannel(ch);
+    }
+}
+
+// Без торможения: импульсы обрываются сразу, выход STEP в LOW
+void StepDir::stopChannel(uint8_t channel) {
+    ChannelHw hw = channelHw(channel);
+    hw.tim->CR1 &= ~TIM_CR1_CEN;
+    hw.tim->DIER = 0;
+    hw.stream->CR &= ~DMA_SxCR_EN;
+    while (hw.stream->CR & DMA_SxCR_EN);
+    *hw.ifcr = STREAM_FLAGS;
+
+    hw.tim->ARR = 0;
+    hw.tim->EGR = TIM_EGR_UG;
+    hw.tim->SR = 0;
+    _channels[channel].running = false;
+    _channels[channel].velocity = 0;
+}
+
+// Из SysTick (VelocityStream::tick)
+void StepDir::setVelocity(uint8_t channel, int32_t velocity) {
+    Channel& state = _channels[channel];
+    bool reverse = velocity < 0;
+    if (velocity == 0 || (state.velocity != 0 && reverse != (state.velocity < 0)) ||
+        (state.running && state.velocity == 0)) {
+        stopChannel(channel);  // Сброс и движения по шагам, если оно еще шло
+    }
+    if (velocity == 0) {
+        return;
+    }
+
+    uint32_t speed = reverse ? 0U - static_cast<uint32_t>(velocity) : static_cast<uint32_t>(velocity);
+    uint64_t span = static_cast<uint64_t>(MAX_ARR) * speed;
+    uint32_t divider = static_cast<uint32_t>((SystemCoreClock + span - 1) / span);
+    uint32_t clock = SystemCoreClock / divider;
+    uint32_t period = (clock + speed / 2) / speed;
+
+    ChannelHw hw = channelHw(channel);
+    TIM_TypeDef* tim = hw.tim;
+    if (state.running) {
+        // UDIS: обновление между записями PSC и ARR дало бы период из старого и нового
+        tim->CR1 |= TIM_CR1_UDIS;
+        tim->PSC = divider - 1;
+        tim->ARR = period - 1;
+        tim->CR1 &= ~TIM_CR1_UDIS;
+        state.velocity = velocity;
+        return;
+    }
+
+    if (reverse) {
+        Board::StepDirection::set(1U << channel);
+    } else {
+        Board::StepDirection::clear(1U << channel);
+    }
+    tim->PSC = divider - 1;
+    tim->ARR = period - 1;
+    tim->CNT = 0;
+    tim->EGR = TIM_EGR_UG;
+    tim->SR = 0;
+    state.velocity = velocity;
+    state.running = true;
+    tim->CR1 |= TIM_CR1_CEN;  // Первый фронт через STEP_PULSE_TICKS после смены DIR
+}
+
+MotorMask StepDir::movingMotors() {
+    MotorMask moving = 0;
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ++ch) {
+        if (_channels[ch].running) {
+            moving |= motorBit(_channels[ch].motorNum - 1);
+        }
+    }
+    return moving;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+#include "motor_settings.hpp"
+#include "step_ramp.hpp"
+
+// Моторы на простых STEP/DIR-драйверах вместо пакета 0x78 (по умолчанию нет):
+// -DBOARD_STEP_DIR=0x300 - моторы 9 и 10. Каналы занимаются по возрастанию номера.
+#ifndef BOARD_STEP_DIR
+#define BOARD_STEP_DIR 0
+#endif
+
+constexpr MotorMask STEP_DIR_MOTORS = static_cast<MotorMask>(BOARD_STEP_DIR);
+// TIM1 + DMA2 Stream5 и TIM2 + DMA1 Stream1, см. board.hpp
+constexpr uint8_t STEP_DIR_CHANNELS = 2;
+// Периодов на половину кольца DMA: столько шагов вперед считает одно прерывание
+constexpr uint16_t STEP_DMA_BLOCK = 64;
+// Предел скорости: при 16 МГц период не короче 80 тактов
+constexpr uint32_t STEP_MAX_RATE_HZ = 200000;
+// STEP в LOW после начала периода, 2 мкс; шаг - фронт в HIGH
+constexpr uint16_t STEP_PULSE_TICKS = 32;
+
+constexpr uint8_t maskBits(uint64_t mask) {
+    return mask == 0 ? 0 : static_cast<uint8_t>((mask & 1U) + maskBits(mask >> 1));
+}
+
+static_assert((static_cast<uint64_t>(BOARD_STEP_DIR) & ~static_cast<uint64_t>(ALL_MOTORS_MASK)) == 0,
+              "BOARD_STEP_DIR has bits above MAX_MOTORS");
+static_assert(maskBits(BOARD_STEP_DIR) <= STEP_DIR_CHANNELS, "BOARD_STEP_DIR exceeds STEP/DIR timer channels");
+
+/**
+ * Генератор STEP/DIR на таймерах: импульсы без прерывания на шаг.
+ *
+ * Канал - таймер в PWM mode 2 (выход LOW до CCR1 = STEP_PULSE_TICKS, затем
+ * HIGH до конца периода) и поток DMA по событию обновления. DMA burst через
+ * TIMx_DMAR пишет в предзагрузку ARR период следующего шага, так что фронт
+ * каждого шага ставит таймер, а ядро только досчитывает кольцо периодов:
+ * прерывание на половину кольца (STEP_DMA_BLOCK шагов), а не на шаг.
+ *
+ * Периоды считает StepRamp из тех же accel/maxSpeed/steps, что приходят в
+ * MotorSettings; знак шагов - уровень DIR. Фронт шага не дальше такта
+ * таймера (62.5 нс) от расписания, а на крейсерской скорости период
+ * отличается от идеального меньше чем на такт. Оценка на хосте -
+ * scripts/squid/step_ramp.py.
+ *
+ * Конец движения - период 0 (ARR = 0): счетчик встает с выходом в LOW.
+ * DMA делает одну передачу на обновление, поэтому канал свободен, когда
+ * передач столько же, сколько шагов, а в ARR уже маркер. MotorDriver
+ * видит занятость канала вместо линии STATUS.
+ */
+class StepDir {
+public:
+    static void init();
+
+    static constexpr bool owns(uint8_t motorNum) {
+        return motorNum >= 1 && motorNum <= MAX_MOTORS && (STEP_DIR_MOTORS & motorBit(motorNum - 1)) != 0;
+    }
+
+    // Мотор уже проверен MotorSettings::fault(); скорость выше STEP_MAX_RATE_HZ урезается
+    static void start(const MotorSettings& settings);
+    static void stopAll();
+
+    // Моторы, у которых еще идут импульсы (аналог STATUS HIGH)
+    static MotorMask movingMotors();
+
+    // Из SysTick: канал, отдавший последний шаг, останавливается
+    static void poll();
+
+    static void handleDmaIrq(uint8_t channel);
+
+    /**
+     * @brief Режим скорости (VelocityStream): ровные импульсы без DMA и счета шагов
+     * @param velocity Шаг/с со знаком, 0 - остановить; знак меняется только через 0
+     *
+     * Новые PSC и ARR уходят в предзагрузку и действуют со следующего шага:
+     * период не рвется, смена скорости - без лишнего или пропущенного шага.
+     */
+    static void setVelocity(uint8_t channel, int32_t velocity);
+
+    // Канал мотора, владение проверено owns()
+    static uint8_t channelOf(uint8_t motorNum);
+    static uint8_t motorOf(uint8_t channel) { return _channels[channel].motorNum; }
+
+    static uint32_t maxRefillCycles() { return _maxRefillCycles; }
+    static uint32_t underruns() { return _underruns; }
+
+private:
+    struct Channel {
+        StepRamp ramp;
+        uint8_t motorNum;
+        volatile bool running;
+        uint16_t stopIndex;        // Позиция DMA после последнего шага
+        int32_t velocity;          // Режим скорости, 0 - движение по шагам или стоит
+    };
+
+    static void refill(uint8_t channel, uint16_t first);
+    static void stopChannel(uint8_t channel);
+
+    static Channel _channels[STEP_DIR_CHANNELS];
+    static uint32_t _periods[STEP_DIR_CHANNELS][2 * STEP_DMA_BLOCK];
+    static uint32_t _maxRefillCycles;
+    static uint32_t _underruns;
+};
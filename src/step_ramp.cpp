@@ -0,0 +1,92 @@
+#include "step_ramp.hpp"
+#include "linear_planner.hpp"
+
+static constexpr uint8_t FRACTION_BITS = 15;
+// 0.676 << 15: поправка AVR446 для первого шага
+static constexpr uint32_t FIRST_STEP_FACTOR = 22151;
+static constexpr uint32_t MAX_PERIOD = 0xFFFF;
+// Период 0xFFFF тактов; 2 * _c + остаток помещается в uint32
+static constexpr uint32_t MAX_C = MAX_PERIOD << FRACTION_BITS;
+
+uint64_t StepRamp::firstPeriod(uint32_t acceleration, uint32_t timerHz) {
+    uint64_t f = timerHz;
+    return static_cast<uint64_t>(LinearPlanner::isqrt(2 * f * f / acceleration)) * FIRST_STEP_FACTOR;
+}
+
+void StepRamp::start(uint32_t steps, uint32_t acceleration, uint32_t maxSpeed, uint32_t timerHz) {
+    _steps = steps;
+    _step = 0;
+    _rest = 0;
+    _fraction = 0;
+
+    uint64_t f = timerHz;
+    uint64_t cMin = (f << FRACTION_BITS) / maxSpeed;
+    _cMin = cMin > MAX_C ? MAX_C : static_cast<uint32_t>(cMin);
+
+    uint64_t c0 = firstPeriod(acceleration, timerHz);
+    if (c0 <= MAX_C) {
+        _n0 = 0;
+        _c = static_cast<uint32_t>(c0);
+    } else {
+        // Первый индекс с c_n = f / sqrt(a (2n + 1)) <= MAX_PERIOD; сюда попадает только a < ~60 при 16 МГц
+        uint64_t d = static_cast<uint64_t>(acceleration) * MAX_PERIOD * MAX_PERIOD;
+        uint64_t q = (f * f + d - 1) / d;
+        _n0 = q >= 2 ? static_cast<uint32_t>(q / 2) : 1;
+        uint64_t root = LinearPlanner::isqrt((static_cast<uint64_t>(acceleration) * (2 * _n0 + 1)) << 16);  // << 8
+        uint64_t c = (f << (FRACTION_BITS + 8)) / root;
+        _c = c > MAX_C ? MAX_C : static_cast<uint32_t>(c);
+    }
+    _n = _n0;
+
+    // Разгон до c <= _cMin, но не дальше середины; конец торможения
+    // уточняется, когда разгон закончился
+    _accelerating = _c > _cMin;
+    _decelStart = _accelerating ? steps - steps / 2 : steps;
+}
+
+uint16_t StepRamp::fill(uint32_t* periods, uint16_t count) {
+    uint16_t i = 0;
+    for (; i < count && _step < _steps; ++i) {
+        // Дробная часть такта переносится в следующий шаг: фронт отстает
+        // от расписания c_n меньше чем на такт, средняя частота точная
+        uint32_t c = (_c > _cMin ? _c : _cMin) + _fraction;
+        uint32_t ticks = c >> FRACTION_BITS;
+        _fraction = c & ((1U << FRACTION_BITS) - 1);
+        if (ticks > MAX_PERIOD) {
+            ticks = MAX_PERIOD;
+            _fraction = 0;
+        }
+        periods[i] = ticks != 0 ? ticks : 1;
+        _step++;
+
+        // Период следующего шага: торможение идет по индексам разгона обратно
+        if (_step >= _decelStart) {
+            if (_step == _decelStart) {
+                _rest = 0;
+            }
+            uint32_t target = _n0 + (_steps - 1 - _step);
+            if (_step < _steps && _n > target) {
+                uint32_t num = 2 * _c + _rest;
+                uint32_t div = 4 * _n - 1;
+                _c += num / div;
+                _rest = num % div;
+                _n--;
+                if (_c > MAX_C) {
+                    _c = MAX_C;
+                }
+            }
+        } else if (_accelerating) {
+            _n++;
+            uint32_t num = 2 * _c + _rest;
+            uint32_t div = 4 * _n + 1;
+            _c -= num / div;
+            _rest = num % div;
+            if (_c <= _cMin) {
+                // Торможение - столько же шагов, сколько занял разгон
+                _accelerating = false;
+                _decelStart = _steps - (_n - _n0);
+            }
+        }
+    }
+    return i;
+}
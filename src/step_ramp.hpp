@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Периоды шагов трапеции в тактах таймера, без обращения к железу.
+ *
+ * Поля - те же accel/maxSpeed/steps, что в MotorSettings. Рекуррента
+ * AVR446 (D. Austin): c_n = c_{n-1} - 2 c_{n-1} / (4n + 1) на разгоне и
+ * обратная c_{n-1} = c_n + 2 c_n / (4n - 1) на торможении - одно целое
+ * деление на шаг, без корня и без float. Остаток деления переносится в
+ * следующий шаг, поэтому длинный разгон (n ~ 10^6) не застревает на
+ * округлении. c - такты с 15 дробными битами; дробь такта переносится
+ * в следующий период, поэтому фронт шага не дальше такта от расписания.
+ *
+ * Период ограничен 0xFFFF тактов (16-битный ARR; на 16 МГц - 244 шаг/с).
+ * Если первый шаг c_0 = 0.676 * f * sqrt(2 / a) длиннее, разгон начинается
+ * с индекса n0, где c_n0 = f / sqrt(a (2 n0 + 1)) укладывается в предел: скорость
+ * старта ~244 шаг/с, дальше ускорение точное. Разгон идет, пока c_n не
+ * дойдет до периода maxSpeed (или до середины пути), торможение - по тем же
+ * индексам обратно до n0.
+ */
+class StepRamp {
+public:
+    void start(uint32_t steps, uint32_t acceleration, uint32_t maxSpeed, uint32_t timerHz);
+
+    /**
+     * @brief Следующие периоды (такты таймера)
+     * @return Сколько записано; меньше count - шаги кончились
+     */
+    uint16_t fill(uint32_t* periods, uint16_t count);
+
+    bool done() const { return _step >= _steps; }
+
+    // c_0 без ограничения 0xFFFF, такты << 15
+    static uint64_t firstPeriod(uint32_t acceleration, uint32_t timerHz);
+
+private:
+    uint32_t _steps = 0;
+    uint32_t _step = 0;        // Шагов уже выдано
+    uint32_t _decelStart = 0;  // Первый шаг торможения
+    uint32_t _n0 = 0;          // Индекс рекурренты первого шага
+    uint32_t _n = 0;           // Индекс рекурренты для _c
+    uint32_t _c = 0;           // Период c_n, такты << 15
+    uint32_t _rest = 0;        // Остаток деления рекурренты
+    uint32_t _fraction = 0;    // Дробь такта, не выданная в периоды
+    uint32_t _cMin = 0;        // Период крейсерской скорости, такты << 15
+    bool _accelerating = false;
+};
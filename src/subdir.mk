@@ -10,7 +10,26 @@ e_SRCS += \
 ./src/serial.cpp \
 ./src/constants.cpp \
 ./src/protocol.cpp \
-./src/uart_dma.cpp
+./src/uart_dma.cpp \
+./src/crc32.cpp \
+./src/memory_stats.cpp \
+./src/boot_info.cpp \
+./src/led_task.cpp \
+./src/profiler.cpp \
+./src/pc_sampler.cpp \
+./src/trace.cpp \
+./src/log.cpp \
+./src/link_stats.cpp \
+./src/telemetry.cpp \
+./src/event_wait.cpp \
+./src/shift_out.cpp \
+./src/sequencer.cpp \
+./src/motion_profiles.cpp \
+./src/linear_planner.cpp \
+./src/segment_planner.cpp \
+./src/step_ramp.cpp \
+./src/step_dir.cpp \
+./src/velocity_stream.cpp
 
 C_DEPS += \
 ./src/main.d \
@@ -24,7 +43,26 @@ C_DEPS += \
 ./src/serial.d \
 ./src/constants.d \
 ./src/protocol.d \
-./src/uart_dma.d
+./src/uart_dma.d \
+./src/crc32.d \
+./src/memory_stats.d \
+./src/boot_info.d \
+./src/led_task.d \
+./src/profiler.d \
+./src/pc_sampler.d \
+./src/trace.d \
+./src/log.d \
+./src/link_stats.d \
+./src/telemetry.d \
+./src/event_wait.d \
+./src/shift_out.d \
+./src/sequencer.d \
+./src/motion_profiles.d \
+./src/linear_planner.d \
+./src/segment_planner.d \
+./src/step_ramp.d \
+./src/step_dir.d \
+./src/velocity_stream.d
 
 OBJS += \
 ./src/main.o \
@@ -38,12 +76,31 @@ OBJS += \
 ./src/serial.o \
 ./src/constants.o \
 ./src/protocol.o \
-./src/uart_dma.o
+./src/uart_dma.o \
+./src/crc32.o \
+./src/memory_stats.o \
+./src/boot_info.o \
+./src/led_task.o \
+./src/profiler.o \
+./src/pc_sampler.o \
+./src/trace.o \
+./src/log.o \
+./src/link_stats.o \
+./src/telemetry.o \
+./src/event_wait.o \
+./src/shift_out.o \
+./src/sequencer.o \
+./src/motion_profiles.o \
+./src/linear_planner.o \
+./src/segment_planner.o \
+./src/step_ramp.o \
+./src/step_dir.o \
+./src/velocity_stream.o
 
 
 src/%.o: ./src/%.cpp src/subdir.mk
 	@echo 'Building file: $<'
 	@echo 'Invoking: GNU Arm Cross C Compiler'
-	arm-none-eabi-g++ -mcpu=cortex-m4 -mthumb -mfloat-abi=soft -O0 -fmessage-length=0 -fsigned-char -ffunction-sections -fdata-sections -ffreestanding -fno-move-loop-invariants -g3 -DDEBUG -DUSE_FULL_ASSERT -DTRACE -DOS_USE_TRACE_SEMIHOSTING_STDOUT -DSTM32F407xx -DUSE_HAL_DRIVER -DHSE_VALUE=8000000 -I"../include" -I"../system/include" -I"../system/include/cmsis" -I"../system/include/stm32f4-hal" -std=c++11 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" -c -o "$@" "$<"
+	arm-none-eabi-g++ -mcpu=cortex-m4 -mthumb -mfloat-abi=soft -O0 -fmessage-length=0 -fsigned-char -ffunction-sections -fdata-sections -ffreestanding -fno-move-loop-invariants -g3 -DDEBUG -DUSE_FULL_ASSERT -DTRACE -DOS_USE_TRACE_RAM_RING -DSTM32F407xx -DUSE_HAL_DRIVER -DHSE_VALUE=8000000 -I"../include" -I"../system/include" -I"../system/include/cmsis" -I"../system/include/stm32f4-hal" -std=c++11 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" -c -o "$@" "$<"
 	@echo 'Finished building: $<'
 	@echo ' '
@@ -0,0 +1,86 @@
+#include "telemetry.hpp"
+#include "motor_driver.hpp"
+#include "serial.hpp"
+#include "protocol.hpp"
+#include "uart_dma.hpp"
+#include "board.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+// Самый длинный вариант: CRC-32 и COBS (+1 байт кода, +1 разделитель)
+static_assert(PROTOCOL_HEADER_SIZE - 1 + TELEMETRY_DATA_SIZE + PROTOCOL_CRC_SIZE + 2 <= UART_DMA_TX_BUFFER_SIZE,
+              "Telemetry frame must fit the UART4 DMA TX buffer");
+
+uint16_t Telemetry::_periodMs = 0;
+uint8_t Telemetry::_flags = 0;
+uint32_t Telemetry::_lastPeriod = 0;
+bool Telemetry::_due = false;
+uint16_t Telemetry::_sequence = 0;
+uint16_t Telemetry::_dropped = 0;
+MotorMask Telemetry::_lastActive = 0;
+MotorMask Telemetry::_lastCompleted = 0;
+MotorMask Telemetry::_lastPins = 0;
+
+uint16_t Telemetry::configure(uint16_t periodMs, uint8_t flags, uint32_t now) {
+    if (periodMs != 0 && periodMs < TELEMETRY_MIN_PERIOD_MS) {
+        periodMs = TELEMETRY_MIN_PERIOD_MS;
+    }
+
+    _periodMs = periodMs;
+    _flags = flags & TelemetryFlag::SUPPORTED;
+    _lastPeriod = now;
+    _due = isEnabled();  // Первый кадр - сразу, с текущим состоянием
+    _sequence = 0;
+    _dropped = 0;
+    return _periodMs;
+}
+
+void Telemetry::poll(uint32_t now, bool linkBusy) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    if (_periodMs != 0 && now - _lastPeriod >= _periodMs) {
+        _lastPeriod = now;
+        if (_due) {
+            _dropped++;
+        }
+        _due = true;
+    }
+
+    if (_flags & TelemetryFlag::ON_CHANGE) {
+        MotorMask pins = static_cast<MotorMask>(Board::Status::read());
+        if (g_motorDriver.getActiveMotors() != _lastActive ||
+            g_motorDriver.getCompletedMotors() != _lastCompleted || pins != _lastPins) {
+            _due = true;
+        }
+    }
+
+    if (!_due || linkBusy) {
+        return;
+    }
+
+    uint8_t data[TELEMETRY_DATA_SIZE];
+    uint8_t len = serialize(data, now);
+    if (trySendPacketDma(Response::TELEMETRY, data, len)) {
+        _due = false;
+        _sequence++;
+    }
+}
+
+uint8_t Telemetry::serialize(uint8_t* out, uint32_t now) {
+    _lastActive = g_motorDriver.getActiveMotors();
+    _lastCompleted = g_motorDriver.getCompletedMotors();
+    _lastPins = static_cast<MotorMask>(Board::Status::read());
+
+    uint8_t* p = out;
+    p = putLe16(p, _sequence);
+    p = putLe32(p, now);
+    p = putMotorMask(p, _lastActive);
+    p = putMotorMask(p, _lastCompleted);
+    p = putMotorMask(p, _lastPins);
+    p = putLe16(p, _dropped);
+    for (uint8_t i = 0; i < MAX_MOTORS; ++i) {
+        p = putLe16(p, g_motorDriver.getElapsedMs(i, now));
+    }
+    return static_cast<uint8_t>(p - out);
+}
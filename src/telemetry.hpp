@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+
+// Флаги SUBSCRIBE
+namespace TelemetryFlag {
+    constexpr uint8_t ON_CHANGE = 0x01;  // Кадр сразу при смене масок или STATUS
+    constexpr uint8_t SUPPORTED = ON_CHANGE;
+}
+
+// Период короче времени кадра на 115200 (~4 мс) забил бы линию
+constexpr uint16_t TELEMETRY_MIN_PERIOD_MS = 10;
+
+// seq u16, ticks u32, маски active, completed, pins (по MOTOR_MASK_SIZE байт),
+// dropped u16, elapsed u16 * MAX_MOTORS
+constexpr uint8_t TELEMETRY_DATA_SIZE = 8 + 3 * MOTOR_MASK_SIZE + 2 * MAX_MOTORS;
+
+/**
+ * Потоковая телеметрия (SUBSCRIBE): MCU сам шлет кадры Response::TELEMETRY
+ * с периодом и/или при изменении состояния моторов.
+ *
+ * Кадр уходит через DMA UART4 только когда линия свободна: кадр команды
+ * не принимается и не ждет обработки, прошлый кадр DMA уже передан.
+ * Если кадр не успел уйти до следующего периода, он считается
+ * пропущенным (dropped) - ответ на команду телеметрию всегда опережает.
+ */
+class Telemetry {
+public:
+    /**
+     * @brief Настроить подписку
+     * @param periodMs Период, 0 - без периодических кадров
+     * @param flags TelemetryFlag::*
+     * @return Принятый период (не короче TELEMETRY_MIN_PERIOD_MS)
+     */
+    static uint16_t configure(uint16_t periodMs, uint8_t flags, uint32_t now);
+
+    /**
+     * @brief Вызывается из главного цикла
+     * @param linkBusy Идет прием или обработка команды
+     */
+    static void poll(uint32_t now, bool linkBusy);
+
+    static bool isEnabled() { return _periodMs != 0 || (_flags & TelemetryFlag::ON_CHANGE); }
+
+private:
+    static uint8_t serialize(uint8_t* out, uint32_t now);
+
+    static uint16_t _periodMs;
+    static uint8_t _flags;
+    static uint32_t _lastPeriod;
+    static bool _due;
+    static uint16_t _sequence;
+    static uint16_t _dropped;
+    static MotorMask _lastActive;
+    static MotorMask _lastCompleted;
+    static MotorMask _lastPins;
+};
@@ -0,0 +1,113 @@
+#include "trace.hpp"
+#include "constants.hpp"
+#include "protocol.hpp"
+#include "profiler.hpp"
+#include "uart_dma.hpp"
+#include "memory_sections.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+CCMRAM_BSS Trace::Record Trace::_ring[TRACE_RING_SIZE];
+uint32_t Trace::_head = 0;
+uint32_t Trace::_tail = 0;
+uint32_t Trace::_dropped = 0;
+uint16_t Trace::_nextTxn = 0;
+uint16_t Trace::_activeTxn = 0;
+uint32_t Trace::_frameStartCycles = 0;
+uint32_t Trace::_frameCompleteCycles = 0;
+uint8_t Trace::_frameCommand = 0;
+
+// Заголовок ответа READ: clock u32, dropped u16, count u8
+constexpr uint16_t TRACE_HEADER_SIZE = 7;
+
+void Trace::frameStart(uint16_t backlogBytes) {
+    // 10 бит на байт (старт + 8 + стоп)
+    uint32_t cyclesPerByte = SystemCoreClock / (UART_DMA_BAUDRATE / 10);
+    _frameStartCycles = Profiler::cycles() - backlogBytes * cyclesPerByte;
+}
+
+void Trace::frameComplete() {
+    _frameCompleteCycles = Profiler::cycles();
+}
+
+void Trace::dispatch(uint8_t command) {
+    if (command == Cmd::TRACE_READ) {
+        _activeTxn = 0;
+        return;
+    }
+
+    uint32_t now = Profiler::cycles();
+    if (++_nextTxn == 0) {
+        _nextTxn = 1;  // 0 - нет транзакции
+    }
+    _activeTxn = _nextTxn;
+
+    Record start = {_frameStartCycles, _activeTxn, static_cast<uint8_t>(TraceEvent::FRAME_START), 0};
+    Record complete = {_frameCompleteCycles, _activeTxn, static_cast<uint8_t>(TraceEvent::FRAME_COMPLETE), command};
+    Record entry = {now, _activeTxn, static_cast<uint8_t>(TraceEvent::DISPATCH), command};
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    push(start);
+    push(complete);
+    push(entry);
+    __set_PRIMASK(primask);
+}
+
+void Trace::response(uint8_t responseCode) {
+    if (_activeTxn != 0) {
+        record(TraceEvent::RESPONSE, responseCode, _activeTxn);
+    }
+}
+
+// Пишут главный цикл и SysTick, поэтому индекс двигается под PRIMASK
+void Trace::record(TraceEvent event, uint8_t arg, uint16_t txn) {
+    Record entry = {Profiler::cycles(), txn, static_cast<uint8_t>(event), arg};
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    push(entry);
+    __set_PRIMASK(primask);
+}
+
+// Вызывать с запрещенными прерываниями
+void Trace::push(const Record& entry) {
+    if (_head - _tail == TRACE_RING_SIZE) {
+        _tail++;
+        _dropped++;
+    }
+    _ring[_head++ % TRACE_RING_SIZE] = entry;
+}
+
+uint16_t Trace::drain(uint8_t* out, uint16_t capacity) {
+    uint8_t* p = out + TRACE_HEADER_SIZE;
+    uint8_t count = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    while (_tail != _head && (out + capacity) - p >= TRACE_RECORD_SIZE) {
+        const Record& entry = _ring[_tail++ % TRACE_RING_SIZE];
+        p = putLe32(p, entry.cycles);
+        p = putLe16(p, entry.txn);
+        *p++ = entry.event;
+        *p++ = entry.arg;
+        count++;
+    }
+    uint16_t dropped = _dropped > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(_dropped);
+    _dropped = 0;
+    __set_PRIMASK(primask);
+
+    uint8_t* h = out;
+    h = putLe32(h, SystemCoreClock);
+    h = putLe16(h, dropped);
+    *h = count;
+
+    return static_cast<uint16_t>(p - out);
+}
+
+void Trace::clear() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    _tail = _head;
+    _dropped = 0;
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+
+// Кольцо событий транзакций (CCMRAM), 8 байт на запись
+constexpr uint16_t TRACE_RING_SIZE = 256;
+constexpr uint8_t TRACE_RECORD_SIZE = 8;
+
+// Подкоманды TRACE (первый байт данных, без данных - READ)
+namespace TraceOp {
+    constexpr uint8_t READ  = 0x00;
+    constexpr uint8_t CLEAR = 0x01;
+}
+
+// Имена на хосте - scripts/squid/trace.py
+enum class TraceEvent : uint8_t {
+    FRAME_START     = 1,  // Первый байт кадра попал в кольцо DMA (оценка), arg = 0
+    FRAME_COMPLETE  = 2,  // Кадр принят и проверен, arg = команда
+    DISPATCH        = 3,  // Вход в processPacketCommand, arg = команда
+    DRIVER_TX_START = 4,  // Передача пакета драйверу по USART2, arg = мотор
+    DRIVER_TX_END   = 5,
+    STATUS_RISE     = 6,  // Фронт STATUS мотора (опрос в SysTick, шаг 1 мс), arg = мотор
+    STATUS_FALL     = 7,
+    RESPONSE        = 8,  // Ответ передан в sendPacket, arg = код ответа
+    SHIFT_FLUSH     = 9,  // ShiftOut: старт выдвигания образа, arg = число регистров
+    SHIFT_LATCH     = 10  // ShiftOut: фронт RCLK, выходы цепочки переключены
+};
+
+/**
+ * Трассировка команды от приема до движения: каждая запись - такт DWT CYCCNT,
+ * номер транзакции, событие и аргумент.
+ *
+ * Транзакция начинается на DISPATCH. Метки FRAME_START/FRAME_COMPLETE
+ * запоминаются заранее и пишутся вместе с DISPATCH, поэтому служебная
+ * команда TRACE в кольцо не попадает. События драйвера относятся к
+ * транзакции, запустившей движение (moveTransaction).
+ *
+ * При переполнении затираются самые старые записи, счетчик dropped растет.
+ */
+class Trace {
+public:
+    /**
+     * @brief Начало кадра
+     * @param backlogBytes Байт в кольце DMA после первого байта кадра:
+     *        момент прихода оценивается назад по скорости линии
+     */
+    static void frameStart(uint16_t backlogBytes);
+    static void frameComplete();
+
+    static void dispatch(uint8_t command);
+    static void endDispatch() { _activeTxn = 0; }
+    static void response(uint8_t responseCode);
+
+    static uint16_t activeTransaction() { return _activeTxn; }
+    static void record(TraceEvent event, uint8_t arg, uint16_t txn);
+
+    /**
+     * @brief Выдать и удалить из кольца самые старые записи
+     * @return Количество записанных байт
+     */
+    static uint16_t drain(uint8_t* out, uint16_t capacity);
+    static void clear();
+
+private:
+    struct Record {
+        uint32_t cycles;
+        uint16_t txn;
+        uint8_t event;
+        uint8_t arg;
+    };
+
+    static void push(const Record& entry);
+
+    static Record _ring[TRACE_RING_SIZE];
+    static uint32_t _head;     // Всего записано
+    static uint32_t _tail;     // Всего прочитано или затерто
+    static uint32_t _dropped;
+    static uint16_t _nextTxn;
+    static uint16_t _activeTxn;
+    static uint32_t _frameStartCycles;
+    static uint32_t _frameCompleteCycles;
+    static uint8_t _frameCommand;
+};
@@ -1,8 +1,14 @@
 #include "uart_dma.hpp"
 #include "protocol.hpp"
+#include "memory_sections.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
+#include "log.hpp"
+#include "motor_controller.hpp"
+#include "board.hpp"
 #include "../system/include/cmsis/stm32f4xx.h"
 
-UartDma g_uartDma;
+DMA_BUFFER UartDma g_uartDma;
 
 extern PacketParser g_packetParser;
 extern volatile bool g_packetReady;
@@ -18,6 +24,7 @@ void UartDma::init() {
     UART4->BRR = 0x8B;  // 115200 @ 16MHz HSI
 
     UART4->CR3 |= USART_CR3_DMAR | USART_CR3_DMAT;
+    UART4->CR3 |= USART_CR3_EIE;  // ORE/FE/NE при DMAR=1 приходят только через EIE
     UART4->CR1 |= USART_CR1_IDLEIE;
     UART4->CR1 |= USART_CR1_TE | USART_CR1_RE | USART_CR1_UE;
 
@@ -31,7 +38,7 @@ void UartDma::init() {
     DMA1_Stream2->CR |= (4U << DMA_SxCR_CHSEL_Pos);
     DMA1_Stream2->CR |= DMA_SxCR_MINC;
     DMA1_Stream2->CR |= DMA_SxCR_CIRC;
-    DMA1_Stream2->CR |= DMA_SxCR_HTIE | DMA_SxCR_TCIE;
+    DMA1_Stream2->CR |= DMA_SxCR_HTIE | DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_DMEIE;
     DMA1_Stream2->PAR = reinterpret_cast<uint32_t>(&UART4->DR);
     DMA1_Stream2->M0AR = reinterpret_cast<uint32_t>(_rxBuffer);
     DMA1_Stream2->NDTR = UART_DMA_RX_BUFFER_SIZE;
@@ -46,7 +53,7 @@ void UartDma::init() {
     DMA1_Stream4->CR |= (4U << DMA_SxCR_CHSEL_Pos);
     DMA1_Stream4->CR |= DMA_SxCR_MINC;
     DMA1_Stream4->CR |= DMA_SxCR_DIR_0;
-    DMA1_Stream4->CR |= DMA_SxCR_TCIE;
+    DMA1_Stream4->CR |= DMA_SxCR_TCIE | DMA_SxCR_TEIE;
     DMA1_Stream4->PAR = reinterpret_cast<uint32_t>(&UART4->DR);
 
     NVIC_EnableIRQ(DMA1_Stream4_IRQn);
@@ -57,8 +64,12 @@ void UartDma::startRx() {
     _rxHead = 0;
     _rxTail = 0;
     _rxPending = false;
+    _rxWritten = 0;
+    _rxConsumed = 0;
+    _rxOverflow = false;
 
-    DMA1->LIFCR = DMA_LIFCR_CTCIF2 | DMA_LIFCR_CHTIF2 | DMA_LIFCR_CTEIF2;
+    DMA1->LIFCR = DMA_LIFCR_CTCIF2 | DMA_LIFCR_CHTIF2 | DMA_LIFCR_CTEIF2 |
+                  DMA_LIFCR_CDMEIF2 | DMA_LIFCR_CFEIF2;
     DMA1_Stream2->CR |= DMA_SxCR_EN;
 }
 
@@ -95,47 +106,145 @@ uint16_t UartDma::getRxDataLength() const {
     }
 }
 
-void UartDma::processRxBuffer(uint16_t startPos, uint16_t endPos) {
+// Разбор останавливается на готовом пакете: остаток остается в кольце
+// и дочитывается после обработки команды, иначе следующий кадр потерялся бы.
+uint16_t UartDma::processRxBuffer(uint16_t startPos, uint16_t endPos) {
     uint16_t pos = startPos;
 
     while (pos != endPos) {
         uint8_t byte = _rxBuffer[pos];
+        pos = (pos + 1) % UART_DMA_RX_BUFFER_SIZE;
 
-        if (g_packetParser.processByte(byte)) {
-            g_packetReady = true;
+        bool idle = (g_packetParser.state == PacketState::WAIT_STX);
+        bool ready = g_packetParser.processByte(byte);
+        if (idle && g_packetParser.state != PacketState::WAIT_STX) {
+            uint16_t backlog = (endPos + UART_DMA_RX_BUFFER_SIZE - pos) % UART_DMA_RX_BUFFER_SIZE;
+            Trace::frameStart(backlog);
         }
 
-        pos = (pos + 1) % UART_DMA_RX_BUFFER_SIZE;
+        if (ready) {
+            Trace::frameComplete();
+            g_packetReady = true;
+            break;
+        }
     }
 
-    _rxTail = endPos;
+    _rxConsumed += (pos + UART_DMA_RX_BUFFER_SIZE - startPos) % UART_DMA_RX_BUFFER_SIZE;
+    _rxTail = pos;
+    return pos;
 }
 
 void UartDma::processRxData() {
+    PROFILE_SCOPE(ProfileSection::RX_PROCESS);
+    if (_rxRestart || _rxOverflow) {
+        recoverRx();
+    }
+
+    // Хвост кадра, найденного повторным поиском STX, принят раньше байтов кольца
+    if (g_packetParser.hasCarry() && !g_packetReady && g_packetParser.replayCarry()) {
+        Trace::frameComplete();
+        g_packetReady = true;
+        return;
+    }
+
     uint16_t currentPos = UART_DMA_RX_BUFFER_SIZE - DMA1_Stream2->NDTR;
 
     if (currentPos != _rxTail) {
-        processRxBuffer(_rxTail, currentPos);
+        if (processRxBuffer(_rxTail, currentPos) != currentPos) {
+            return;
+        }
     }
 
     _rxPending = false;
 }
 
+// Сбой приема: поток выключен ошибкой DMA или непрочитанные байты затерты.
+// Перезапуск идет из главного цикла, чтобы не гоняться с processRxBuffer за _rxTail.
+void UartDma::recoverRx() {
+    if (_rxRestart) {
+        _rxRestart = false;
+        _errors.rxRestarts++;
+        LOG("uart4 rx dma restart, NDTR %u", DMA1_Stream2->NDTR);
+
+        stopDMAStream2();
+        DMA1_Stream2->NDTR = UART_DMA_RX_BUFFER_SIZE;
+        startRx();
+    } else {
+        // Все, что не успели разобрать, считается потерянным: продолжаем
+        // с текущей позиции DMA
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint16_t currentPos = UART_DMA_RX_BUFFER_SIZE - DMA1_Stream2->NDTR;
+        uint16_t boundary = _rxWritten % UART_DMA_RX_BUFFER_SIZE;
+        _rxConsumed = _rxWritten + (currentPos + UART_DMA_RX_BUFFER_SIZE - boundary) % UART_DMA_RX_BUFFER_SIZE;
+        _rxTail = currentPos;
+        _rxOverflow = false;
+        __set_PRIMASK(primask);
+    }
+
+    // Собранный наполовину кадр испорчен, готовый кадр еще ждет обработки
+    if (!g_packetReady) {
+        g_packetParser.reset();
+    }
+}
+
+// DMA дописал половину кольца. Если неразобранных байт больше размера
+// кольца, старые уже перезаписаны
+void UartDma::noteRxHalf() {
+    _rxWritten += UART_DMA_RX_BUFFER_SIZE / 2;
+    int32_t unread = static_cast<int32_t>(_rxWritten - _rxConsumed);
+    if (unread > static_cast<int32_t>(UART_DMA_RX_BUFFER_SIZE) && !_rxOverflow) {
+        _errors.rxRingOverflow++;
+        _rxOverflow = true;
+    }
+}
+
 void UartDma::handleDmaRxIrq() {
-    if (DMA1->LISR & DMA_LISR_HTIF2) {
+    uint32_t flags = DMA1->LISR;
+
+    if (flags & DMA_LISR_FEIF2) {
+        DMA1->LIFCR = DMA_LIFCR_CFEIF2;
+        _errors.dmaRxFifo++;
+    }
+
+    // TE/DME выключают поток: перезапуск в recoverRx()
+    if (flags & (DMA_LISR_TEIF2 | DMA_LISR_DMEIF2)) {
+        DMA1->LIFCR = DMA_LIFCR_CTEIF2 | DMA_LIFCR_CDMEIF2;
+        if (flags & DMA_LISR_TEIF2) {
+            _errors.dmaRxTransfer++;
+        }
+        if (flags & DMA_LISR_DMEIF2) {
+            _errors.dmaRxDirect++;
+        }
+        _rxRestart = true;
+        _rxPending = true;
+    }
+
+    if (flags & DMA_LISR_HTIF2) {
         DMA1->LIFCR = DMA_LIFCR_CHTIF2;
+        noteRxHalf();
         _rxPending = true;
-        GPIOD->ODR ^= GPIO_ODR_OD14;
+        _lineIdle = false;
+        Board::LedRed::toggle();
     }
 
-    if (DMA1->LISR & DMA_LISR_TCIF2) {
+    if (flags & DMA_LISR_TCIF2) {
         DMA1->LIFCR = DMA_LIFCR_CTCIF2;
+        noteRxHalf();
         _rxPending = true;
-        GPIOD->ODR ^= GPIO_ODR_OD15;
+        _lineIdle = false;
+        Board::LedBlue::toggle();
     }
 }
 
 void UartDma::handleDmaTxIrq() {
+    if (DMA1->HISR & DMA_HISR_TEIF4) {
+        DMA1->HIFCR = DMA_HIFCR_CTEIF4;
+        DMA1_Stream4->CR &= ~DMA_SxCR_EN;
+        _errors.dmaTxTransfer++;
+        _txBusy = false;  // Иначе sendPacket() ждал бы вечно
+    }
+
     if (DMA1->HISR & DMA_HISR_TCIF4) {
         DMA1->HIFCR = DMA_HIFCR_CTCIF4;
         DMA1_Stream4->CR &= ~DMA_SxCR_EN;
@@ -143,13 +252,47 @@ void UartDma::handleDmaTxIrq() {
     }
 }
 
-void UartDma::handleUartIdleIrq() {
-    if (UART4->SR & USART_SR_IDLE) {
-        volatile uint32_t tmp = UART4->SR;
-        tmp = UART4->DR;
-        (void)tmp;
+void UartDma::handleUartIrq() {
+    uint32_t status = UART4->SR;
+    if (!(status & (USART_SR_IDLE | USART_SR_ORE | USART_SR_FE | USART_SR_NE))) {
+        return;
+    }
 
+    // Все четыре флага снимаются одной последовательностью: чтение SR, затем DR.
+    // Байт с FE/NE DMA уже забрал, из DR читается его копия
+    volatile uint32_t tmp = UART4->DR;
+    (void)tmp;
+
+    if (status & USART_SR_ORE) {
+        _errors.uartOverrun++;
+    }
+    if (status & USART_SR_FE) {
+        _errors.uartFraming++;
+    }
+    if (status & USART_SR_NE) {
+        _errors.uartNoise++;
+    }
+
+    if (status & USART_SR_IDLE) {
         _rxPending = true;
-        GPIOD->ODR ^= GPIO_ODR_OD13;
+        _lineIdle = true;
+        Board::LedOrange::toggle();
     }
 }
+
+// Повторный IDLE между чтением и сбросом - та же пауза: байты до нее
+// разберет processRxData() после этого вызова
+bool UartDma::takeLineIdle() {
+    if (!_lineIdle) {
+        return false;
+    }
+    _lineIdle = false;
+    return true;
+}
+
+void UartDma::clearErrors() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    _errors = UartDmaErrors();
+    __set_PRIMASK(primask);
+}
@@ -1,9 +1,25 @@
 #pragma once
 
 #include <cstdint>
+#include "constants.hpp"
 
-constexpr uint16_t UART_DMA_RX_BUFFER_SIZE = 64;
-constexpr uint16_t UART_DMA_TX_BUFFER_SIZE = 64;
+constexpr uint16_t UART_DMA_RX_BUFFER_SIZE = 512;  // Переживает блокирующую отправку ответа 256 байт
+// Вмещает кадр TELEMETRY: 43 байта для 10 моторов, 169 - для 64
+constexpr uint16_t UART_DMA_TX_BUFFER_SIZE = MAX_MOTORS <= 16 ? 64 : 192;
+constexpr uint32_t UART_DMA_BAUDRATE = 115200;  // BRR = 0x8B при 16 МГц
+
+// Ошибки UART4 и потоков DMA (пишутся из ISR, читаются LINK_STATS)
+struct UartDmaErrors {
+    uint32_t uartOverrun;     // ORE: байт пришел раньше, чем DMA забрал предыдущий
+    uint32_t uartFraming;     // FE: нет стоп-бита
+    uint32_t uartNoise;       // NE: шум на линии RX
+    uint32_t dmaRxTransfer;   // TEIF2: ошибка шины, поток выключен аппаратно
+    uint32_t dmaRxDirect;     // DMEIF2: ошибка прямого режима
+    uint32_t dmaRxFifo;       // FEIF2
+    uint32_t dmaTxTransfer;   // TEIF4
+    uint32_t rxRingOverflow;  // Кольцо приема перезаписано до разбора
+    uint32_t rxRestarts;      // Перезапуски потока приема после ошибки
+};
 
 class UartDma {
 public:
@@ -20,13 +36,21 @@ public:
     void processRxData();
     bool hasPendingRxData() const { return _rxPending; }
     void clearRxPending() { _rxPending = false; }
+    // IDLE приходит один раз на паузу линии: флаг снимается при чтении
+    bool takeLineIdle();
+    bool isTxBusy() const { return _txBusy; }
 
     void handleDmaRxIrq();
     void handleDmaTxIrq();
-    void handleUartIdleIrq();
+    void handleUartIrq();
+
+    const UartDmaErrors& getErrors() const { return _errors; }
+    void clearErrors();
 
 private:
-    void processRxBuffer(uint16_t startPos, uint16_t endPos);
+    uint16_t processRxBuffer(uint16_t startPos, uint16_t endPos);
+    void noteRxHalf();
+    void recoverRx();
 
     uint8_t _rxBuffer[UART_DMA_RX_BUFFER_SIZE];
     uint8_t _txBuffer[UART_DMA_TX_BUFFER_SIZE];
@@ -34,7 +58,15 @@ private:
     volatile uint16_t _rxHead = 0;
     volatile uint16_t _rxTail = 0;
     volatile bool _rxPending = false;
+    volatile bool _lineIdle = false;
     volatile bool _txBusy = false;
+
+    // Байты от старта приема: записанные DMA (на границах HT/TC) и разобранные
+    volatile uint32_t _rxWritten = 0;
+    volatile uint32_t _rxConsumed = 0;
+    volatile bool _rxOverflow = false;
+    volatile bool _rxRestart = false;
+    UartDmaErrors _errors = {};
 };
 
 extern UartDma g_uartDma;
@@ -0,0 +1,225 @@
+#include "velocity_stream.hpp"
+#include "protocol.hpp"
+#include "profiler.hpp"
+#include "log.hpp"
+#include "../system/include/cmsis/stm32f4xx.h"
+
+VelocityStream::Table VelocityStream::_tables[2];
+volatile uint8_t VelocityStream::_front = 0;
+volatile StreamState VelocityStream::_state = StreamState::IDLE;
+volatile uint32_t VelocityStream::_lastFrameMs = 0;
+uint16_t VelocityStream::_periodUs = 0;
+uint16_t VelocityStream::_timeoutMs = 0;
+uint32_t VelocityStream::_acceleration = 0;
+int32_t VelocityStream::_velocity[STEP_DIR_CHANNELS];
+uint32_t VelocityStream::_slewRest = 0;
+bool VelocityStream::_stalled = false;
+uint32_t VelocityStream::_frames = 0;
+uint32_t VelocityStream::_late = 0;
+uint32_t VelocityStream::_lost = 0;
+uint16_t VelocityStream::_watchdogTrips = 0;
+uint8_t VelocityStream::_nextSeq = 0;
+uint32_t VelocityStream::_lastCycles = 0;
+uint32_t VelocityStream::_lastIntervalUs = 0;
+uint32_t VelocityStream::_maxJitterUs = 0;
+uint64_t VelocityStream::_jitterSumUs = 0;
+uint32_t VelocityStream::_rejected = 0;
+uint8_t VelocityStream::_lastError = 0;
+uint8_t VelocityStream::_lastFault = 0;
+uint8_t VelocityStream::_lastIndex = 0;
+
+static constexpr uint8_t CHANNEL_COUNT = maskBits(BOARD_STEP_DIR);
+
+uint8_t VelocityStream::start(uint16_t periodUs, uint16_t timeoutMs, uint32_t acceleration, uint32_t now) {
+    if (CHANNEL_COUNT == 0) {
+        return VelocityResult::UNSUPPORTED;
+    }
+    if (periodUs == 0 || acceleration == 0 || static_cast<uint32_t>(timeoutMs) * 1000 <= periodUs) {
+        return VelocityResult::INVALID;
+    }
+
+    // Идущий поток продолжается с текущих скоростей, меняются только
+    // параметры и счетчики
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (_state != StreamState::STREAMING) {
+        // Уставки до STOP не возвращаются: оси стоят до первого кадра
+        for (uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ++ch) {
+            _tables[_front].velocity[ch] = 0;
+        }
+    }
+    if (_state == StreamState::IDLE) {
+        for (uint8_t ch = 0; ch < STEP_DIR_CHANNELS; ++ch) {
+            _velocity[ch] = 0;
+        }
+        _slewRest = 0;
+    }
+    _periodUs = periodUs;
+    _timeoutMs = timeoutMs;
+    _acceleration = acceleration;
+    _lastFrameMs = now;
+    _stalled = false;
+    _frames = 0;
+    _late = 0;
+    _lost = 0;
+    _watchdogTrips = 0;
+    _lastIntervalUs = 0;
+    _maxJitterUs = 0;
+    _jitterSumUs = 0;
+    _rejected = 0;
+    _lastError = 0;
+    _lastFault = 0;
+    _lastIndex = 0;
+    _state = StreamState::STREAMING;
+    __set_PRIMASK(primask);
+
+    LOG("velocity: start, period %u us, timeout %u ms", periodUs, timeoutMs);
+    return VelocityResult::OK;
+}
+
+void VelocityStream::stop() {
+    if (_state == StreamState::STREAMING) {
+        _state = StreamState::STOPPING;
+    }
+}
+
+void VelocityStream::abort() {
+    if (_state == StreamState::IDLE) {
+        return;
+    }
+    _state = StreamState::IDLE;
+    LOG("velocity: aborted, %u frames", _frames);
+}
+
+uint8_t VelocityStream::submit(uint8_t seq, MotorMask mask, const uint8_t* velocities,
+                               uint8_t* badIndex, uint32_t now) {
+    uint8_t index = 0;
+    for (MotorMask m = mask; m != 0; m &= m - 1, ++index) {
+        *badIndex = index;
+        uint8_t motorNum = lowestMotorIndex(m) + 1;
+        int32_t velocity = static_cast<int32_t>(getLe32(velocities + index * VELOCITY_VALUE_SIZE));
+        uint32_t speed = velocity < 0 ? 0U - static_cast<uint32_t>(velocity) : static_cast<uint32_t>(velocity);
+        if (motorNum > MAX_MOTORS) {
+            return ParamFault::NUMBER;
+        }
+        if (!StepDir::owns(motorNum)) {
+            return ParamFault::STREAM;
+        }
+        if (speed > STEP_MAX_RATE_HZ) {
+            return ParamFault::SPEED;
+        }
+    }
+    *badIndex = 0;
+
+    // tick() читает только _tables[_front]: вторая таблица свободна
+    uint8_t back = _front ^ 1;
+    _tables[back] = _tables[_front];
+    index = 0;
+    for (MotorMask m = mask; m != 0; m &= m - 1, ++index) {
+        uint8_t ch = StepDir::channelOf(lowestMotorIndex(m) + 1);
+        _tables[back].velocity[ch] = static_cast<int32_t>(getLe32(velocities + index * VELOCITY_VALUE_SIZE));
+    }
+    _lastFrameMs = now;
+    _front = back;
+
+    recordArrival(seq);
+    return ParamFault::NONE;
+}
+
+void VelocityStream::reject(uint8_t error, uint8_t fault, uint8_t index) {
+    _rejected++;
+    _lastError = error;
+    _lastFault = fault;
+    _lastIndex = index;
+}
+
+// Первый кадр после START только задает точку отсчета
+void VelocityStream::recordArrival(uint8_t seq) {
+    uint32_t cycles = Profiler::cycles();
+    if (_frames != 0) {
+        uint32_t intervalUs = (cycles - _lastCycles) / (SystemCoreClock / 1000000);
+        uint32_t jitterUs = intervalUs > _periodUs ? intervalUs - _periodUs : _periodUs - intervalUs;
+        _lastIntervalUs = intervalUs;
+        _jitterSumUs += jitterUs;
+        if (jitterUs > _maxJitterUs) {
+            _maxJitterUs = jitterUs;
+        }
+        if (intervalUs > _periodUs + _periodUs / 2) {
+            _late++;
+        }
+        _lost += static_cast<uint8_t>(seq - _nextSeq);
+    }
+    _lastCycles = cycles;
+    _nextSeq = static_cast<uint8_t>(seq + 1);
+    _frames++;
+}
+
+void VelocityStream::tick(uint32_t now) {
+    if (_state == StreamState::IDLE) {
+        return;
+    }
+
+    bool stalled = now - _lastFrameMs >= _timeoutMs;
+    if (stalled && !_stalled && _state == StreamState::STREAMING) {
+        _watchdogTrips++;
+        LOG("velocity: watchdog, no frame for %u ms", now - _lastFrameMs);
+    }
+    _stalled = stalled;
+    bool zero = stalled || _state == StreamState::STOPPING;
+
+    _slewRest += _acceleration;
+    int32_t step = static_cast<int32_t>(_slewRest / 1000);
+    _slewRest %= 1000;
+
+    const Table& table = _tables[_front];
+    bool moving = false;
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ++ch) {
+        int32_t target = zero ? 0 : table.velocity[ch];
+        int32_t v = _velocity[ch];
+        int32_t next = v;
+        if (v < target) {
+            next = target - v > step ? v + step : target;
+        } else if (v > target) {
+            next = v - target > step ? v - step : target;
+        }
+        // DIR меняется только на стоящем канале: через ноль - на отдельном тике
+        if ((v < 0 && next > 0) || (v > 0 && next < 0)) {
+            next = 0;
+        }
+        if (next != v) {
+            _velocity[ch] = next;
+            StepDir::setVelocity(ch, next);
+        }
+        moving = moving || next != 0;
+    }
+
+    if (_state == StreamState::STOPPING && !moving) {
+        _state = StreamState::IDLE;
+        LOG("velocity: stopped, %u frames, %u late, %u lost", _frames, _late, _lost);
+    }
+}
+
+uint8_t VelocityStream::serialize(uint8_t* out) {
+    uint32_t intervals = _frames > 1 ? _frames - 1 : 0;
+    uint32_t meanJitterUs = intervals != 0 ? static_cast<uint32_t>(_jitterSumUs / intervals) : 0;
+
+    uint8_t* p = out;
+    *p++ = static_cast<uint8_t>(_state);
+    p = putLe32(p, _frames);
+    p = putLe32(p, _late);
+    p = putLe32(p, _lost);
+    p = putLe16(p, _watchdogTrips);
+    p = putLe32(p, _lastIntervalUs);
+    p = putLe32(p, _maxJitterUs);
+    p = putLe32(p, meanJitterUs);
+    p = putLe32(p, _rejected);
+    *p++ = _lastError;
+    *p++ = _lastFault;
+    *p++ = _lastIndex;
+    *p++ = CHANNEL_COUNT;
+    for (uint8_t ch = 0; ch < CHANNEL_COUNT; ++ch) {
+        *p++ = StepDir::motorOf(ch);
+        p = putLe32(p, static_cast<uint32_t>(_velocity[ch]));
+    }
+    return static_cast<uint8_t>(p - out);
+}
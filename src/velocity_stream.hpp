@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include "constants.hpp"
+#include "step_dir.hpp"
+
+// Кадр VELOCITY_SET: seq u8 + mask (2, 4 или 8 байт) + velocity i32 на бит маски
+constexpr uint8_t VELOCITY_VALUE_SIZE = 4;
+// Ответ STATS: op, result, state, frames, late, lost, trips, last, max, mean,
+// rejected, error, fault, index, count и (motor u8, velocity i32) на канал
+constexpr uint8_t VELOCITY_STATS_SIZE = 3 + 4 * 3 + 2 + 4 * 3 + 4 + 3 + 1 + STEP_DIR_CHANNELS * 5;
+
+// Подкоманды VELOCITY (первый байт данных)
+namespace VelocityOp {
+    constexpr uint8_t START = 0x00;  // period_us u16, timeout_ms u16, accel u32
+    constexpr uint8_t STOP  = 0x01;  // Торможение с accel до нуля, затем IDLE
+    constexpr uint8_t STATS = 0x02;  // -> состояние, счетчики кадров, скорости каналов
+}
+
+namespace VelocityResult {
+    constexpr uint8_t OK          = 0x00;
+    constexpr uint8_t BUSY        = 0x01;  // Идет движение или программа
+    constexpr uint8_t INVALID     = 0x02;  // Нулевые период или ускорение, таймаут не длиннее периода
+    constexpr uint8_t UNSUPPORTED = 0x03;  // На плате нет STEP/DIR-моторов (BOARD_STEP_DIR)
+}
+
+enum class StreamState : uint8_t {
+    IDLE,
+    STREAMING,
+    STOPPING
+};
+
+/**
+ * Потоковый режим: хост шлет уставки скорости 500-1000 раз в секунду
+ * вместо отдельных движений.
+ *
+ * Кадр VELOCITY_SET - маска моторов и скорость (шаг/с со знаком) на
+ * каждый бит, без ответа: 2 оси - 16 байт, ~1.4 мс на 115200. SYNC_MOVE
+ * на те же оси - 37 байт туда, ответ и пакеты драйверам. Отклоненный кадр
+ * тоже без ответа: его видно по счетчику rejected и последней ошибке в STATS.
+ *
+ * Таблица уставок двойная: главный цикл копирует активную таблицу во
+ * вторую, пишет в нее кадр и переключает индекс одной записью байта.
+ * tick() из SysTick (1 кГц) читает только активную таблицу, поэтому
+ * видит кадр целиком или не видит вовсе, без запрета прерываний.
+ *
+ * tick() ведет скорость каждого канала к уставке с ускорением accel и
+ * отдает ее StepDir::setVelocity(). Смена знака проходит через ноль:
+ * DIR меняется только на стоящем канале. Если кадров нет дольше
+ * timeout_ms, уставки считаются нулевыми (сторож) - оси тормозят с тем
+ * же ускорением и снова разгоняются со следующим кадром.
+ *
+ * Время прихода кадров - по DWT CYCCNT в момент разбора: интервал длиннее
+ * полутора периодов - опоздавший кадр, |интервал - период| - дрожание,
+ * пропуск номеров seq - потерянные кадры.
+ *
+ * Работает только на STEP/DIR-каналах: драйверам пакета 0x78 скорость
+ * не задать, они исполняют только движение на заданное число шагов.
+ */
+class VelocityStream {
+public:
+    /**
+     * @brief Включить режим или сменить параметры уже идущего потока
+     * @param periodUs Ожидаемый период кадров, от него считаются опоздания
+     * @param timeoutMs Сторож: без кадров дольше - торможение до нуля
+     * @return VelocityResult::OK, INVALID или UNSUPPORTED (BUSY проверяет вызывающий)
+     */
+    static uint8_t start(uint16_t periodUs, uint16_t timeoutMs, uint32_t acceleration, uint32_t now);
+    static void stop();
+    // STOP и аварии: каналы уже остановлены или остановятся следом (stopAll)
+    static void abort();
+
+    static bool isActive() { return _state != StreamState::IDLE; }
+    static bool isStreaming() { return _state == StreamState::STREAMING; }
+
+    /**
+     * @brief Принять кадр VELOCITY_SET: сначала проверка всех значений, потом запись
+     * @param velocities popcount(mask) значений i32
+     * @param badIndex Номер неверного значения в кадре
+     * @return ParamFault::NONE, NUMBER, STREAM (мотор не на STEP/DIR) или SPEED
+     */
+    static uint8_t submit(uint8_t seq, MotorMask mask, const uint8_t* velocities,
+                          uint8_t* badIndex, uint32_t now);
+
+    // Кадр отклонен: код Error, причина ParamFault и номер значения, как в ERROR
+    static void reject(uint8_t error, uint8_t fault, uint8_t index);
+
+    // Из SysTick после MotorDriver::tick()
+    static void tick(uint32_t now);
+
+    static uint8_t serialize(uint8_t* out);
+
+private:
+    struct Table {
+        int32_t velocity[STEP_DIR_CHANNELS];
+    };
+
+    static void recordArrival(uint8_t seq);
+
+    static Table _tables[2];
+    static volatile uint8_t _front;       // Таблица, которую читает tick()
+    static volatile StreamState _state;
+    static volatile uint32_t _lastFrameMs;
+
+    static uint16_t _periodUs;
+    static uint16_t _timeoutMs;
+    static uint32_t _acceleration;
+
+    // Только tick()
+    static int32_t _velocity[STEP_DIR_CHANNELS];
+    static uint32_t _slewRest;             // Остаток accel / 1000 между тиками
+    static bool _stalled;
+
+    static uint32_t _frames;
+    static uint32_t _late;
+    static uint32_t _lost;
+    static uint16_t _watchdogTrips;
+    static uint8_t _nextSeq;
+    static uint32_t _lastCycles;
+    static uint32_t _lastIntervalUs;
+    static uint32_t _maxJitterUs;
+    static uint64_t _jitterSumUs;
+    static uint32_t _rejected;
+    static uint8_t _lastError;
+    static uint8_t _lastFault;
+    static uint8_t _lastIndex;
+};
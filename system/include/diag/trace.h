@@ -49,7 +49,8 @@
 // By default the trace messages are forwarded to the ITM output,
 // but can be rerouted via any device or completely suppressed by
 // changing the definitions required in system/src/diag/trace-impl.c
-// (currently OS_USE_TRACE_ITM, OS_USE_TRACE_SEMIHOSTING_DEBUG/_STDOUT).
+// (currently OS_USE_TRACE_ITM, OS_USE_TRACE_SEMIHOSTING_DEBUG/_STDOUT,
+// OS_USE_TRACE_RAM_RING).
 //
 // When TRACE is not defined, all functions are inlined to empty bodies.
 // This has the advantage that the trace call do not need to be conditionally
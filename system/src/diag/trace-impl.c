@@ -40,6 +40,7 @@
 // #define OS_USE_TRACE_ITM
 // #define OS_USE_TRACE_SEMIHOSTING_DEBUG
 // #define OS_USE_TRACE_SEMIHOSTING_STDOUT
+// #define OS_USE_TRACE_RAM_RING
 
 #if !(defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
 #if defined(OS_USE_TRACE_ITM)
@@ -70,6 +71,11 @@ static ssize_t _trace_write_semihosting_stdout(const char *buf, size_t nbyte);
 static ssize_t _trace_write_semihosting_debug(const char *buf, size_t nbyte);
 #endif
 
+#if defined(OS_USE_TRACE_RAM_RING)
+// Non-blocking RAM ring drained over the PC protocol (src/log.cpp).
+extern ssize_t log_trace_write(const char *buf, size_t nbyte);
+#endif
+
 // ----------------------------------------------------------------------------
 
 void trace_initialize(void)
@@ -90,6 +96,8 @@ ssize_t trace_write(const char *buf __attribute__((unused)), size_t nbyte __attr
     return _trace_write_semihosting_stdout(buf, nbyte);
 #elif defined(OS_USE_TRACE_SEMIHOSTING_DEBUG)
     return _trace_write_semihosting_debug(buf, nbyte);
+#elif defined(OS_USE_TRACE_RAM_RING)
+    return log_trace_write(buf, nbyte);
 #endif
 
     return -1;
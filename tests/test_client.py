@@ -0,0 +1,417 @@
+import sys
+from pathlib import Path
+
+import struct
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid import SquidClient, MotorParams, ProtocolError
+import squid.client
+from squid.client import PROFILE_WRITE_TIMEOUT
+from squid.motor import ProfileRef, MotionProfile, LinearAxis, CompactEncoder
+from squid.segments import Segment
+from squid.errors import TimeoutError
+from squid.packet import Packet
+from squid.protocol import Command, Response, ErrorCode, SessionFlag, SampleOp, LogOp, TelemetryFlag, WaitStatus, SeqOp, SeqResult, ProfileOp, ParamFault, VelocityOp, VelocityResult, StreamState
+
+
+pytestmark = pytest.mark.asyncio
+
+
+class FakeTransport:
+    """replies - ответы по очереди; pending - кадры, принятые еще до запроса."""
+
+    def __init__(self, replies, pending=()):
+        self.replies = list(replies)
+        self.pending = list(pending)
+        self.sent = []
+        self.timeouts = []
+        self.input_checks = 0
+        self.session = SessionFlag.NONE
+        self.framings = []
+        self.discarded = 0
+
+    async def connect(self):
+        pass
+
+    async def send_packet(self, packet):
+        self.sent.append(packet)
+        self.framings.append(self.session)
+
+    async def discard_input(self):
+        self.discarded += 1
+
+    async def receive_packet(self, timeout=5.0):
+        if self.pending:
+            return self.pending.pop(0)
+        self.timeouts.append(timeout)
+        reply = self.replies.pop(0)
+        if isinstance(reply, Exception):
+            raise reply
+        return reply
+
+    async def has_input(self):
+        self.input_checks += 1
+        return bool(self.pending)
+
+    def set_session(self, flags):
+        self.session = flags
+
+
+def make_client(replies, retries=3, pending=()):
+    client = SquidClient("/dev/null", retries=retries, attempt_timeout=0.1)
+    client._transport = FakeTransport(replies, pending)
+    return client
+
+
+def nak(code):
+    return Packet(Response.ERROR, bytes([code]))
+
+
+class TestRetransmit:
+    async def test_retry_after_xor_nak(self):
+        client = make_client([nak(ErrorCode.XOR_CHECKSUM_ERROR), Packet(Response.VERSION, b"\x10")])
+        assert await client.get_version() == "1.0"
+        assert len(client._transport.sent) == 2
+        assert client._transport.input_checks == 2
+
+    async def test_stale_nak_dropped_before_command(self):
+        client = make_client([Packet(Response.VERSION, b"\x10")], pending=[nak(ErrorCode.INVALID_COMMAND)])
+        assert await client.get_version() == "1.0"
+        assert client._transport.pending == []
+
+    async def test_retry_after_length_nak(self):
+        client = make_client([nak(ErrorCode.INVALID_PACKET_LENGTH), Packet(Response.STOP, b"\x00")])
+        assert await client.stop() is True
+
+    async def test_retry_after_frame_timeout_nak(self):
+        client = make_client([nak(ErrorCode.FRAME_TIMEOUT), Packet(Response.VERSION, b"\x10")])
+        assert await client.get_version() == "1.0"
+
+    async def test_short_attempt_timeout(self):
+        client = make_client([TimeoutError("lost"), Packet(Response.VERSION, b"\x10")])
+        assert await client.get_version() == "1.0"
+        assert client._transport.timeouts[0] == pytest.approx(0.1)
+
+    async def test_gives_up_after_retries(self):
+        client = make_client([nak(ErrorCode.XOR_CHECKSUM_ERROR)] * 3, retries=2)
+        with pytest.raises(ProtocolError) as exc_info:
+            await client.get_version()
+        assert exc_info.value.error_code == ErrorCode.XOR_CHECKSUM_ERROR
+        assert len(client._transport.sent) == 3
+
+    async def test_other_errors_not_retried(self):
+        client = make_client([nak(ErrorCode.INVALID_COMMAND)])
+        with pytest.raises(ProtocolError):
+            await client.get_version()
+        assert len(client._transport.sent) == 1
+
+    async def test_move_not_retried_on_nak(self):
+        # NAK мог относиться к байтам, из которых MCU все же собрал и исполнил кадр
+        params = [MotorParams(number=1, acceleration=500, max_speed=1000, steps=100)]
+        client = make_client([nak(ErrorCode.XOR_CHECKSUM_ERROR), Packet(Response.MOVE, b"\x00")])
+        with pytest.raises(ProtocolError) as exc_info:
+            await client.async_move(params, timeout=5.0)
+        assert exc_info.value.error_code == ErrorCode.XOR_CHECKSUM_ERROR
+        assert len(client._transport.sent) == 1
+
+    async def test_param_error_names_record(self):
+        params = [MotorParams(number=n, acceleration=500, max_speed=1000, steps=100) for n in (1, 2, 2)]
+        reply = Packet(Response.ERROR, bytes([ErrorCode.MOTOR_PARAM_ERROR, ParamFault.DUPLICATE, 2]))
+        client = make_client([reply])
+        with pytest.raises(ProtocolError) as exc_info:
+            await client.async_move(params)
+        assert exc_info.value.fault == ParamFault.DUPLICATE
+        assert exc_info.value.record_index == 2
+        assert len(client._transport.sent) == 1
+
+    async def test_move_timeout_not_retried(self):
+        params = [MotorParams(number=1, acceleration=500, max_speed=1000, steps=100)]
+        client = make_client([TimeoutError("lost")])
+        with pytest.raises(TimeoutError):
+            await client.sync_move(params, timeout=5.0)
+        assert len(client._transport.sent) == 1
+        assert client._transport.sent[0].command == Command.SYNC_MOVE
+
+
+class TestSession:
+    async def test_enable_cobs(self):
+        client = make_client([Packet(Response.SESSION, bytes([SessionFlag.COBS_FRAMING]))])
+        accepted = await client.set_session(SessionFlag.COBS_FRAMING)
+
+        assert accepted == SessionFlag.COBS_FRAMING
+        assert client._transport.session == SessionFlag.COBS_FRAMING
+        assert client._transport.sent[0].data == bytes([SessionFlag.COBS_FRAMING])
+
+    async def test_rejected_flag_keeps_legacy(self):
+        client = make_client([Packet(Response.SESSION, b"\x00")])
+        assert await client.set_session(SessionFlag.COBS_FRAMING) == SessionFlag.NONE
+        assert client._transport.session == SessionFlag.NONE
+
+    async def test_enable_crc_and_cobs(self):
+        flags = SessionFlag.COBS_FRAMING | SessionFlag.CRC32
+        client = make_client([Packet(Response.SESSION, bytes([flags]))])
+        assert await client.set_session(flags) == flags
+        assert client._transport.session == flags
+
+    async def test_connect_resets_stale_session(self, monkeypatch):
+        # Сессия прошлого процесса: SESSION 0 во всех форматах, последним - классический
+        monkeypatch.setattr(squid.client, "SESSION_RESET_GAP", 0)
+        client = make_client([Packet(Response.SESSION, b"\x00")])
+        await client.connect()
+
+        t = client._transport
+        assert all(p.command == Command.SESSION and p.data == b"\x00" for p in t.sent)
+        assert set(t.framings[:-1]) == {
+            SessionFlag.COBS_FRAMING | SessionFlag.CRC32, SessionFlag.COBS_FRAMING, SessionFlag.CRC32,
+        }
+        assert t.framings[-1] == SessionFlag.NONE
+        assert t.discarded == 1
+        assert t.timeouts != [] and t.session == SessionFlag.NONE
+
+
+class TestStats:
+    async def test_get_stats(self):
+        payload = struct.pack("<IIIIIHHHHIIII", 1024, 312, 2900, 0, 0, 276, 1048, 256, 880, 1290, 170, 210, 415)
+        client = make_client([Packet(Response.STATS, payload)])
+        stats = await client.get_stats()
+
+        assert client._transport.sent[0].command == Command.STATS
+        assert stats.stack_headroom == 712
+        assert stats.tx_frame_size == 256
+
+
+class TestSamples:
+    async def test_read_follows_pages(self):
+        def page(pairs, next_index):
+            header = struct.pack("<IBHIIH", 0x08000000, 5, 2048, 30, 0, next_index)
+            return header + b"".join(struct.pack("<HH", i, n) for i, n in pairs)
+
+        client = make_client([
+            Packet(Response.SAMPLES, page([(1, 10)], 5)),
+            Packet(Response.SAMPLES, page([(5, 20)], 2048)),
+        ])
+        histogram = await client.read_samples()
+
+        sent = client._transport.sent
+        assert [p.data for p in sent] == [bytes([SampleOp.READ, 0, 0]), bytes([SampleOp.READ, 5, 0])]
+        assert histogram.buckets == {1: 10, 5: 20}
+
+
+class TestLog:
+    async def test_read_until_empty(self):
+        record = struct.pack("<IHB", 100, 0, 1) + struct.pack("<I", 7)
+        client = make_client([
+            Packet(Response.LOG, struct.pack("<HB", 3, 1) + record),
+            Packet(Response.LOG, struct.pack("<HB", 0, 0)),
+        ])
+        page = await client.read_log()
+
+        assert [p.data for p in client._transport.sent] == [bytes([LogOp.READ])] * 2
+        assert page.dropped == 3
+        assert page.records[0].args == [7]
+
+
+def telemetry_frame(sequence, completed=0):
+    return Packet(Response.TELEMETRY, struct.pack("<HIHHHH10H", sequence, 1000, 0x3, completed, 0, 0, *([50] * 10)))
+
+
+class TestTelemetry:
+    async def test_subscribe(self):
+        client = make_client([Packet(Response.SUBSCRIBE, struct.pack("<HB", 10, 1))])
+        period, flags = await client.subscribe(5)
+
+        assert client._transport.sent[0].data == struct.pack("<HB", 5, TelemetryFlag.ON_CHANGE)
+        assert period == 10
+        assert flags == TelemetryFlag.ON_CHANGE
+
+    async def test_unsolicited_frame_before_response(self):
+        client = make_client([telemetry_frame(7), Packet(Response.VERSION, b"\x10"), telemetry_frame(8, completed=1)])
+        assert await client.get_version() == "1.0"
+
+        frames = client.telemetry()
+        first = await frames.__anext__()
+        second = await frames.__anext__()
+        assert [first.sequence, second.sequence] == [7, 8]
+        assert second.completed == 1
+        assert second.elapsed_ms[0] == 50
+
+    async def test_queued_frame_kept_across_command(self):
+        # Кадр уже в буфере порта, когда уходит команда: не сбрасывается вместе со входом
+        client = make_client([Packet(Response.VERSION, b"\x10")], pending=[telemetry_frame(5)])
+        assert await client.get_version() == "1.0"
+        assert (await client.telemetry().__anext__()).sequence == 5
+
+
+def wait_reply(status, fired, faulted=0):
+    return Packet(Response.WAIT_EVENT, struct.pack("<BHHHH", status, fired, faulted, 0x3, fired))
+
+
+class TestWaitEvent:
+    async def test_event(self):
+        client = make_client([wait_reply(WaitStatus.EVENT, 0x2)])
+        event = await client.wait_event(0x3, timeout_ms=2000)
+
+        assert client._transport.sent[0].data == struct.pack("<HH", 0x3, 2000)
+        assert client._transport.timeouts == [3.0]
+        assert event.fired == 0x2
+        assert not event.timed_out
+
+    async def test_timeout_status(self):
+        client = make_client([wait_reply(WaitStatus.TIMEOUT, 0)])
+        assert (await client.wait_event(0x1, timeout_ms=100)).timed_out
+
+    async def test_late_reply_kept_for_next_wait(self):
+        client = make_client([wait_reply(WaitStatus.EVENT, 0x1, faulted=0x1), Packet(Response.STOP, b"\x00")])
+        assert await client.stop() is True
+
+        event = await client.wait_event(0x1)
+        assert event.faulted == 0x1
+        assert len(client._transport.sent) == 1
+
+    async def test_queued_reply_kept_across_command(self):
+        client = make_client([Packet(Response.STOP, b"\x00")], pending=[wait_reply(WaitStatus.EVENT, 0x2)])
+        assert await client.stop() is True
+        assert (await client.wait_event(0x2)).fired == 0x2
+
+    async def test_wide_mask(self):
+        reply = Packet(Response.WAIT_EVENT, struct.pack("<BIIII", WaitStatus.EVENT, 1 << 20, 0, 1 << 20, 0))
+        client = make_client([reply])
+        event = await client.wait_event(1 << 20, timeout_ms=100)
+
+        assert client._transport.sent[0].data == struct.pack("<IH", 1 << 20, 100)
+        assert event.fired == 1 << 20
+
+
+class TestSequence:
+    async def test_load_in_chunks(self):
+        program = bytes(300)
+        client = make_client([
+            Packet(Response.SEQUENCE, bytes([SeqOp.CLEAR, SeqResult.OK])),
+            Packet(Response.SEQUENCE, bytes([SeqOp.LOAD, SeqResult.OK]) + struct.pack("<H", 240)),
+            Packet(Response.SEQUENCE, bytes([SeqOp.LOAD, SeqResult.OK]) + struct.pack("<H", 300)),
+        ])
+        await client.load_sequence(program)
+
+        sent = client._transport.sent
+        assert sent[1].data[:3] == bytes([SeqOp.LOAD]) + struct.pack("<H", 0)
+        assert sent[2].data[:3] == bytes([SeqOp.LOAD]) + struct.pack("<H", 240)
+        assert len(sent[2].data) == 3 + 60
+
+    async def test_run_invalid(self):
+        client = make_client([Packet(Response.SEQUENCE, bytes([SeqOp.RUN, SeqResult.INVALID]) + struct.pack("<H", 18))])
+        assert await client.run_sequence() == (SeqResult.INVALID, 18)
+
+
+class TestProfiles:
+    async def test_profile_move(self):
+        client = make_client([Packet(Response.MOVE, b"\x00")])
+        assert await client.profile_move([ProfileRef(1, 4), ProfileRef(2, 4, reverse=True)], sync=True) is True
+        assert client._transport.sent[0].data == bytes([1, 1, 4, 0x82, 4])
+
+    async def test_read_follows_pages(self):
+        first = MotionProfile(0, 500, 1000, 200)
+        second = MotionProfile(40, 800, 3000, -100)
+        client = make_client([
+            Packet(Response.PROFILE_STORE, bytes([ProfileOp.READ, 17, 1]) + first.to_bytes()),
+            Packet(Response.PROFILE_STORE, bytes([ProfileOp.READ, 64, 1]) + second.to_bytes()),
+        ])
+        assert await client.read_profiles() == [first, second]
+        assert [p.data for p in client._transport.sent] == [bytes([ProfileOp.READ, 0]), bytes([ProfileOp.READ, 17])]
+
+    async def test_set_waits_for_erase(self):
+        # Сектор стирается 1-2 с: одна попытка с полным таймаутом, без ATTEMPT_TIMEOUT
+        client = make_client([Packet(Response.PROFILE_STORE, bytes([ProfileOp.SET, 0]))])
+        await client.set_profile(MotionProfile(3, 500, 1000, 200))
+        assert client._transport.timeouts == [PROFILE_WRITE_TIMEOUT]
+
+
+class TestCompactMove:
+    async def test_resends_full_after_mcu_reset(self):
+        params = [MotorParams(number=1, acceleration=500, max_speed=1000, steps=100)]
+        client = make_client([Packet(Response.MOVE, b"\x00"), nak(ErrorCode.MOTOR_PARAM_ERROR), Packet(Response.MOVE, b"\x00")])
+        assert await client.compact_move(params) is True
+        assert await client.compact_move(params) is True
+
+        sent = [p.data for p in client._transport.sent]
+        assert sent[1] == b"\x00\x00"
+        assert sent[2] == sent[0]
+
+    async def test_resends_when_cached_steps_lost(self):
+        # MCU сброшен: шаги не изменились и опущены, а в кэше MCU их нет -
+        # ENCODING вместо движения на 0 шагов
+        first = [MotorParams(number=1, acceleration=500, max_speed=1000, steps=100)]
+        faster = [MotorParams(number=1, acceleration=800, max_speed=2000, steps=100)]
+        encoding = Packet(Response.ERROR, bytes([ErrorCode.MOTOR_PARAM_ERROR, ParamFault.ENCODING, 0]))
+        client = make_client([Packet(Response.MOVE, b"\x00"), encoding, Packet(Response.MOVE, b"\x00")])
+        assert await client.compact_move(first) is True
+        assert await client.compact_move(faster) is True
+
+        sent = [p.data for p in client._transport.sent]
+        assert sent[1] == b"\x00\x03\xa0\x06\xd0\x0f"
+        assert sent[2] == b"\x00" + CompactEncoder().encode(faster)
+
+    async def test_lost_reply_sends_full_fields(self):
+        # Ответ на второй кадр потерян: MCU мог принять его шаги в кэш
+        first = [MotorParams(number=1, acceleration=500, max_speed=1000, steps=100)]
+        second = [MotorParams(number=1, acceleration=500, max_speed=1000, steps=-100)]
+        client = make_client([Packet(Response.MOVE, b"\x00"), TimeoutError("lost"), Packet(Response.MOVE, b"\x00")])
+        assert await client.compact_move(first) is True
+        with pytest.raises(TimeoutError):
+            await client.compact_move(second)
+        assert await client.compact_move(second) is True
+
+        sent = [p.data for p in client._transport.sent]
+        assert sent[1] == b"\x00\x04\xc7\x01"
+        assert sent[2] == b"\x00" + CompactEncoder().encode(second)
+
+
+class TestLinearMove:
+    async def test_frame(self):
+        client = make_client([Packet(Response.MOVE, b"\x00")])
+        assert await client.linear_move([LinearAxis(1, 6400), LinearAxis(2, -3200)], 1000, 4000) is True
+        sent = client._transport.sent[0]
+        assert sent.command == Command.LINEAR_MOVE
+        assert sent.data == struct.pack("<BIIBiBi", 1, 1000, 4000, 1, 6400, 2, -3200)
+
+    async def test_path_fault(self):
+        client = make_client([Packet(Response.ERROR, bytes([ErrorCode.MOTOR_PARAM_ERROR, ParamFault.PATH, 0]))])
+        with pytest.raises(ProtocolError) as exc_info:
+            await client.linear_move([LinearAxis(1, 100)], 0, 4000)
+        assert exc_info.value.fault == ParamFault.PATH
+
+
+class TestSegmentMove:
+    async def test_report(self):
+        report = struct.pack("<BBBIII", 0, 2, 1, 1264, 894, 901)
+        client = make_client([Packet(Response.SEGMENT_MOVE, report)])
+        r = await client.segment_move(3, [Segment(2000, 1000, 200), Segment(2000, 1000, 200)])
+        assert (r.commands, r.saved_ms) == (1, 370)
+        sent = client._transport.sent[0]
+        assert sent.command == Command.SEGMENT_MOVE
+        assert sent.data == bytes([3]) + struct.pack("<IIi", 2000, 1000, 200) * 2
+
+
+class TestVelocity:
+    async def test_start(self):
+        client = make_client([Packet(Response.VELOCITY, bytes([VelocityOp.START, VelocityResult.UNSUPPORTED]))])
+        assert await client.velocity_start(2000, 50, 20000) == VelocityResult.UNSUPPORTED
+        assert client._transport.sent[0].data == bytes([VelocityOp.START]) + struct.pack("<HHI", 2000, 50, 20000)
+
+    async def test_set_does_not_wait(self):
+        client = make_client([])
+        await client.velocity_set(3, {9: -100})
+        sent = client._transport.sent[0]
+        assert sent.command == Command.VELOCITY_SET
+        assert sent.data == bytes([3]) + struct.pack("<Hi", 0x100, -100)
+        assert client._transport.timeouts == []
+
+    async def test_stats(self):
+        stats = bytes([VelocityOp.STATS, VelocityResult.OK, StreamState.STOPPING]) + struct.pack(
+            "<IIIHIIIIBBBB", 500, 0, 1, 0, 2004, 35, 6, 0, 0, 0, 0, 1) + struct.pack("<Bi", 9, 1200)
+        client = make_client([Packet(Response.VELOCITY, stats)])
+        s = await client.velocity_stats()
+        assert s.state == StreamState.STOPPING
+        assert (s.frames, s.lost, s.velocities) == (500, 1, {9: 1200})
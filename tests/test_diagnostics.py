@@ -0,0 +1,117 @@
+import struct
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid.diagnostics import (
+    MemoryStats, STATS_SIZE, BootInfo, BOOT_INFO_SIZE, LinkStats, LINK_STATS_SIZE, PROFILE_SECTIONS, parse_profile,
+    PcHistogram, parse_sample_header,
+)
+
+
+def stats_payload():
+    return struct.pack("<IIIIIHHHHIIII", 1024, 312, 2900, 0, 0, 276, 1048, 256, 880, 1290, 170, 210, 415)
+
+
+class TestMemoryStats:
+    def test_size_matches_firmware(self):
+        assert STATS_SIZE == 44
+
+    def test_parse(self):
+        stats = MemoryStats.from_bytes(stats_payload())
+        assert stats.stack_size == 1024
+        assert stats.stack_high_water == 312
+        assert stats.stack_headroom == 712
+        assert stats.static_ram == 2900
+        assert stats.uart_dma_size == 1048
+        assert stats.motor_driver_size == 880
+        assert stats.crc_cycles == 170
+        assert (stats.shift_refresh_cycles, stats.shift_refresh_max_cycles) == (210, 415)
+
+    def test_short_response(self):
+        with pytest.raises(ValueError):
+            MemoryStats.from_bytes(stats_payload()[:20])
+
+
+
+class TestLinkStats:
+    def test_size_matches_firmware(self):
+        assert LINK_STATS_SIZE == 64
+
+    def test_clean_link(self):
+        stats = LinkStats.from_bytes(struct.pack("<16I", 115200, *([0] * 9), 500, 0, 0, 0, 0, 2))
+        assert stats.baudrate == 115200
+        assert stats.accepted_frames == 500
+        assert stats.resynced_frames == 2
+        assert stats.is_clean
+
+    def test_errors(self):
+        stats = LinkStats.from_bytes(struct.pack("<16I", 115200, 3, 1, 0, 0, 0, 0, 0, 1, 0, 10, 0, 2, 0, 1, 0))
+        assert stats.hardware_errors == 5
+        assert stats.rejected_frames == 3
+        assert not stats.is_clean
+
+    def test_short_response(self):
+        with pytest.raises(ValueError):
+            LinkStats.from_bytes(bytes(60))
+
+
+class TestBootInfo:
+    def test_size_matches_firmware(self):
+        assert BOOT_INFO_SIZE == 13
+
+    def test_parse(self):
+        info = BootInfo.from_bytes(struct.pack("<IIIB", 310, 2150, 812000, 0x24))
+        assert info.rx_armed_us == 310
+        assert info.ready_us == 2150
+        assert info.first_rx_us == 812000
+        assert info.reset_causes == ["independent watchdog", "pin"]
+
+    def test_short_response(self):
+        with pytest.raises(ValueError):
+            BootInfo.from_bytes(b"\x00" * 12)
+
+
+class TestProfile:
+    def test_parse(self):
+        data = bytes([2])
+        data += struct.pack("<IIIQ", 4, 90, 160, 480)
+        data += struct.pack("<IIIQ", 0, 0, 0, 0)
+        entries = parse_profile(data)
+
+        assert [e.name for e in entries] == list(PROFILE_SECTIONS[:2])
+        assert entries[0].avg_cycles == 120
+        assert entries[1].avg_cycles == 0
+
+    def test_total_is_64_bit(self):
+        data = bytes([1]) + struct.pack("<IIIQ", 1, 1, 1, 1 << 40)
+        assert parse_profile(data)[0].total_cycles == 1 << 40
+
+    def test_full_table_fits_packet(self):
+        assert 1 + len(PROFILE_SECTIONS) * 20 <= 256 - 4 - 4
+
+    def test_truncated(self):
+        with pytest.raises(ValueError):
+            parse_profile(bytes([3]) + b"\x00" * 20)
+
+
+def sample_page(pairs, next_index, total=100, outside=2):
+    header = struct.pack("<IBHIIH", 0x08000000, 5, 2048, total, outside, next_index)
+    return header + b"".join(struct.pack("<HH", i, n) for i, n in pairs)
+
+
+class TestPcHistogram:
+    def test_header(self):
+        assert parse_sample_header(sample_page([], 2048)) == (0x08000000, 5, 2048, 100, 2, 2048)
+
+    def test_merge_pages(self):
+        histogram = PcHistogram.from_pages([
+            sample_page([(3, 40), (7, 8)], 9),
+            sample_page([(9, 50)], 2048),
+        ])
+        assert histogram.buckets == {3: 40, 7: 8, 9: 50}
+        assert histogram.bucket_address(9) == 0x08000000 + 9 * 32
+        assert histogram.out_of_range == 2
@@ -0,0 +1,95 @@
+import struct
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid.logfmt import (
+    LOG_TEXT_ID, LogRecord, format_message, format_records, load_formats,
+    parse_format_table, parse_log_page, read_elf_section,
+)
+
+FORMATS = b"rx NAK 0x%02x\0safety timeout, pending 0x%03x\0"
+
+
+def make_elf(sections):
+    """ELF32 LE только с таблицей секций: [(имя, содержимое)]."""
+    names = b"\0" + b"".join(name.encode() + b"\0" for name, _ in sections) + b".shstrtab\0"
+    body = b"".join(data for _, data in sections) + names
+    shoff = 52 + len(body)
+
+    headers = [bytes(40)]
+    offset, name_offset = 52, 1
+    for name, data in sections + [(".shstrtab", names)]:
+        headers.append(struct.pack("<IIIIIIIIII", name_offset, 1, 0, 0, offset, len(data), 0, 0, 1, 0))
+        offset += len(data)
+        name_offset += len(name) + 1
+
+    ident = b"\x7fELF\x01\x01\x01" + bytes(9)
+    header = ident + struct.pack("<HHIIIIIHHHHHH", 2, 40, 1, 0, 0, shoff, 0, 52, 0, 0, 40,
+                                 len(headers), len(headers) - 1)
+    return header + body + b"".join(headers)
+
+
+def page(records, dropped=0):
+    data = struct.pack("<HB", dropped, len(records))
+    for ticks, fid, payload in records:
+        if fid == LOG_TEXT_ID:
+            data += struct.pack("<IHB", ticks, fid, len(payload)) + payload
+        else:
+            data += struct.pack("<IHB", ticks, fid, len(payload)) + struct.pack(f"<{len(payload)}I", *payload)
+    return data
+
+
+class TestElf:
+    def test_format_table_from_elf(self, tmp_path):
+        elf = tmp_path / "main.elf"
+        elf.write_bytes(make_elf([(".text", b"\x00" * 8), (".log_fmt", FORMATS)]))
+        assert load_formats(str(elf)) == {0: "rx NAK 0x%02x", 14: "safety timeout, pending 0x%03x"}
+
+    def test_missing_section(self):
+        with pytest.raises(ValueError):
+            read_elf_section(make_elf([(".text", b"")]), ".log_fmt")
+
+    def test_not_elf(self):
+        with pytest.raises(ValueError):
+            read_elf_section(b"MZ" + bytes(60), ".log_fmt")
+
+
+class TestFormat:
+    def test_signed_and_hex(self):
+        assert format_message("pos %d, mask 0x%04X", [0xFFFFFFFE, 0x3FF]) == "pos -2, mask 0x03FF"
+
+    def test_length_modifiers_and_percent(self):
+        assert format_message("%lu%% %c", [50, ord("x")]) == "50% x"
+
+    def test_missing_args(self):
+        assert format_message("%u %u", [1]) == "1 0"
+
+
+class TestRecords:
+    def test_parse_page(self):
+        parsed = parse_log_page(page([(10, 0, [3]), (11, LOG_TEXT_ID, b"hi\n")], dropped=4))
+        assert parsed.dropped == 4
+        assert parsed.records == [LogRecord(10, 0, [3]), LogRecord(11, LOG_TEXT_ID, [], b"hi\n")]
+
+    def test_truncated(self):
+        with pytest.raises(ValueError):
+            parse_log_page(page([(10, 0, [3])])[:-1])
+
+    def test_text_joined_to_lines(self):
+        formats = parse_format_table(FORMATS)
+        records = [
+            LogRecord(5, LOG_TEXT_ID, [], b"HardFault at 0x0800"),
+            LogRecord(5, LOG_TEXT_ID, [], b"1234\nr0 "),
+            LogRecord(7, 14, [0x005]),
+            LogRecord(9, 99, [1]),
+        ]
+        assert format_records(records, formats) == [
+            (5, "HardFault at 0x08001234"),
+            (7, "safety timeout, pending 0x005"),
+            (9, "<fmt 0x0063> 0x00000001"),
+            (5, "r0 "),
+        ]
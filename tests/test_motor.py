@@ -1,11 +1,18 @@
 import sys
 from pathlib import Path
 
+import math
+import struct
+
 import pytest
 
 sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
 
-from squid.motor import MotorParams
+from squid.motor import (
+    MotorParams, Telemetry, WaitEvent, pack_mask, telemetry_layout,
+    ProfileRef, MotionProfile, parse_profile_page, CompactEncoder, zigzag,
+    LinearAxis, plan_linear, linear_path_length,
+)
 
 
 class TestMotorParamsToBytes:
@@ -47,3 +54,106 @@ class TestMotorParamsRoundtrip:
         assert restored.acceleration == original.acceleration
         assert restored.max_speed == original.max_speed
         assert restored.steps == original.steps
+
+
+class TestMaskWidth:
+    def test_pack_minimal_width(self):
+        assert pack_mask(0x3FF) == b"\xff\x03"
+        assert pack_mask(1 << 20) == struct.pack("<I", 1 << 20)
+        assert len(pack_mask(1 << 40)) == 8
+
+    def test_telemetry_layout(self):
+        assert telemetry_layout(34) == (2, 10)
+        assert telemetry_layout(8 + 12 + 64) == (4, 32)
+        assert telemetry_layout(8 + 24 + 128) == (8, 64)
+        with pytest.raises(ValueError):
+            telemetry_layout(35)
+
+    def test_telemetry_32_motors(self):
+        data = struct.pack("<HIIIIH32H", 1, 500, 0xFFFF0000, 0x00010000, 0, 0, *range(32))
+        frame = Telemetry.from_bytes(data)
+        assert frame.active == 0xFFFF0000
+        assert frame.elapsed_ms[31] == 31
+
+    def test_wait_event_wide_masks(self):
+        event = WaitEvent.from_bytes(struct.pack("<BIIII", 0, 1 << 20, 0, 1 << 20, 1 << 20))
+        assert event.fired == 1 << 20
+
+
+class TestMotionProfiles:
+    def test_ref_bytes(self):
+        assert ProfileRef(3, 7).to_bytes() == b"\x03\x07"
+        assert ProfileRef(3, 7, reverse=True).to_bytes() == b"\x83\x07"
+
+    def test_ref_out_of_range(self):
+        with pytest.raises(ValueError):
+            ProfileRef(1, 64).to_bytes()
+
+    def test_page(self):
+        profile = MotionProfile(5, 500, 2000, -6400)
+        next_id, profiles = parse_profile_page(bytes([64, 1]) + profile.to_bytes())
+        assert next_id == 64
+        assert profiles == [profile]
+
+    def test_page_truncated(self):
+        with pytest.raises(ValueError):
+            parse_profile_page(bytes([64, 2]) + MotionProfile(5, 500, 2000, 100).to_bytes())
+
+
+class TestCompactEncoding:
+    @pytest.mark.parametrize("value,encoded", [(0, 0), (-1, 1), (1, 2), (-2, 3), (2**31 - 1, 2**32 - 2), (-2**31, 2**32 - 1)])
+    def test_zigzag(self, value, encoded):
+        assert zigzag(value) == encoded
+
+    def test_first_move_has_all_fields(self):
+        data = CompactEncoder().encode([MotorParams(number=1, acceleration=500, max_speed=1000, steps=5000)])
+        # header 0x07, 500, 1000, zigzag(5000) = 10000 - по 2 байта
+        assert data == b"\x07\xf4\x03\xe8\x07\x90\x4e"
+
+    def test_cached_fields_omitted(self):
+        encoder = CompactEncoder()
+        first = [MotorParams(number=m, acceleration=500, max_speed=1000, steps=5000) for m in range(1, 11)]
+        encoder.commit(first)
+
+        repeat = [MotorParams(number=m, acceleration=500, max_speed=1000, steps=-5000) for m in range(1, 11)]
+        data = encoder.encode(repeat)
+        # 10 моторов: header + шаги, 3 байта вместо 16
+        assert len(data) == 30
+        assert data[:3] == bytes([0x04]) + b"\x8f\x4e"
+
+    def test_high_motor_header(self):
+        data = CompactEncoder().encode([MotorParams(number=20, acceleration=1, max_speed=1, steps=0)])
+        # (20 - 1) << 3 | 7 = 159 - varint в 2 байта
+        assert data[:2] == b"\x9f\x01"
+
+
+def _trapezoid_time(steps: int, accel: int, speed: int) -> float:
+    if steps * accel >= speed * speed:
+        return steps / speed + speed / accel
+    return 2 * math.sqrt(steps / accel)
+
+
+class TestLinearPlanner:
+    def test_matches_firmware(self):
+        # Значения LinearPlanner::plan() для тех же осей
+        axes = [LinearAxis(1, 6400), LinearAxis(2, -3200), LinearAxis(3, 100)]
+        plan = plan_linear(axes, 1000, 4000)
+        assert [(m.acceleration, m.max_speed) for m in plan] == [(894, 3577), (447, 1789), (14, 56)]
+        assert plan[1].steps == (-3200) & 0xFFFFFFFF
+
+    def test_axes_finish_together(self):
+        axes = [LinearAxis(1, 20000), LinearAxis(2, 7000), LinearAxis(3, -1500)]
+        times = [_trapezoid_time(abs(a.steps), m.acceleration, m.max_speed)
+                 for a, m in zip(axes, plan_linear(axes, 5000, 8000))]
+        assert max(times) - min(times) < 0.001 * max(times)
+
+    def test_long_path_keeps_precision(self):
+        axes = [LinearAxis(1, 2**31 - 1), LinearAxis(2, -(2**31)), LinearAxis(3, 1)]
+        assert linear_path_length(axes) >= 2**31
+        plan = plan_linear(axes, 2**32 - 1, 2**32 - 1)
+        assert plan[2].acceleration == 1 and plan[2].max_speed == 1
+
+    def test_zero_axis_gets_path_params(self):
+        plan = plan_linear([LinearAxis(1, 0), LinearAxis(2, 300)], 100, 200)
+        assert (plan[0].acceleration, plan[0].max_speed) == (100, 200)
+        assert (plan[1].acceleration, plan[1].max_speed) == (100, 200)
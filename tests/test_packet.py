@@ -5,7 +5,7 @@ import pytest
 
 sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
 
-from squid.packet import Packet, calculate_xor
+from squid.packet import Packet, calculate_xor, calculate_crc32, cobs_encode, cobs_decode
 from squid.protocol import PROTOCOL_STX, Command, Response
 
 
@@ -95,3 +95,106 @@ class TestPacketRoundtrip:
 
         assert restored.command == original.command
         assert restored.data == original.data
+
+
+class TestCobs:
+    def test_no_zeros(self):
+        assert cobs_encode(b"\x11\x22\x33") == b"\x04\x11\x22\x33"
+
+    def test_zeros(self):
+        assert cobs_encode(b"\x11\x00\x00\x22") == b"\x02\x11\x01\x02\x22"
+
+    def test_encoded_has_no_zeros(self):
+        data = bytes(range(256)) * 2
+        assert 0 not in cobs_encode(data)
+
+    def test_roundtrip(self):
+        for data in [b"", b"\x00", b"\x00\x00", bytes(range(1, 255)), bytes(range(256)), b"\x01" * 254 + b"\x00"]:
+            assert cobs_decode(cobs_encode(data)) == data
+
+    def test_overhead_bound(self):
+        data = b"\x01" * 255
+        assert len(cobs_encode(data)) <= len(data) + len(data) // 254 + 1
+
+    def test_truncated_block(self):
+        with pytest.raises(ValueError, match="COBS"):
+            cobs_decode(b"\x05\x11\x22")
+
+
+class TestPacketCobs:
+    def test_version_frame(self):
+        raw = Packet(Command.VERSION).to_cobs()
+
+        assert raw[-1] == 0x00
+        assert 0x00 not in raw[:-1]
+        assert cobs_decode(raw[:-1]) == bytes([0x00, 0x05, Command.VERSION, 0x04])
+
+    def test_roundtrip(self):
+        original = Packet(Command.SYNC_MOVE, b"\x02\x00\x00\x00" * 4)
+        restored = Packet.from_cobs(original.to_cobs())
+
+        assert restored.command == original.command
+        assert restored.data == original.data
+
+    def test_invalid_xor(self):
+        raw = bytearray(Packet(Command.STATUS, b"\x01").to_bytes())
+        raw[-1] ^= 0xFF
+        with pytest.raises(ValueError, match="XOR mismatch"):
+            Packet.from_cobs(cobs_encode(bytes(raw[1:])) + b"\x00")
+
+
+def crc32_reference(data: bytes) -> int:
+    """Побитовая модель аппаратного блока CRC: слово целиком, старшим битом вперед."""
+    crc = 0xFFFFFFFF
+    padded = data + bytes(-len(data) % 4)
+    for i in range(0, len(padded), 4):
+        crc ^= int.from_bytes(padded[i:i + 4], "little")
+        for _ in range(32):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+class TestCalculateCrc32:
+    def test_stm32_known_word(self):
+        assert calculate_crc32(bytes.fromhex("78563412")) == 0xDF8A8A2B
+
+    def test_matches_reference(self):
+        for length in range(0, 40):
+            data = bytes((i * 37 + length) & 0xFF for i in range(length))
+            assert calculate_crc32(data) == crc32_reference(data)
+
+    def test_detects_double_bit_flip(self):
+        data = bytearray(b"\x10\x20\x30\x40")
+        corrupted = bytearray(data)
+        corrupted[0] ^= 0x01
+        corrupted[1] ^= 0x01
+        assert calculate_xor(data) ^ calculate_xor(corrupted) == 0
+        assert calculate_crc32(bytes(data)) != calculate_crc32(bytes(corrupted))
+
+
+class TestPacketCrc:
+    def test_version_frame(self):
+        raw = Packet(Command.VERSION).to_bytes(crc=True)
+
+        assert len(raw) == 8
+        assert raw[1:3] == b"\x00\x08"
+        assert int.from_bytes(raw[4:], "little") == calculate_crc32(raw[1:4])
+
+    def test_roundtrip(self):
+        original = Packet(Command.SYNC_MOVE, b"\x01\x00\x00\x00" * 4)
+        restored = Packet.from_bytes(original.to_bytes(crc=True), crc=True)
+
+        assert restored.command == original.command
+        assert restored.data == original.data
+
+    def test_cobs_roundtrip(self):
+        original = Packet(Command.STATUS, b"\x00\x02")
+        restored = Packet.from_cobs(original.to_cobs(crc=True), crc=True)
+        assert restored.data == original.data
+
+    def test_invalid_crc(self):
+        raw = bytearray(Packet(Command.STATUS, b"\x01").to_bytes(crc=True))
+        raw[-1] ^= 0x80
+        with pytest.raises(ValueError, match="CRC mismatch"):
+            Packet.from_bytes(bytes(raw), crc=True)
@@ -0,0 +1,82 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid.protocol import MoveResult
+from squid.segments import Segment, SegmentReport, plan_segments, trapezoid_ms, SEGMENT_LOOKAHEAD
+
+
+def _signed(steps: int) -> int:
+    return steps - (1 << 32) if steps >= (1 << 31) else steps
+
+
+# Записанные цепочки: подача короткими шагами, растр с разворотами,
+# смешанная - оценка времени до и после слияния (эмуляция SegmentPlanner)
+JOG = [Segment(2000, 1000, 200)] * 10
+RASTER = [Segment(4000, 3000, 1200 if i % 2 == 0 else -1200) for i in range(12)]
+MIXED = JOG + [
+    Segment(4000, 3000, -1500), Segment(4000, 3000, -1500), Segment(500, 200, -50),
+    Segment(4000, 3000, 20000), Segment(100, 100, 30),
+]
+
+
+class TestTrapezoid:
+    def test_cruise(self):
+        # 5000 / 1000 + 1000 / 500 = 7 с
+        assert trapezoid_ms(5000, 500, 1000) == 7000
+
+    def test_triangle(self):
+        # Скорость не достигнута: 2 * sqrt(200 / 2000) = 632 мс
+        assert trapezoid_ms(200, 2000, 1000) == 632
+
+
+class TestSegmentPlan:
+    def test_matches_firmware(self):
+        # Значения SegmentPlanner::plan() для той же цепочки
+        plan = plan_segments(1, MIXED)
+        assert [(c.acceleration, c.max_speed, _signed(c.steps)) for c in plan.commands] == [
+            (2000, 1000, 1600), (2000, 1000, 400), (4000, 3000, -3000),
+            (500, 200, -50), (4000, 3000, 20000), (100, 100, 30),
+        ]
+        assert (plan.standalone_ms, plan.planned_ms) == (17911, 13887)
+
+    def test_jog_merges_within_window(self):
+        plan = plan_segments(1, JOG)
+        assert len(plan.commands) == 2
+        assert _signed(plan.commands[0].steps) == 200 * SEGMENT_LOOKAHEAD
+        assert plan.planned_ms < plan.standalone_ms / 2
+
+    def test_raster_keeps_reversals(self):
+        plan = plan_segments(1, RASTER)
+        assert len(plan.commands) == len(RASTER)
+        assert plan.planned_ms == plan.standalone_ms
+
+    def test_slow_segment_not_merged_into_fast(self):
+        plan = plan_segments(1, [Segment(4000, 3000, 20000), Segment(100, 100, 30)])
+        assert len(plan.commands) == 2
+
+    def test_zero_steps_skipped(self):
+        plan = plan_segments(2, [Segment(2000, 1000, 200), Segment(2000, 1000, 0), Segment(2000, 1000, 200)])
+        assert len(plan.commands) == 1
+        assert plan.commands[0].number == 2
+
+    def test_bad_segment(self):
+        with pytest.raises(ValueError):
+            plan_segments(1, [Segment(0, 1000, 200)])
+
+
+class TestSegmentReport:
+    def test_parse(self):
+        data = bytes([MoveResult.SUCCESS, 15, 6]) + (17911).to_bytes(4, "little") \
+            + (13887).to_bytes(4, "little") + (14020).to_bytes(4, "little")
+        r = SegmentReport.from_bytes(data)
+        assert (r.result, r.segments, r.commands) == (MoveResult.SUCCESS, 15, 6)
+        assert r.saved_ms == 4024
+        assert r.elapsed_ms == 14020
+
+    def test_too_short(self):
+        with pytest.raises(ValueError):
+            SegmentReport.from_bytes(b"\x00\x01")
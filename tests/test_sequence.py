@@ -0,0 +1,89 @@
+import struct
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid.motor import MotorParams
+from squid.protocol import SeqOpcode, SeqResult, SeqState
+from squid.packet import decode_varint, encode_varint
+from squid.sequence import Program, SequenceStatus, assemble
+
+
+class TestVarint:
+    @pytest.mark.parametrize("value,encoded", [
+        (0, b"\x00"),
+        (127, b"\x7f"),
+        (128, b"\x80\x01"),
+        (300, b"\xac\x02"),
+        (1 << 63, b"\x80" * 9 + b"\x01"),
+    ])
+    def test_round_trip(self, value, encoded):
+        assert encode_varint(value) == encoded
+        assert decode_varint(encoded) == (value, len(encoded))
+
+    def test_truncated(self):
+        with pytest.raises(ValueError):
+            decode_varint(b"\x80\x80")
+
+    def test_out_of_range(self):
+        with pytest.raises(ValueError):
+            encode_varint(-1)
+
+
+class TestProgram:
+    def test_builder(self):
+        motor = MotorParams(number=1, acceleration=500, max_speed=1000, steps=200)
+        code = Program().loop(3).move([motor]).wait().delay(250).end_loop().end().to_bytes()
+
+        assert code == (
+            bytes([SeqOpcode.LOOP, 3, SeqOpcode.MOVE, 1]) + motor.to_bytes()
+            + bytes([SeqOpcode.WAIT, 0, SeqOpcode.DELAY]) + b"\xfa\x01"
+            + bytes([SeqOpcode.END_LOOP, SeqOpcode.END])
+        )
+
+    def test_assemble_matches_builder(self):
+        text = """
+            # качание двух моторов до концевика
+            loop
+              move 1:500:2000:6400 2:500:1000:3200
+              wait 0x3
+              wait_input 2 1
+            end_loop
+        """
+        expected = (
+            Program().loop()
+            .move([MotorParams(1, 500, 2000, 6400), MotorParams(2, 500, 1000, 3200)])
+            .wait(0x3).wait_input(2, 1).end_loop().to_bytes()
+        )
+        assert assemble(text) == expected
+
+    def test_unclosed_loop(self):
+        with pytest.raises(ValueError):
+            Program().loop(2).to_bytes()
+
+    def test_loop_depth(self):
+        program = Program().loop().loop().loop().loop()
+        with pytest.raises(ValueError):
+            program.loop()
+
+    def test_assemble_reports_line(self):
+        with pytest.raises(ValueError, match="line 2"):
+            assemble("delay 10\njump 0\n")
+
+
+class TestStatus:
+    def test_parse(self):
+        data = struct.pack("<BBHHIIHIHIHII", 1, 0, 18, 40, 7, 1200, 18, 35, 2, 400, 2, 410, 2)
+        status = SequenceStatus.from_bytes(data)
+
+        assert status.state == SeqState.RUNNING
+        assert status.reason == SeqResult.OK
+        assert status.max_ms == 410
+        assert status.loop_remaining == 2
+
+    def test_truncated(self):
+        with pytest.raises(ValueError):
+            SequenceStatus.from_bytes(b"\x00" * 20)
@@ -0,0 +1,92 @@
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid.step_ramp import (
+    ramp_periods, step_timing, timer_divider, ideal_seconds, STEP_MAX_RATE_HZ, STEP_PULSE_TICKS, TIMER_HZ,
+)
+
+
+def _periods(steps, accel, speed, timer_hz=TIMER_HZ):
+    return [p for p, _ in ramp_periods(steps, accel, speed, timer_hz)]
+
+
+class TestStepRamp:
+    # Значения StepRamp::fill(), собранного на хосте: шагов, сумма тактов, первые периоды
+    @pytest.mark.parametrize("steps,accel,speed,timer_hz,total,first", [
+        (100000, 200000, 100000, TIMER_HZ, 23966053, [34202, 20522, 15961, 13506, 11916, 10782, 9919, 9236]),
+        (20000, 50000, 150000, TIMER_HZ, 20165913, [41311, 32132, 27188, 23990, 21705, 19968, 18592, 17464]),
+        (300000, 400000, 150000, TIMER_HZ, 37976081, [24185, 14511, 11286, 9550, 8426, 7624, 7014, 6531]),
+        (5000, 500, 1000, TIMER_HZ // 3, 35628192, [61584, 57853, 54725, 52055, 49742, 47712, 45911, 44301]),
+        (7, 1000, 5000, TIMER_HZ, 444385, [64782, 63746, 62758, 61813, 62758, 63746, 64782]),
+    ])
+    def test_matches_firmware(self, steps, accel, speed, timer_hz, total, first):
+        periods = _periods(steps, accel, speed, timer_hz)
+        assert len(periods) == steps
+        assert sum(periods) == total
+        assert periods[:len(first)] == first
+
+    def test_first_period(self):
+        # c0 = 0.676 * f * sqrt(2 / a) = 34204 такта при a = 200000
+        assert _periods(10, 200000, 100000)[0] == pytest.approx(34204, abs=2)
+
+    def test_symmetric(self):
+        periods = _periods(10, 100000, 2000)
+        assert all(abs(a - b) <= 1 for a, b in zip(periods, reversed(periods)))
+
+    def test_slow_start_clamped_to_16_bits(self):
+        assert max(_periods(5000, 500, 1000)) <= 0xFFFF
+
+
+class TestStepTiming:
+    def test_100khz_cruise_exact(self):
+        # 16 МГц / 100 кГц = 160 тактов ровно: дрожания на крейсерском участке нет
+        t = step_timing(100000, 200000, 100000)
+        assert t.divider == 1
+        assert {p for p, c in zip(t.periods, t.cruise) if c} == {160}
+        assert t.cruise_jitter_ns == 0
+        assert t.max_rate_hz == 100000
+
+    def test_150khz_dithered(self):
+        # 106.67 такта: периоды 106 и 107, разброс один такт (62.5 нс), средняя частота точная
+        t = step_timing(300000, 400000, 150000)
+        assert {p for p, c in zip(t.periods, t.cruise) if c} == {106, 107}
+        assert t.cruise_jitter_ns == 62.5
+        assert t.cruise_rate_hz == pytest.approx(150000, rel=1e-6)
+
+    @pytest.mark.parametrize("steps,accel,speed", [
+        (100000, 200000, 100000), (300000, 400000, 150000), (20000, 50000, 150000),
+    ])
+    def test_time_matches_trapezoid(self, steps, accel, speed):
+        t = step_timing(steps, accel, speed)
+        assert t.seconds == pytest.approx(ideal_seconds(steps, accel, speed), rel=0.005)
+
+    def test_speed_clamped(self):
+        t = step_timing(100000, 1000000, 500000)
+        assert t.speed == STEP_MAX_RATE_HZ
+        assert min(t.periods) == TIMER_HZ // STEP_MAX_RATE_HZ
+        assert min(t.periods) > STEP_PULSE_TICKS
+
+    def test_slow_axis_uses_divider(self):
+        # a = 10: c0 ~ 4.8 млн тактов, делитель растягивает такт, крейсерский период >= 4096
+        assert timer_divider(200000, 100000) == 1
+        t = step_timing(1000, 10, 100)
+        assert t.divider == 39
+        assert max(t.periods) <= 0xFFFF
+        assert t.seconds == pytest.approx(ideal_seconds(1000, 10, 100), rel=0.1)
+
+    def test_reverse_and_empty(self):
+        assert step_timing(-300, 5000, 2000).steps == 300
+        assert step_timing(0, 5000, 2000).periods == []
+
+    def test_dma_interrupts(self):
+        # Два первых периода - в ARR, остальные кольцом по 64 на прерывание
+        assert step_timing(100000, 200000, 100000).dma_interrupts == 1563
+        assert step_timing(2, 1000, 1000).dma_interrupts == 1
+
+    def test_bad_params(self):
+        with pytest.raises(ValueError):
+            step_timing(100, 0, 1000)
@@ -0,0 +1,75 @@
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid.diagnostics import PcHistogram
+from squid.symbols import parse_map, parse_nm
+
+MAP = """\
+Discarded input sections
+
+ .text.unused   0x00000000       0x10 ./src/gpio.o
+
+Linker script and memory map
+
+.text           0x08000188     0x1000
+ *(.text*)
+ .text.main     0x08000188       0x60 ./src/main.o
+                0x08000188                main
+ .text._ZN7UartDma10sendPacketEPKht
+                0x080001e8       0x80 ./src/uart_dma.o
+                0x080001e8                UartDma::sendPacket(unsigned char const*, unsigned short)
+ .text._ZL17handleStopCommandv
+                0x08000268       0x20 ./src/motor_controller.o
+ *fill*         0x08000288        0x8 
+                0x08000290                . = ALIGN (0x4)
+
+.ARM.extab      0x08001188        0x0
+ .text.after    0x08002000       0x10 ./src/x.o
+"""
+
+NM = """\
+08000188 00000060 T main
+080001e8 00000080 T UartDma::sendPacket(unsigned char const*, unsigned short)
+08000268 00000020 t handleStopCommand()
+20000000 00000004 B systemTicks
+"""
+
+
+class TestMap:
+    def test_global_names_and_sizes(self):
+        table = parse_map(MAP)
+        assert table.lookup(0x08000190).name == "main"
+        symbol = table.lookup(0x08000200)
+        assert symbol.name.startswith("UartDma::sendPacket")
+        assert symbol.size == 0x80
+
+    def test_static_function_from_section_name(self):
+        name = parse_map(MAP).lookup(0x08000270).name
+        assert "handleStopCommand" in name
+
+    def test_ignores_discarded_and_other_sections(self):
+        table = parse_map(MAP)
+        assert table.lookup(0x08002004) is None
+        assert all(s.address for s in table._symbols)
+        assert len(table) == 3
+
+
+class TestNm:
+    def test_only_text_symbols(self):
+        table = parse_nm(NM)
+        assert len(table) == 3
+        assert table.lookup(0x08000270).name == "handleStopCommand()"
+        assert table.lookup(0x08000290) is None
+
+
+class TestAttribute:
+    def test_histogram_by_function(self):
+        histogram = PcHistogram(
+            base=0x08000000, shift=5, bucket_count=2048, total_samples=100,
+            out_of_range=4, buckets={0x188 >> 5: 10, 0x200 >> 5: 50, 0x220 >> 5: 36},
+        )
+        result = dict(parse_nm(NM).attribute(histogram))
+        assert result["UartDma::sendPacket(unsigned char const*, unsigned short)"] == 86
+        assert result["<outside .text>"] == 4
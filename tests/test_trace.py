@@ -0,0 +1,73 @@
+import struct
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid.trace import TraceEvent, TraceRecord, parse_trace_page, to_chrome_trace, unwrap_cycles
+
+CLOCK = 16_000_000
+
+
+def page(records, dropped=0):
+    data = struct.pack("<IHB", CLOCK, dropped, len(records))
+    return data + b"".join(struct.pack("<IHBB", *r) for r in records)
+
+
+def move_records(txn=1, base=0):
+    us = CLOCK // 1_000_000
+    return [
+        TraceRecord(base + 0 * us, txn, TraceEvent.FRAME_START, 0),
+        TraceRecord(base + 1500 * us, txn, TraceEvent.FRAME_COMPLETE, 0x11),
+        TraceRecord(base + 1600 * us, txn, TraceEvent.DISPATCH, 0x11),
+        TraceRecord(base + 1700 * us, txn, TraceEvent.DRIVER_TX_START, 3),
+        TraceRecord(base + 3000 * us, txn, TraceEvent.DRIVER_TX_END, 3),
+        TraceRecord(base + 3100 * us, txn, TraceEvent.RESPONSE, 0x90),
+        TraceRecord(base + 4000 * us, txn, TraceEvent.STATUS_RISE, 3),
+        TraceRecord(base + 90000 * us, txn, TraceEvent.STATUS_FALL, 3),
+    ]
+
+
+class TestParse:
+    def test_page(self):
+        parsed = parse_trace_page(page([(100, 7, 3, 0x11)], dropped=2))
+        assert parsed.clock_hz == CLOCK
+        assert parsed.dropped == 2
+        assert parsed.records == [TraceRecord(100, 7, TraceEvent.DISPATCH, 0x11)]
+
+    def test_truncated(self):
+        with pytest.raises(ValueError):
+            parse_trace_page(page([(1, 1, 1, 0)])[:-1])
+
+    def test_unwrap(self):
+        records = [TraceRecord(0xFFFFFF00, 1, TraceEvent.DISPATCH, 0), TraceRecord(0x100, 1, TraceEvent.RESPONSE, 0)]
+        assert unwrap_cycles(records) == [0xFFFFFF00, 0x100000100]
+
+
+class TestChrome:
+    def test_spans(self):
+        events = to_chrome_trace(move_records(), CLOCK)["traceEvents"]
+        spans = {(e["name"], e["tid"]): e for e in events if e["ph"] == "X"}
+
+        assert spans[("rx", "command")]["dur"] == pytest.approx(1500)
+        assert spans[("command", "command")]["dur"] == pytest.approx(1500)
+        assert spans[("command", "command")]["args"] == {"command": "0x11"}
+        assert spans[("bus", "motor 3")]["dur"] == pytest.approx(1300)
+        assert spans[("motion", "motor 3")]["ts"] == pytest.approx(4000)
+
+    def test_transactions_do_not_mix(self):
+        records = move_records(txn=1) + move_records(txn=2, base=CLOCK)
+        spans = [e for e in to_chrome_trace(records, CLOCK)["traceEvents"] if e["name"] == "motion"]
+        assert sorted(e["pid"] for e in spans) == [1, 2]
+        assert all(e["dur"] == pytest.approx(86000) for e in spans)
+
+    def test_shift_out_lane(self):
+        records = [
+            TraceRecord(1000, 0, TraceEvent.SHIFT_FLUSH, 8),
+            TraceRecord(1000 + CLOCK // 100_000, 0, TraceEvent.SHIFT_LATCH, 8),
+        ]
+        (span,) = to_chrome_trace(records, CLOCK)["traceEvents"]
+        assert span["tid"] == "shift_out"
+        assert span["dur"] == pytest.approx(10)
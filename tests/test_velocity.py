@@ -0,0 +1,55 @@
+import struct
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, str(Path(__file__).parent.parent / "scripts"))
+
+from squid.protocol import ErrorCode, ParamFault, StreamState
+from squid.velocity import VelocityStats, pack_velocity_frame, frame_rate_limit, STATS_FORMAT
+
+
+class TestVelocityFrame:
+    def test_two_axes(self):
+        # Моторы 9 и 10 (BOARD_STEP_DIR=0x300): значения по возрастанию номера
+        frame = pack_velocity_frame(7, {10: -1500, 9: 2500})
+        assert frame == bytes([7]) + struct.pack("<Hii", 0x300, 2500, -1500)
+
+    def test_heartbeat(self):
+        assert pack_velocity_frame(0x105, {}) == bytes([0x05, 0, 0])
+
+    def test_wide_mask(self):
+        # Мотор 20 не влезает в 2 байта: маска 4 байта, как у прошивки на 32 мотора
+        frame = pack_velocity_frame(0, {20: 100})
+        assert frame == bytes([0]) + struct.pack("<Ii", 1 << 19, 100)
+
+    def test_limits(self):
+        with pytest.raises(ValueError):
+            pack_velocity_frame(0, {1: 200001})
+        with pytest.raises(ValueError):
+            pack_velocity_frame(0, {0: 100})
+
+    def test_link_budget(self):
+        # 2 оси - кадр 16 байт: ~720 кадров/с на 115200, 1 ось - 12 байт, 960
+        assert frame_rate_limit(2) == pytest.approx(720)
+        assert frame_rate_limit(1) == pytest.approx(960)
+        assert frame_rate_limit(2, crc=True) == pytest.approx(115200 / 190)
+
+
+class TestVelocityStats:
+    def test_parse(self):
+        data = struct.pack(STATS_FORMAT, 1, 1000, 3, 2, 1, 2150, 1180, 42, 4, 0x05, 0x09, 1, 2) + \
+            struct.pack("<BiBi", 9, 2500, 10, -800)
+        s = VelocityStats.from_bytes(data)
+        assert s.state == StreamState.STREAMING
+        assert (s.frames, s.late, s.lost, s.watchdog_trips) == (1000, 3, 2, 1)
+        assert (s.last_interval_us, s.max_jitter_us, s.mean_jitter_us) == (2150, 1180, 42)
+        assert (s.rejected, s.last_error, s.last_fault, s.last_index) == (4, ErrorCode.MOTOR_PARAM_ERROR,
+                                                                          ParamFault.STREAM, 1)
+        assert s.velocities == {9: 2500, 10: -800}
+
+    def test_truncated(self):
+        data = struct.pack(STATS_FORMAT, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2) + struct.pack("<Bi", 9, 0)
+        with pytest.raises(ValueError):
+            VelocityStats.from_bytes(data)